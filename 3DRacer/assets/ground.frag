@@ -0,0 +1,17 @@
+#version 410
+
+in vec3 fragPosWorldSpace;
+in float fragIntensity;
+
+// Displacement of the checker pattern along z
+uniform float scrollOffset;
+
+out vec4 outColor;
+
+void main() {
+  // Tiles are unit squares centered on integer x and z
+  vec2 tile = floor(fragPosWorldSpace.xz - vec2(0.0, scrollOffset) + 0.5);
+  float gray = mod(tile.x + tile.y, 2.0) < 0.5 ? 0.75 : 0.25;
+
+  outColor = vec4(vec3(gray * fragIntensity), 1);
+}
@@ -0,0 +1,20 @@
+#version 410
+
+layout(location = 0) in vec3 inPosition;
+
+uniform mat4 modelMatrix;
+uniform mat4 viewMatrix;
+uniform mat4 projMatrix;
+
+out vec3 fragPosWorldSpace;
+out float fragIntensity;
+
+void main() {
+  vec4 posWorldSpace = modelMatrix * vec4(inPosition, 1);
+  vec4 posEyeSpace = viewMatrix * posWorldSpace;
+
+  fragPosWorldSpace = posWorldSpace.xyz;
+  fragIntensity = 1.0 - (-posEyeSpace.z / 100.0);
+
+  gl_Position = projMatrix * posEyeSpace;
+}
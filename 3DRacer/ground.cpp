@@ -1,8 +1,11 @@
 #include "ground.hpp"
 
-#include <cppitertools/itertools.hpp>
+#include <cmath>
 
 void Ground::initializeGL(GLuint program) {
+    terminateGL();
+    m_program = program;
+
     // Unit quad on the xz plane
     std::array<glm::vec3, 4> vertices{  glm::vec3(-0.5f, -0.2f,  0.5f), 
                                         glm::vec3(-0.5f, -0.2f, -0.5f),
@@ -20,7 +23,7 @@ void Ground::initializeGL(GLuint program) {
     abcg::glBindVertexArray(m_VAO);
     abcg::glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
 
-    const GLint posAttrib{abcg::glGetAttribLocation(program, "inPosition")};
+    const GLint posAttrib{abcg::glGetAttribLocation(m_program, "inPosition")};
     
     abcg::glEnableVertexAttribArray(posAttrib);
     abcg::glVertexAttribPointer(posAttrib, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
@@ -29,38 +32,27 @@ void Ground::initializeGL(GLuint program) {
     abcg::glBindVertexArray(0);
 
     // Save location of uniform variables
-    m_modelMatrixLoc = abcg::glGetUniformLocation(program, "modelMatrix");
-    m_colorLoc = abcg::glGetUniformLocation(program, "color");
+    m_modelMatrixLoc = abcg::glGetUniformLocation(m_program, "modelMatrix");
+    m_scrollOffsetLoc = abcg::glGetUniformLocation(m_program, "scrollOffset");
 
-    int index = 0;
+    // Stretch the quad over the 5 x 100 tiles of the track, from x = -2.5 to
+    // 2.5 and z = -100.5 to -0.5. The checker pattern is computed in the
+    // fragment shader from the world space position.
+    m_modelMatrix = glm::translate(glm::mat4{1.0f}, glm::vec3(0.0f, 0.0f, -50.5f));
+    m_modelMatrix = glm::scale(m_modelMatrix, glm::vec3(5.0f, 1.0f, 100.0f));
 
-    for (const auto z : iter::range(-100, 0)) {
-        for (const auto x : iter::range(-2, 3)) {
-            auto &position{m_tilesPositions.at(index)};
-            float &gray{m_tilesColors.at(index)};
-            position = glm::vec3(x, 0.0f, z);
-            if ((z + x) % 2 == 0) {
-                gray = 0.75f;
-            } else { gray = 0.25f;}
-            index += 1;
-        }
-    }
+    m_scrollOffset = 0.0f;
 }
 
 void Ground::paintGL() {
-    // Draw a grid of tiles centered on the xz plane
-    abcg::glBindVertexArray(m_VAO);
-    for (const auto index : iter::range(500)) {
-        auto &position{m_tilesPositions.at(index)};
-        float &gray{m_tilesColors.at(index)};
-        // Set model matrix
-        glm::mat4 model{1.0f};
-        model = glm::translate(model, position);
-        abcg::glUniformMatrix4fv(m_modelMatrixLoc, 1, GL_FALSE, &model[0][0]);
-        abcg::glUniform4f(m_colorLoc, gray, gray, gray, 1.0f);
+    abcg::glUseProgram(m_program);
+
+    abcg::glUniformMatrix4fv(m_modelMatrixLoc, 1, GL_FALSE, &m_modelMatrix[0][0]);
+    abcg::glUniform1f(m_scrollOffsetLoc, m_scrollOffset);
 
-        abcg::glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    }
+    // Draw the whole grid of tiles with a single quad
+    abcg::glBindVertexArray(m_VAO);
+    abcg::glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
     abcg::glBindVertexArray(0);
 }
 
@@ -70,13 +62,6 @@ void Ground::terminateGL() {
 }
 
 void Ground::update(float deltaTime) {
-    for (const auto index : iter::range(500)) {
-        auto &position{m_tilesPositions.at(index)};
-        
-        position.z += 10 * deltaTime;
-
-        if (position.z > 0.5f) {
-            position.z = -25.5f;
-        }
-    }
-}
\ No newline at end of file
+    // The pattern repeats every two tiles
+    m_scrollOffset = std::fmod(m_scrollOffset + 10 * deltaTime, 2.0f);
+}
@@ -21,11 +21,14 @@ class Ground {
         GLuint m_VBO{};
         GLuint m_program{};
 
-        std::array<glm::vec3, 500> m_tilesPositions;
-        std::array<float, 500> m_tilesColors;
-
         GLint m_modelMatrixLoc{};
-        GLint m_colorLoc{};
+        GLint m_scrollOffsetLoc{};
+
+        // Scales the unit quad to cover the whole track
+        glm::mat4 m_modelMatrix{1.0f};
+
+        // Scrolling of the checker pattern, wrapped to one period (two tiles)
+        float m_scrollOffset{};
 };
 
-#endif
\ No newline at end of file
+#endif
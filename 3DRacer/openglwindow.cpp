@@ -53,6 +53,8 @@ void OpenGLWindow::initializeGL() {
     // Create program
     m_program = createProgramFromFile(getAssetsPath() + "depth.vert",
                                         getAssetsPath() + "depth.frag");
+    m_groundProgram = createProgramFromFile(getAssetsPath() + "ground.vert",
+                                            getAssetsPath() + "ground.frag");
 
     // Load model
     m_player.loadObj(getAssetsPath() + "DeLorean_DMC-12_V2.obj");
@@ -60,29 +62,31 @@ void OpenGLWindow::initializeGL() {
 
     m_player.initializeGL(m_program);
     m_enemies.initializeGL(m_program);
-    m_ground.initializeGL(m_program);
+    m_ground.initializeGL(m_groundProgram);
 
     resizeGL(getWindowSettings().width, getWindowSettings().height);
 }
 
 void OpenGLWindow::paintGL() {
-    update();
+    updateState();
 
     // Clear color buffer and depth buffer
     abcg::glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     abcg::glViewport(0, 0, m_viewportWidth, m_viewportHeight);
 
-    abcg::glUseProgram(m_program);
-
-    // Get location of uniform variables (could be precomputed)
-    const GLint viewMatrixLoc{abcg::glGetUniformLocation(m_program, "viewMatrix")};
-    const GLint projMatrixLoc{abcg::glGetUniformLocation(m_program, "projMatrix")};
-
     // Set uniform variables for viewMatrix and projMatrix
     // These matrices are used for every scene object
-    abcg::glUniformMatrix4fv(viewMatrixLoc, 1, GL_FALSE, &m_camera.m_viewMatrix[0][0]);
-    abcg::glUniformMatrix4fv(projMatrixLoc, 1, GL_FALSE, &m_camera.m_projMatrix[0][0]);
+    for (const auto program : {m_program, m_groundProgram}) {
+        abcg::glUseProgram(program);
+
+        // Get location of uniform variables (could be precomputed)
+        const GLint viewMatrixLoc{abcg::glGetUniformLocation(program, "viewMatrix")};
+        const GLint projMatrixLoc{abcg::glGetUniformLocation(program, "projMatrix")};
+
+        abcg::glUniformMatrix4fv(viewMatrixLoc, 1, GL_FALSE, &m_camera.m_viewMatrix[0][0]);
+        abcg::glUniformMatrix4fv(projMatrixLoc, 1, GL_FALSE, &m_camera.m_projMatrix[0][0]);
+    }
 
     m_ground.paintGL();
     m_player.paintGL();
@@ -138,6 +142,7 @@ void OpenGLWindow::terminateGL() {
     m_enemies.terminateGL();
 
     abcg::glDeleteProgram(m_program);
+    abcg::glDeleteProgram(m_groundProgram);
     abcg::glDeleteBuffers(1, &m_EBO);
     abcg::glDeleteBuffers(1, &m_VBO);
     abcg::glDeleteVertexArrays(1, &m_VAO);
@@ -148,12 +153,12 @@ void OpenGLWindow::restart() {
     // reset score
     m_gameData.gameScore = 0;
 
-    m_ground.initializeGL(m_program);
+    m_ground.initializeGL(m_groundProgram);
     m_player.initializeGL(m_program);
     m_enemies.initializeGL(m_program);
 }
 
-void OpenGLWindow::update() {
+void OpenGLWindow::updateState() {
     const float deltaTime{static_cast<float>(getDeltaTime())};
 
     // increase score
@@ -27,6 +27,7 @@ class OpenGLWindow : public abcg::OpenGLWindow {
         GLuint m_VBO{};
         GLuint m_EBO{};
         GLuint m_program{};
+        GLuint m_groundProgram{};
 
         GameData m_gameData;
         Player m_player;
@@ -43,7 +44,7 @@ class OpenGLWindow : public abcg::OpenGLWindow {
         std::vector<Vertex> m_vertices;
         std::vector<GLuint> m_indices;
 
-        void update();
+        void updateState();
         void restart();
 };
 
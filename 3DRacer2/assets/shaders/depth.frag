@@ -0,0 +1,4 @@
+#version 410
+
+// Only depth is written in the pre-pass
+void main() {}
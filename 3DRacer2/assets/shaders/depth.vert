@@ -0,0 +1,12 @@
+#version 410
+
+layout(location = 0) in vec3 inPosition;
+
+uniform mat4 modelViewProjMatrix;
+
+// Must match texture.vert, as the main pass tests depth with GL_EQUAL
+invariant gl_Position;
+
+void main() {
+  gl_Position = modelViewProjMatrix * vec4(inPosition, 1.0);
+}
@@ -0,0 +1,13 @@
+#version 410
+
+layout(location = 0) in vec3 inPosition;
+
+// Per-instance attributes
+layout(location = 7) in mat4 inModelViewProjMatrix;
+
+// Must match instanced.vert, as the main pass tests depth with GL_EQUAL
+invariant gl_Position;
+
+void main() {
+  gl_Position = inModelViewProjMatrix * vec4(inPosition, 1.0);
+}
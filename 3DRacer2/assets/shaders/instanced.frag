@@ -0,0 +1,50 @@
+#version 410
+
+in vec3 fragN;
+in vec3 fragL;
+in vec3 fragV;
+in vec4 fragKd;
+
+// Light properties
+uniform vec4 Ia, Id, Is;
+
+// Material properties (Kd is per instance)
+uniform vec4 Ka, Ks;
+uniform float shininess;
+
+out vec4 outColor;
+
+// Blinn-Phong for no texture
+vec4 BlinnPhong(vec3 N, vec3 L, vec3 V) {
+  N = normalize(N);
+  L = normalize(L);
+
+  // Compute lambertian term
+  float lambertian = max(dot(N, L), 0.0);
+
+  // Compute specular term
+  float specular = 0.0;
+  if (lambertian > 0.0) {
+    V = normalize(V);
+    vec3 H = normalize(L + V);
+    float angle = max(dot(H, N), 0.0);
+    specular = pow(angle, shininess);
+  }
+
+  vec4 diffuseColor = fragKd * Id * lambertian;
+  vec4 specularColor = Ks * Is * specular;
+  vec4 ambientColor = Ka * Ia;
+
+  return ambientColor + diffuseColor + specularColor;
+}
+
+void main() {
+  vec4 color = BlinnPhong(fragN, fragL, fragV);
+
+  if (gl_FrontFacing) {
+    outColor = color;
+  } else {
+    float i = (color.r + color.g + color.b) / 3.0;
+    outColor = vec4(i, 0, 0, 1.0);
+  }
+}
@@ -0,0 +1,35 @@
+#version 410
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+
+// Per-instance attributes, precomputed by abcg::TransformBatch
+layout(location = 3) in mat4 inModelViewMatrix;
+layout(location = 7) in mat4 inModelViewProjMatrix;
+layout(location = 11) in mat3 inNormalMatrix;
+layout(location = 14) in vec4 inKd;
+
+uniform mat4 viewMatrix;
+
+uniform vec4 lightDirWorldSpace;
+
+// Must match the depth pre-pass shaders
+invariant gl_Position;
+
+out vec3 fragV;
+out vec3 fragL;
+out vec3 fragN;
+out vec4 fragKd;
+
+void main() {
+  vec3 P = (inModelViewMatrix * vec4(inPosition, 1.0)).xyz;
+  vec3 N = inNormalMatrix * inNormal;
+  vec3 L = -(viewMatrix * lightDirWorldSpace).xyz;
+
+  fragL = L;
+  fragV = -P;
+  fragN = N;
+  fragKd = inKd;
+
+  gl_Position = inModelViewProjMatrix * vec4(inPosition, 1.0);
+}
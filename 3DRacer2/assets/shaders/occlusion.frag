@@ -0,0 +1,6 @@
+#version 410
+
+out vec4 outColor;
+
+// Color writes are disabled while the boxes are drawn
+void main() { outColor = vec4(1.0); }
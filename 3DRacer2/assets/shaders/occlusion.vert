@@ -0,0 +1,15 @@
+#version 410
+
+// Unit cube corner in [0, 1]
+layout(location = 0) in vec3 inPosition;
+
+uniform mat4 viewProjMatrix;
+
+// World-space bounding box
+uniform vec3 boxMin;
+uniform vec3 boxMax;
+
+void main() {
+  vec3 P = mix(boxMin, boxMax, inPosition);
+  gl_Position = viewProjMatrix * vec4(P, 1.0);
+}
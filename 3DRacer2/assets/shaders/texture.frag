@@ -21,6 +21,14 @@ uniform sampler2D diffuseTex;
 // 0: triplanar; 1: cylindrical; 2: spherical; 3: from mesh
 uniform int mappingMode;
 
+// Point and spot lights binned per cluster (see abcg::ClusteredLights)
+uniform highp sampler2D lightTexture;
+uniform highp usampler2D clusterTexture;
+uniform highp usampler2D lightIndexTexture;
+uniform ivec3 clusterGrid;
+uniform vec2 clusterTileSize;
+uniform vec2 clusterDepthParams;
+
 out vec4 outColor;
 
 // Blinn-Phong reflection model
@@ -75,6 +83,59 @@ vec4 BlinnPhong_standard(vec3 N, vec3 L, vec3 V) {
   // return diffuseColor; //vec4((N + 1.0) / 2.0, 1.0); 
 }
 
+// Diffuse and specular terms of the clustered lights that reach P (view
+// space), evaluated only for the lights of the cluster of the fragment
+vec3 ClusteredLights(vec3 P, vec3 N, vec3 V, vec3 diffuse) {
+  N = normalize(N);
+  V = normalize(V);
+
+  ivec2 tile = ivec2(gl_FragCoord.xy / clusterTileSize);
+  int slice = int(log(-P.z) * clusterDepthParams.x + clusterDepthParams.y);
+  ivec3 cluster = clamp(ivec3(tile, slice), ivec3(0), clusterGrid - 1);
+  uvec2 list =
+      texelFetch(clusterTexture,
+                 ivec2(cluster.x + cluster.y * clusterGrid.x, cluster.z), 0)
+          .xy;
+
+  int indexWidth = textureSize(lightIndexTexture, 0).x;
+  vec3 color = vec3(0.0);
+  for (uint i = 0u; i < list.y; ++i) {
+    int k = int(list.x + i);
+    int light =
+        int(texelFetch(lightIndexTexture, ivec2(k % indexWidth, k / indexWidth),
+                       0)
+                .r);
+    vec4 positionRadius = texelFetch(lightTexture, ivec2(0, light), 0);
+    vec4 colorCosOuter = texelFetch(lightTexture, ivec2(1, light), 0);
+    vec4 directionCosInner = texelFetch(lightTexture, ivec2(2, light), 0);
+
+    vec3 L = positionRadius.xyz - P;
+    float dist = length(L);
+    L /= dist;
+
+    // Smooth falloff that reaches zero at the radius
+    float falloff = clamp(1.0 - pow(dist / positionRadius.w, 4.0), 0.0, 1.0);
+    float attenuation = falloff * falloff / (dist * dist + 1.0);
+
+    // Spot cone
+    if (colorCosOuter.w > -1.0) {
+      attenuation *= smoothstep(colorCosOuter.w, directionCosInner.w,
+                                dot(-L, directionCosInner.xyz));
+    }
+
+    float lambertian = max(dot(N, L), 0.0);
+    float specular = 0.0;
+    if (lambertian > 0.0) {
+      vec3 H = normalize(L + V);
+      specular = pow(max(dot(H, N), 0.0), shininess);
+    }
+
+    color += (diffuse * lambertian + Ks.rgb * specular) * colorCosOuter.rgb *
+             attenuation;
+  }
+  return color;
+}
+
 // Planar mapping
 vec2 PlanarMappingX(vec3 P) { return vec2(1.0 - P.z, P.y); }
 vec2 PlanarMappingY(vec3 P) { return vec2(P.x, 1.0 - P.z); }
@@ -106,6 +167,7 @@ vec2 SphericalMapping(vec3 P) {
 
 void main() {
   vec4 color;
+  vec4 map_Kd = vec4(1.0);
 
   if (mappingMode == 4) {
     color = BlinnPhong_standard(fragN, fragL, fragV);
@@ -129,6 +191,9 @@ void main() {
     // Compute average based on normal
     vec3 weight = abs(normalize(fragNObj));
     color = color1 * weight.x + color2 * weight.y + color3 * weight.z;
+    map_Kd = texture(diffuseTex, texCoord1) * weight.x +
+             texture(diffuseTex, texCoord2) * weight.y +
+             texture(diffuseTex, texCoord3) * weight.z;
   } else {
     vec2 texCoord;
     if (mappingMode == 1) {
@@ -142,8 +207,12 @@ void main() {
       texCoord = fragTexCoord;
     }
     color = BlinnPhong(fragN, fragL, fragV, texCoord);
+    map_Kd = texture(diffuseTex, texCoord);
   }
 
+  // fragV is the view-space position negated
+  color.rgb += ClusteredLights(-fragV, fragN, fragV, map_Kd.rgb * Kd.rgb);
+
   if (gl_FrontFacing) {
     outColor = color;
   } else {
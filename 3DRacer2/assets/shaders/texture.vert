@@ -4,13 +4,17 @@ layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inNormal;
 layout(location = 2) in vec2 inTexCoord;
 
-uniform mat4 modelMatrix;
-uniform mat4 viewMatrix;
-uniform mat4 projMatrix;
+// Precomputed for each object by abcg::TransformBatch
+uniform mat4 modelViewMatrix;
+uniform mat4 modelViewProjMatrix;
 uniform mat3 normalMatrix;
+uniform mat4 viewMatrix;
 
 uniform vec4 lightDirWorldSpace;
 
+// Must match the depth pre-pass shaders
+invariant gl_Position;
+
 out vec3 fragV;
 out vec3 fragL;
 out vec3 fragN;
@@ -19,7 +23,7 @@ out vec3 fragPObj;
 out vec3 fragNObj;
 
 void main() {
-  vec3 P = (viewMatrix * modelMatrix * vec4(inPosition, 1.0)).xyz;
+  vec3 P = (modelViewMatrix * vec4(inPosition, 1.0)).xyz;
   vec3 N = normalMatrix * inNormal;
   vec3 L = -(viewMatrix * lightDirWorldSpace).xyz;
 
@@ -30,5 +34,5 @@ void main() {
   fragPObj = inPosition;
   fragNObj = inNormal;
 
-  gl_Position = projMatrix * vec4(P, 1.0);
+  gl_Position = modelViewProjMatrix * vec4(inPosition, 1.0);
 }
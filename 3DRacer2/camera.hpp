@@ -1,34 +0,0 @@
-#ifndef CAMERA_HPP_
-#define CAMERA_HPP_
-
-#include <glm/mat4x4.hpp>
-#include <glm/vec3.hpp>
-
-class OpenGLWindow;
-class Player;
-class Enemy;
-class Ground;
-
-class Camera {
-    public:
-        void computeViewMatrix();
-        void computeProjectionMatrix(int width, int height);
-
-    private:
-        friend OpenGLWindow;
-        friend Player;
-        friend Enemy;
-        friend Ground;
-
-        glm::vec3 m_eye{glm::vec3(0.0f, 0.5f, 0.0f)};  // Camera position
-        glm::vec3 m_at{glm::vec3(0.0f, 0.5f, -1.0f)};   // Look-at point
-        glm::vec3 m_up{glm::vec3(0.0f, 1.0f, 0.0f)};   // "up" direction
-
-        // Matrix to change from world space to camera spaces
-        glm::mat4 m_viewMatrix;
-
-        // Matrix to change from camera space to clip space
-        glm::mat4 m_projMatrix;
-};
-
-#endif
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include <tiny_obj_loader.h>
 
 #include <cppitertools/itertools.hpp>
+#include <cstddef>
+#include <cstring>
 #include <glm/gtx/hash.hpp>
 #include <unordered_map>
 
@@ -89,6 +91,8 @@ void Enemy::loadObj(std::string_view path, bool standardize) {
         this->standardize();
     }
 
+    m_bounds = computeBounds(m_vertices);
+
     if (!m_hasNormals) {
         computeNormals();
     }
@@ -167,102 +171,164 @@ void Enemy::computeNormals() {
     m_hasNormals = true;
 }
 
-void Enemy::initializeGL(GLuint program) {
+void Enemy::initializeGL(GLuint program, GLuint depthProgram, abcg::MeshArena &arena,
+                         abcg::TransformBatch &transforms, abcg::SceneGraph &scene) {
     terminateGL();
     m_program = program;
-
-    // Generate VBO
-    abcg::glGenBuffers(1, &m_VBO);
-    abcg::glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-    abcg::glBufferData(GL_ARRAY_BUFFER, sizeof(m_vertices[0]) * m_vertices.size(), m_vertices.data(), GL_STATIC_DRAW);
-    abcg::glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-    // Generate EBO
-    abcg::glGenBuffers(1, &m_EBO);
-    abcg::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
-    abcg::glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(m_indices[0]) * m_indices.size(), m_indices.data(), GL_STATIC_DRAW);
-    abcg::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
-    // Create VAO
-    abcg::glGenVertexArrays(1, &m_VAO);
-
-    // Bind vertex attributes to current VAO
-    abcg::glBindVertexArray(m_VAO);
-
-    abcg::glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-    const GLint positionAttribute{abcg::glGetAttribLocation(m_program, "inPosition")};\
-    if (positionAttribute >= 0) {
-        abcg::glEnableVertexAttribArray(positionAttribute);
-        abcg::glVertexAttribPointer(positionAttribute, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), nullptr);
-    }
-
-    const GLint normalAttribute{abcg::glGetAttribLocation(program, "inNormal")};
-    if (normalAttribute >= 0) {
-        abcg::glEnableVertexAttribArray(normalAttribute);
-        GLsizei offset{sizeof(glm::vec3)};
-        abcg::glVertexAttribPointer(normalAttribute, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offset));
+    m_depthProgram = depthProgram;
+
+    // One transform and one node per car, added consecutively
+    m_firstTransform = transforms.size();
+    m_firstNode = scene.size();
+    for ([[maybe_unused]] const auto index : iter::range(m_numCars)) {
+        scene.add(abcg::SceneGraph::noParent, glm::vec3(0.0f),
+                  glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.0f), transforms.add());
     }
 
-    abcg::glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-    abcg::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+    // Create instance buffer (contents are streamed in updateInstances). Each
+    // frame region has room for the whole fleet plus the alignment padding.
+    m_instanceBuffer.initializeGL(GL_ARRAY_BUFFER, sizeof(m_instances) + sizeof(Instance));
+
+    // Copy the mesh to the shared buffers
+    m_mesh = arena.allocate<Vertex>(m_vertices, m_indices);
+
+    // The batch VAO reads the vertices from the arena and the per-instance
+    // attributes, which advance once per car instead of per vertex
+    const std::array<abcg::MultiDrawBatch::Attribute, 4> instanceAttributes{{
+        {.name{"inModelViewMatrix"}, .size{4}, .offset{offsetof(Instance, modelViewMatrix)}, .columns{4}},
+        {.name{"inModelViewProjMatrix"}, .size{4}, .offset{offsetof(Instance, modelViewProjMatrix)}, .columns{4}},
+        {.name{"inNormalMatrix"}, .size{3}, .offset{offsetof(Instance, normalMatrix)}, .columns{3}},
+        {.name{"inKd"}, .size{4}, .offset{offsetof(Instance, Kd)}}}};
+    m_batch.initializeGL(arena, m_program, m_instanceBuffer.getBuffer(), sizeof(Instance), instanceAttributes);
+}
 
+void Enemy::reset() {
     for (const auto index : iter::range(m_numCars)) {
         auto &position{m_enemiesPositions.at(index)};
         auto &m_Kd{m_enemiesColors.at(index)};
         // position = glm::vec3(0.0f, 0.0f, -10.0f);
         randomizeCar(position, m_Kd);
+        ++m_spawns.at(index);
     }
-
-    // End of binding to current VAO
-    abcg::glBindVertexArray(0);
+    m_previousPositions = m_enemiesPositions;
 }
 
-void Enemy::paintGL() {
-    abcg::glUseProgram(m_program);
-
-    // Get location of uniform variables (could be precomputed)
-    GLint modelMatrixLoc{abcg::glGetUniformLocation(m_program, "modelMatrix")};
-    GLint normalMatrixLoc{abcg::glGetUniformLocation(m_program, "normalMatrix")};
-    GLint shininessLoc{abcg::glGetUniformLocation(m_program, "shininess")};
-    GLint KaLoc{abcg::glGetUniformLocation(m_program, "Ka")};
-    GLint KdLoc{abcg::glGetUniformLocation(m_program, "Kd")};
-    GLint KsLoc{abcg::glGetUniformLocation(m_program, "Ks")};
-    GLint mappingModeLoc{abcg::glGetUniformLocation(m_program, "mappingMode")};
-
-    abcg::glUniform1i(mappingModeLoc, m_mappingMode);
+Enemy::State Enemy::getState() const {
+    return {.previousPositions{m_previousPositions},
+            .positions{m_enemiesPositions},
+            .colors{m_enemiesColors},
+            .spawns{m_spawns}};
+}
 
+void Enemy::updateNodes(abcg::SceneGraph &scene, const State &state, float alpha) {
     for (const auto index : iter::range(m_numCars)) {
-        auto &position{m_enemiesPositions.at(index)};
-        auto &m_Kd{m_enemiesColors.at(index)};
-        // compute model matrix of the current car
-        glm::mat4 enemyMatrix{1.0f};
-        enemyMatrix = glm::translate(enemyMatrix, position); 
-        enemyMatrix = glm::rotate(enemyMatrix, glm::radians(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        enemyMatrix = glm::scale(enemyMatrix, glm::vec3(1.0f)); 
-
-        abcg::glUniformMatrix4fv(modelMatrixLoc, 1, GL_FALSE, &enemyMatrix[0][0]);
+        scene.setTranslation(m_firstNode + index, glm::mix(state.previousPositions.at(index),
+                                                           state.positions.at(index), alpha));
+
+        // A respawned car starts out visible, as its old occlusion results
+        // belong to another position
+        if (m_drawnSpawns.at(index) != state.spawns.at(index)) {
+            m_drawnSpawns.at(index) = state.spawns.at(index);
+            m_occlusionQueries.at(index).reset();
+        }
+    }
+    m_drawnColors = state.colors;
+}
 
-        abcg::glUniform1f(shininessLoc, m_shininess);
-        abcg::glUniform4fv(KaLoc, 1, &m_Ka.x);
-        abcg::glUniform4fv(KdLoc, 1, &m_Kd.x);
-        abcg::glUniform4fv(KsLoc, 1, &m_Ks.x);
+void Enemy::submit(abcg::RenderQueue &queue, const abcg::Frustum &frustum,
+                   const abcg::TransformBatch &transforms, CullingStats &stats) {
+    updateInstances(frustum, transforms);
+    stats.drawn += m_numVisibleCars;
+    stats.culled += m_numCars - m_numInFrustum;
+    stats.occluded += m_numInFrustum - m_numVisibleCars;
+    if (m_numVisibleCars == 0) return;
+
+    // Draw the whole fleet at once. Kd and the per-car matrices come from the
+    // instance VBO; the item transform only places the item in the sort.
+    m_batch.clearCommands();
+    m_batch.addCommand(m_mesh, static_cast<GLuint>(m_numVisibleCars), m_baseInstance);
+
+    abcg::RenderQueue::DrawItem item;
+    item.program = m_program;
+    item.depthProgram = m_depthProgram;
+    item.batch = &m_batch;
+    item.material = &m_material;
+    item.transforms = &transforms;
+    item.transform = m_firstVisibleTransform;
+    queue.submit(item);
+}
 
-        abcg::glBindVertexArray(m_VAO);
+void Enemy::updateInstances(const abcg::Frustum &frustum, const abcg::TransformBatch &transforms) {
+    // Test every car at once against the frustum
+    std::array<glm::vec4, m_numCars> spheres;
+    for (const auto index : iter::range(m_numCars)) {
+        const auto &modelMatrix{transforms.getModelMatrix(m_firstTransform + index)};
+        spheres.at(index) = m_bounds.sphere + glm::vec4(glm::vec3(modelMatrix[3]), 0.0f);
+    }
+    m_numInFrustum = frustum.cull(spheres, m_inFrustum);
+
+    // Keep only the cars that were not occluded in the instance array
+    m_numVisibleCars = 0;
+    for (const auto inFrustumIndex : iter::range(m_numInFrustum)) {
+        const auto index{m_inFrustum.at(inFrustumIndex)};
+        auto &query{m_occlusionQueries.at(index)};
+        query.update();
+        if (!query.isVisible()) continue;
+
+        // Matrices of the current car, computed with the whole batch
+        const auto transform{m_firstTransform + index};
+        if (m_numVisibleCars == 0) m_firstVisibleTransform = transform;
+        auto &instance{m_instances.at(m_numVisibleCars++)};
+        instance.modelViewMatrix = transforms.getModelViewMatrix(transform);
+        instance.modelViewProjMatrix = transforms.getModelViewProjMatrix(transform);
+        instance.normalMatrix = transforms.getNormalMatrix(transform);
+        instance.Kd = m_drawnColors.at(index);
+    }
 
-        m_camera.computeViewMatrix();
-        auto modelViewMatrix{glm::mat3(m_camera.m_viewMatrix * enemyMatrix)};
-        glm::mat3 normalMatrix{glm::inverseTranspose(modelViewMatrix)};
-        abcg::glUniformMatrix3fv(normalMatrixLoc, 1, GL_FALSE, &normalMatrix[0][0]);
+    // Write to this frame's region of the ring. The allocation is aligned to
+    // the instance size, so the draw reads it starting at baseInstance.
+    m_instanceBuffer.beginFrame();
+    if (m_numVisibleCars > 0) {
+        const auto size{static_cast<GLsizeiptr>(sizeof(Instance) * m_numVisibleCars)};
+        const auto allocation{m_instanceBuffer.allocate(size, sizeof(Instance))};
+        std::memcpy(allocation.data, m_instances.data(), allocation.size);
+        m_baseInstance = static_cast<GLuint>(allocation.offset / static_cast<GLintptr>(sizeof(Instance)));
+    }
+    m_instanceBuffer.endFrame();
+}
 
-        abcg::glDrawElements(GL_TRIANGLES, m_indices.size(), GL_UNSIGNED_INT, nullptr);
+void Enemy::addLights(std::vector<abcg::ClusteredLights::Light> &lights,
+                      const abcg::SceneGraph &scene) const {
+    // Headlights at the front of each car, facing the player, at its drawn
+    // position
+    const auto width{m_bounds.max.x - m_bounds.min.x};
+    const auto height{glm::mix(m_bounds.min.y, m_bounds.max.y, 0.4f)};
+    for (const auto index : iter::range(m_numCars)) {
+        const auto &position{scene.getTranslation(m_firstNode + index)};
+        for (const auto side : {-1.0f, 1.0f}) {
+            const glm::vec3 front{side * 0.3f * width, height, m_bounds.max.z};
+            lights.push_back({.position{position + front},
+                              .radius{15.0f},
+                              .color{8.0f, 7.6f, 6.4f},
+                              .direction{0.0f, -0.1f, 1.0f},
+                              .cosInnerCone{0.95f},
+                              .cosOuterCone{0.85f}});
+        }
     }
+}
 
-    abcg::glBindVertexArray(0);
-    abcg::glUseProgram(0);
+void Enemy::queryOcclusion(abcg::OcclusionCuller &culler, const abcg::SceneGraph &scene) {
+    // Query every car in the frustum, including the occluded ones, so that
+    // they are drawn again once they come into view
+    for (const auto inFrustumIndex : iter::range(m_numInFrustum)) {
+        const auto index{m_inFrustum.at(inFrustumIndex)};
+        const auto &position{scene.getTranslation(m_firstNode + index)};
+        culler.query(m_occlusionQueries.at(index), position + m_bounds.min, position + m_bounds.max);
+    }
 }
 
 void Enemy::update(const GameData &gameData, float deltaTime) {
+    m_previousPositions = m_enemiesPositions;
     for (const auto index : iter::range(m_numCars)) {
         auto &position{m_enemiesPositions.at(index)};
         auto &m_Kd{m_enemiesColors.at(index)};
@@ -273,12 +339,19 @@ void Enemy::update(const GameData &gameData, float deltaTime) {
         // If this car is behind the camera, move it back with a new random x position and a slightly random z position
         if (position.z > 0.1f) {
             randomizeCar(position, m_Kd);
+            ++m_spawns.at(index);
+            // Jump instead of sliding back through the scene
+            m_previousPositions.at(index) = position;
         }
     }
 }
 
 void Enemy::terminateGL() {
-    abcg::glDeleteBuffers(1, &m_EBO);
-    abcg::glDeleteBuffers(1, &m_VBO);
-    abcg::glDeleteVertexArrays(1, &m_VAO);
+    // The mesh is released with the arena
+    m_mesh = {};
+    for (auto &query : m_occlusionQueries) {
+        query.terminateGL();
+    }
+    m_batch.terminateGL();
+    m_instanceBuffer.terminateGL();
 }
\ No newline at end of file
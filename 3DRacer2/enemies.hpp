@@ -11,11 +11,31 @@ class OpenGLWindow;
 
 class Enemy {
     public:
+        static const int m_numCars{5};
+
+        // State drawn by the render thread, published by the update thread.
+        // The spawn count of a car changes whenever it is replaced by a new
+        // one.
+        struct State {
+            std::array<glm::vec3, m_numCars> previousPositions{};
+            std::array<glm::vec3, m_numCars> positions{};
+            std::array<glm::vec4, m_numCars> colors{};
+            std::array<std::uint32_t, m_numCars> spawns{};
+        };
+
         void loadObj(std::string_view path, bool standardize = true);
-        void initializeGL(GLuint program);
-        void paintGL();
+        void initializeGL(GLuint program, GLuint depthProgram, abcg::MeshArena &arena,
+                          abcg::TransformBatch &transforms, abcg::SceneGraph &scene);
+        void reset();
+        [[nodiscard]] State getState() const;
+        void updateNodes(abcg::SceneGraph &scene, const State &state, float alpha);
+        void submit(abcg::RenderQueue &queue, const abcg::Frustum &frustum,
+                    const abcg::TransformBatch &transforms, CullingStats &stats);
+        void addLights(std::vector<abcg::ClusteredLights::Light> &lights,
+                       const abcg::SceneGraph &scene) const;
         void terminateGL();
         void update(const GameData &gameData, float deltaTime);
+        void queryOcclusion(abcg::OcclusionCuller &culler, const abcg::SceneGraph &scene);
 
         [[nodiscard]] int getNumTriangles() const {
         return static_cast<int>(m_indices.size()) / 3;
@@ -24,34 +44,63 @@ class Enemy {
     private:
         friend OpenGLWindow;
 
-        static const int m_numCars{5};
-
-        Camera m_camera;
-
-        GLuint m_VAO{};
-        GLuint m_VBO{};
-        GLuint m_EBO{};
+        // Per-instance data streamed to the instance VBO once per frame
+        struct Instance {
+            glm::mat4 modelViewMatrix{1.0f};
+            glm::mat4 modelViewProjMatrix{1.0f};
+            glm::mat3 normalMatrix{1.0f};
+            glm::vec4 Kd{};
+        };
+
+        // The car mesh lives in the arena shared by every object, and is
+        // drawn by a multi-draw batch with one call
+        abcg::MeshArena::Mesh m_mesh;
+        abcg::MultiDrawBatch m_batch;
+        // Ring of per-frame instance data, written without stalling
+        abcg::StreamBuffer m_instanceBuffer;
+        GLuint m_baseInstance{};
         GLuint m_program{};
+        GLuint m_depthProgram{};
 
         std::default_random_engine m_randomEngine;
 
         std::vector<Vertex> m_vertices;
         std::vector<GLuint> m_indices;
+        Bounds m_bounds;
 
         std::array<glm::vec3, m_numCars> m_enemiesPositions;
+        // Positions before the last update, drawn interpolated with the
+        // current ones
+        std::array<glm::vec3, m_numCars> m_previousPositions;
         std::array<glm::vec4, m_numCars> m_enemiesColors;
+        std::array<std::uint32_t, m_numCars> m_spawns{};
+        // Colors and spawn counts of the cars being drawn
+        std::array<glm::vec4, m_numCars> m_drawnColors{};
+        std::array<std::uint32_t, m_numCars> m_drawnSpawns{};
+        std::array<Instance, m_numCars> m_instances;
+        std::size_t m_numVisibleCars{};
+        // Index of the first car in the transform batch and in the scene graph
+        // of the window. The other cars follow it.
+        std::size_t m_firstTransform{};
+        std::size_t m_firstNode{};
+        // Transform of the first visible car, which places the fleet in the
+        // render queue
+        std::size_t m_firstVisibleTransform{};
+
+        // Cars inside the view frustum and their occlusion state
+        std::array<std::uint32_t, m_numCars> m_inFrustum;
+        std::size_t m_numInFrustum{};
+        std::array<abcg::OcclusionCuller::Query, m_numCars> m_occlusionQueries;
 
         void standardize();
         void randomizeCar(glm::vec3 &position, glm::vec4 &m_Kd);
         void computeNormals();
-        // Mapping mode
-        // 0: triplanar; 1: cylindrical; 2: spherical; 3: from mesh; 4: standard blinn-phong
-        int m_mappingMode{4}; 
-
-        // Light and material properties
-        glm::vec4 m_Ka{0.05f, 0.07f, 0.1f, 1.0f};
-        glm::vec4 m_Ks{0.3f, 0.3f, 0.3f, 1.0f};
-        float m_shininess{5.0f};
+        void updateInstances(const abcg::Frustum &frustum, const abcg::TransformBatch &transforms);
+
+        // Light and material properties shared by every car
+        abcg::RenderQueue::Material m_material{.Ka{0.05f, 0.07f, 0.1f, 1.0f},
+                                               .Ks{0.3f, 0.3f, 0.3f, 1.0f},
+                                               .shininess{5.0f}};
 
         bool m_hasNormals{false};
 };
@@ -1,9 +1,13 @@
 #ifndef GAMEDATA_HPP_
 #define GAMEDATA_HPP_
 
+#include <algorithm>
 #include <bitset>
+#include <limits>
+#include <vector>
 #include <glm/gtc/matrix_inverse.hpp>
-#include "camera.hpp"
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
 
 enum class Input { Right, Left };
 enum class State { Playing, GameOver };
@@ -21,6 +25,48 @@ struct Vertex {
     }
 };
 
+// Bounding volumes of a mesh in model space
+struct Bounds {
+    glm::vec3 min{};
+    glm::vec3 max{};
+    glm::vec4 sphere{};  // Center (xyz) and radius (w)
+};
+
+// Number of objects submitted, outside the frustum and occluded this frame
+struct CullingStats {
+    std::size_t drawn{};
+    std::size_t culled{};
+    std::size_t occluded{};
+};
+
+// Computes the AABB of the vertices and a bounding sphere centered on it
+inline Bounds computeBounds(const std::vector<Vertex>& vertices) {
+    Bounds bounds;
+    bounds.min = glm::vec3(std::numeric_limits<float>::max());
+    bounds.max = glm::vec3(std::numeric_limits<float>::lowest());
+    for (const auto& vertex : vertices) {
+        bounds.min = glm::min(bounds.min, vertex.position);
+        bounds.max = glm::max(bounds.max, vertex.position);
+    }
+
+    const auto center{(bounds.min + bounds.max) / 2.0f};
+    float radius{};
+    for (const auto& vertex : vertices) {
+        radius = std::max(radius, glm::distance(center, vertex.position));
+    }
+    bounds.sphere = glm::vec4(center, radius);
+    return bounds;
+}
+
+// Transforms a model-space bounding sphere to world space
+inline glm::vec4 transformSphere(const glm::mat4& modelMatrix, const glm::vec4& sphere) {
+    const glm::vec3 center{modelMatrix * glm::vec4(glm::vec3(sphere), 1.0f)};
+    const auto scale{std::max({glm::length(glm::vec3(modelMatrix[0])),
+                               glm::length(glm::vec3(modelMatrix[1])),
+                               glm::length(glm::vec3(modelMatrix[2]))})};
+    return glm::vec4(center, sphere.w * scale);
+}
+
 struct GameData {
     State m_state{State::Playing};
     std::bitset<5> m_input; // [left, right]
@@ -25,6 +25,18 @@ void Ground::loadDiffuseTexture(std::string_view path) {
 
     abcg::glDeleteTextures(1, &m_diffuseTexture);
     m_diffuseTexture = abcg::opengl::loadTexture(path);
+
+    // Sampling parameters belong to the texture object, so set them only once
+    abcg::glBindTexture(GL_TEXTURE_2D, m_diffuseTexture);
+
+    // Set minification and magnification parameters
+    abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    // Set texture wrapping parameters
+    abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    abcg::glBindTexture(GL_TEXTURE_2D, 0);
 }
 
 void Ground::loadObj(std::string_view path, bool standardize) {
@@ -116,25 +128,33 @@ void Ground::loadObj(std::string_view path, bool standardize) {
     // Use properties of first material, if available
     if (!materials.empty()) {
         const auto& mat{materials.at(0)};  // First material
-        m_Ka = glm::vec4(mat.ambient[0], mat.ambient[1], mat.ambient[2], 1);
-        m_Kd = glm::vec4(mat.diffuse[0], mat.diffuse[1], mat.diffuse[2], 1);
-        m_Ks = glm::vec4(mat.specular[0], mat.specular[1], mat.specular[2], 1);
-        m_shininess = mat.shininess;
-
-        if (!mat.diffuse_texname.empty())
-        loadDiffuseTexture(basePath + mat.diffuse_texname);
+        m_material.Ka = glm::vec4(mat.ambient[0], mat.ambient[1], mat.ambient[2], 1);
+        m_material.Kd = glm::vec4(mat.diffuse[0], mat.diffuse[1], mat.diffuse[2], 1);
+        m_material.Ks = glm::vec4(mat.specular[0], mat.specular[1], mat.specular[2], 1);
+        m_material.shininess = mat.shininess;
+
+        // The model may be loaded by a worker thread, but textures can only be
+        // created by the thread of the OpenGL context
+        if (!mat.diffuse_texname.empty()) {
+            abcg::JobSystem::getInstance().submitToMainThread(
+                [this, texturePath = basePath + mat.diffuse_texname] {
+                    loadDiffuseTexture(texturePath);
+                });
+        }
     } else {
         // Default values
-        m_Ka = {0.1f, 0.1f, 0.1f, 1.0f};
-        m_Kd = {0.7f, 0.7f, 0.7f, 1.0f};
-        m_Ks = {1.0f, 1.0f, 1.0f, 1.0f};
-        m_shininess = 25.0f;
+        m_material.Ka = {0.1f, 0.1f, 0.1f, 1.0f};
+        m_material.Kd = {0.7f, 0.7f, 0.7f, 1.0f};
+        m_material.Ks = {1.0f, 1.0f, 1.0f, 1.0f};
+        m_material.shininess = 25.0f;
     }
 
     if (standardize) {
         this->standardize();
     }
 
+    m_bounds = computeBounds(m_vertices);
+
     if (!m_hasNormals) {
         computeNormals();
     }
@@ -195,55 +215,27 @@ void Ground::computeNormals() {
     m_hasNormals = true;
 }
 
-void Ground::initializeGL(GLuint program) {
-    terminateGL();
+void Ground::initializeGL(GLuint program, GLuint depthProgram, abcg::MeshArena &arena,
+                          abcg::TransformBatch &transforms, abcg::SceneGraph &scene) {
     m_program = program;
-
-    // Generate VBO
-    abcg::glGenBuffers(1, &m_VBO);
-    abcg::glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-    abcg::glBufferData(GL_ARRAY_BUFFER, sizeof(m_vertices[0]) * m_vertices.size(), m_vertices.data(), GL_STATIC_DRAW);
-    abcg::glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-    // Generate EBO
-    abcg::glGenBuffers(1, &m_EBO);
-    abcg::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
-    abcg::glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(m_indices[0]) * m_indices.size(), m_indices.data(), GL_STATIC_DRAW);
-    abcg::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
-    // Create VAO
-    abcg::glGenVertexArrays(1, &m_VAO);
-
-    // Bind vertex attributes to current VAO
-    abcg::glBindVertexArray(m_VAO);
-
-    abcg::glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-    const GLint positionAttribute{abcg::glGetAttribLocation(m_program, "inPosition")};\
-    if (positionAttribute >= 0) {
-        abcg::glEnableVertexAttribArray(positionAttribute);
-        abcg::glVertexAttribPointer(positionAttribute, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), nullptr);
-    }
-
-    const GLint normalAttribute{abcg::glGetAttribLocation(program, "inNormal")};
-    if (normalAttribute >= 0) {
-        abcg::glEnableVertexAttribArray(normalAttribute);
-        GLsizei offset{sizeof(glm::vec3)};
-        abcg::glVertexAttribPointer(normalAttribute, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offset));
-    }
-
-    const GLint texCoordAttribute{abcg::glGetAttribLocation(program, "inTexCoord")};
-    if (texCoordAttribute >= 0) {
-        abcg::glEnableVertexAttribArray(texCoordAttribute);
-        GLsizei offset{sizeof(glm::vec3) + sizeof(glm::vec3)};
-        abcg::glVertexAttribPointer(texCoordAttribute, 2, GL_FLOAT, GL_FALSE,
-                                    sizeof(Vertex),
-                                    reinterpret_cast<void*>(offset));
+    m_depthProgram = depthProgram;
+    // One transform and one node per piece, added consecutively. The scale
+    // never changes.
+    m_firstTransform = transforms.size();
+    m_firstNode = scene.size();
+    for ([[maybe_unused]] const auto index : iter::range(m_numGrounds)) {
+        scene.add(abcg::SceneGraph::noParent, glm::vec3(0.0f),
+                  glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.0f, 1.0f, 0.50f),
+                  transforms.add());
     }
 
-    abcg::glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-    abcg::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+    // Copy the mesh to the shared buffers, replacing any previous one
+    arena.free(m_mesh);
+    m_mesh = arena.allocate<Vertex>(m_vertices, m_indices);
+    m_VAO = arena.getVAO();
+}
 
+void Ground::reset() {
     // for (const auto index : iter::range(m_numGrounds)) {
     //     auto &position{m_groundPositions.at(index)};
     //     position = glm::vec3(0.0f, 0.0f, -10.0f * index);
@@ -254,67 +246,69 @@ void Ground::initializeGL(GLuint program) {
     position1 = glm::vec3(0.0f, -0.215f, -200.0f);
     position2 = glm::vec3(0.0f, -0.215f, -100.0f);
     position3 = glm::vec3(0.0f, -0.215f, 0.0f);
-
-    // End of binding to current VAO
-    abcg::glBindVertexArray(0);
+    m_previousPositions = m_groundPositions;
 }
 
-void Ground::paintGL() {
-    abcg::glUseProgram(m_program);
-    abcg::glBindVertexArray(m_VAO);
-
-    // Get location of uniform variables (could be precomputed)
-    const GLint modelMatrixLoc{abcg::glGetUniformLocation(m_program, "modelMatrix")};
-    const GLint normalMatrixLoc{abcg::glGetUniformLocation(m_program, "normalMatrix")};
-    const GLint shininessLoc{abcg::glGetUniformLocation(m_program, "shininess")};
-    const GLint KaLoc{abcg::glGetUniformLocation(m_program, "Ka")};
-    const GLint KdLoc{abcg::glGetUniformLocation(m_program, "Kd")};
-    const GLint KsLoc{abcg::glGetUniformLocation(m_program, "Ks")};
-    const GLint diffuseTexLoc{abcg::glGetUniformLocation(m_program, "diffuseTex")};
-    const GLint mappingModeLoc{abcg::glGetUniformLocation(m_program, "mappingMode")}; 
+Ground::State Ground::getState() const {
+    return {.previousPositions{m_previousPositions}, .positions{m_groundPositions}};
+}
 
+void Ground::updateNodes(abcg::SceneGraph &scene, const State &state, float alpha) const {
     for (const auto index : iter::range(m_numGrounds)) {
-        auto &position{m_groundPositions.at(index)};
-
-        // compute model matrix of the current car
-        glm::mat4 groundMatrix{1.0f};
-        groundMatrix = glm::translate(groundMatrix, position); 
-        groundMatrix = glm::rotate(groundMatrix, glm::radians(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        groundMatrix = glm::scale(groundMatrix, glm::vec3(1.0f, 1.0f, 0.50f));
-
-        abcg::glUniform1f(shininessLoc, m_shininess);
-        abcg::glUniform4fv(KaLoc, 1, &m_Ka.x);
-        abcg::glUniform4fv(KdLoc, 1, &m_Kd.x);
-        abcg::glUniform4fv(KsLoc, 1, &m_Ks.x);
-
-        abcg::glUniformMatrix4fv(modelMatrixLoc, 1, GL_FALSE, &groundMatrix[0][0]);
-        abcg::glUniform1i(diffuseTexLoc, 0);
-        abcg::glUniform1i(mappingModeLoc, m_mappingMode);
-
-        m_camera.computeViewMatrix();
-        const auto modelViewMatrix{glm::mat3(m_camera.m_viewMatrix * groundMatrix)};
-        glm::mat3 normalMatrix{glm::inverseTranspose(modelViewMatrix)};
-        abcg::glUniformMatrix3fv(normalMatrixLoc, 1, GL_FALSE, &normalMatrix[0][0]);
-
-        abcg::glActiveTexture(GL_TEXTURE0);
-        abcg::glBindTexture(GL_TEXTURE_2D, m_diffuseTexture);
+        scene.setTranslation(m_firstNode + index, glm::mix(state.previousPositions.at(index),
+                                                           state.positions.at(index), alpha));
+    }
+}
 
-        // Set minification and magnification parameters
-        abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+void Ground::submit(abcg::RenderQueue &queue, const abcg::Frustum &frustum,
+                    const abcg::TransformBatch &transforms, CullingStats &stats) {
+    abcg::RenderQueue::DrawItem item;
+    item.program = m_program;
+    item.depthProgram = m_depthProgram;
+    item.VAO = m_VAO;
+    item.count = static_cast<GLsizei>(m_mesh.count);
+    item.firstIndex = m_mesh.firstIndex;
+    item.baseVertex = m_mesh.baseVertex;
+    item.textures = {m_diffuseTexture};
+    item.material = &m_material;
+    item.transforms = &transforms;
+
+    // Bounding sphere of each ground piece
+    std::array<glm::vec4, m_numGrounds> spheres;
+    for (const auto index : iter::range(m_numGrounds)) {
+        const auto &modelMatrix{transforms.getModelMatrix(m_firstTransform + index)};
+        spheres.at(index) = transformSphere(modelMatrix, m_bounds.sphere);
+    }
 
-        // Set texture wrapping parameters
-        abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    // Submit only the pieces that may be visible
+    std::array<std::uint32_t, m_numGrounds> visible;
+    const auto numVisible{frustum.cull(spheres, visible)};
+    stats.drawn += numVisible;
+    stats.culled += m_numGrounds - numVisible;
 
-        abcg::glDrawElements(GL_TRIANGLES, m_indices.size(), GL_UNSIGNED_INT, nullptr);
+    for (const auto index : iter::range(numVisible)) {
+        item.transform = m_firstTransform + visible.at(index);
+        queue.submit(item);
     }
+}
 
-    abcg::glBindVertexArray(0);
-    abcg::glUseProgram(0);
+void Ground::addLights(std::vector<abcg::ClusteredLights::Light> &lights,
+                       const abcg::SceneGraph &scene) const {
+    // Street lamps on both sides of every ground piece, at its drawn position
+    for (const auto index : iter::range(m_numGrounds)) {
+        const auto &position{scene.getTranslation(m_firstNode + index)};
+        for (const auto offset : {-37.5f, -12.5f, 12.5f, 37.5f}) {
+            for (const auto side : {-3.0f, 3.0f}) {
+                lights.push_back({.position{position + glm::vec3(side, 2.5f, offset)},
+                                  .radius{8.0f},
+                                  .color{6.0f, 5.0f, 3.0f}});
+            }
+        }
+    }
 }
 
 void Ground::update(const GameData &gameData, float deltaTime) {
+    m_previousPositions = m_groundPositions;
     for (const auto index : iter::range(m_numGrounds)) {
         auto &position{m_groundPositions.at(index)};
 
@@ -324,12 +318,15 @@ void Ground::update(const GameData &gameData, float deltaTime) {
         // If this car is behind the camera, move it back with a new random x position and a slightly random z position
         if (position.z > 100.0f) {
             position.z = -200.0f;
+            // Jump instead of sliding back through the scene
+            m_previousPositions.at(index) = position;
         }
     }
 }
 
 void Ground::terminateGL() {
-    abcg::glDeleteBuffers(1, &m_EBO);
-    abcg::glDeleteBuffers(1, &m_VBO);
-    abcg::glDeleteVertexArrays(1, &m_VAO);
+    // The mesh is released with the arena
+    m_mesh = {};
+    abcg::glDeleteTextures(1, &m_diffuseTexture);
+    m_diffuseTexture = 0;
 }
\ No newline at end of file
@@ -11,10 +11,25 @@ class OpenGLWindow;
 
 class Ground {
     public:
+        static const int m_numGrounds{3};
+
+        // State drawn by the render thread, published by the update thread
+        struct State {
+            std::array<glm::vec3, m_numGrounds> previousPositions{};
+            std::array<glm::vec3, m_numGrounds> positions{};
+        };
+
         void loadDiffuseTexture(std::string_view path);
         void loadObj(std::string_view path, bool standardize = false);
-        void initializeGL(GLuint program);
-        void paintGL();
+        void initializeGL(GLuint program, GLuint depthProgram, abcg::MeshArena &arena,
+                          abcg::TransformBatch &transforms, abcg::SceneGraph &scene);
+        void reset();
+        [[nodiscard]] State getState() const;
+        void updateNodes(abcg::SceneGraph &scene, const State &state, float alpha) const;
+        void submit(abcg::RenderQueue &queue, const abcg::Frustum &frustum,
+                    const abcg::TransformBatch &transforms, CullingStats &stats);
+        void addLights(std::vector<abcg::ClusteredLights::Light> &lights,
+                       const abcg::SceneGraph &scene) const;
         void terminateGL();
         void update(const GameData &gameData, float deltaTime);
 
@@ -22,47 +37,43 @@ class Ground {
         return static_cast<int>(m_indices.size()) / 3;
         }
         
-        [[nodiscard]] glm::vec4 getKa() const { return m_Ka; }
-        [[nodiscard]] glm::vec4 getKd() const { return m_Kd; }
-        [[nodiscard]] glm::vec4 getKs() const { return m_Ks; }
-        [[nodiscard]] float getShininess() const { return m_shininess; }
+        [[nodiscard]] glm::vec4 getKa() const { return m_material.Ka; }
+        [[nodiscard]] glm::vec4 getKd() const { return m_material.Kd; }
+        [[nodiscard]] glm::vec4 getKs() const { return m_material.Ks; }
+        [[nodiscard]] float getShininess() const { return m_material.shininess; }
 
         [[nodiscard]] bool isUVMapped() const { return m_hasTexCoords; }
 
     private:
         friend OpenGLWindow;
 
-        static const int m_numGrounds{3};
-
-        Camera m_camera;
-
+        // The mesh lives in the arena shared by every object
+        abcg::MeshArena::Mesh m_mesh;
         GLuint m_VAO{};
-        GLuint m_VBO{};
-        GLuint m_EBO{};
         GLuint m_program{};
+        GLuint m_depthProgram{};
 
         std::default_random_engine m_randomEngine;
 
         std::vector<Vertex> m_vertices;
         std::vector<GLuint> m_indices;
+        Bounds m_bounds;
 
         std::array<glm::vec3, m_numGrounds> m_groundPositions;
-
-        GLint m_modelMatrixLoc{};
-        GLint m_colorLoc{};
+        // Positions before the last update, drawn interpolated with the
+        // current ones
+        std::array<glm::vec3, m_numGrounds> m_previousPositions;
+        // Index of the first piece in the transform batch and in the scene
+        // graph of the window. The other pieces follow it.
+        std::size_t m_firstTransform{};
+        std::size_t m_firstNode{};
 
         void standardize();
         void computeNormals();
 
-        // Mapping mode
-        // 0: triplanar; 1: cylindrical; 2: spherical; 3: from mesh
-        int m_mappingMode{};  
-
         // Light and material properties
-        glm::vec4 m_Ka; //{0.0f, 0.2f, 0.0f, 1.0f};
-        glm::vec4 m_Kd; //{0.0f, 1.0f, 0.0f, 1.0f};
-        glm::vec4 m_Ks; //{1.0f, 1.0f, 1.0f, 1.0f};
-        float m_shininess{25.0f};   
+        // Mapping mode 0: triplanar; 1: cylindrical; 2: spherical; 3: from mesh
+        abcg::RenderQueue::Material m_material;
         GLuint m_diffuseTexture{};     
 
         bool m_hasNormals{false};
@@ -8,7 +8,14 @@ int main(int argc, char **argv) {
         abcg::Application app(argc, argv);
 
         auto window{std::make_unique<OpenGLWindow>()};
-        window->setOpenGLSettings({.samples = 4});
+        // Render the scene at a lower resolution when frames take too long,
+        // simulate the game at a fixed 120 Hz on a thread of its own, and
+        // draw at most 120 frames per second instead of spinning a core
+        window->setOpenGLSettings({.samples = 4,
+                                   .dynamicResolution = true,
+                                   .fixedTimeStep = 1.0 / 120.0,
+                                   .maxFrameRate = 120.0,
+                                   .threadedUpdate = true});
         window->setWindowSettings(
             {.width = 600, .height = 600, .showFPS = false, .title = "3D Racer 2"});
 
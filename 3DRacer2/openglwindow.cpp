@@ -6,6 +6,7 @@
 #include <tiny_obj_loader.h>
 
 #include <cppitertools/itertools.hpp>
+#include <cstddef>
 #include <glm/gtx/fast_trigonometry.hpp>
 #include <glm/gtx/hash.hpp>
 #include <unordered_map>
@@ -27,15 +28,24 @@
 void OpenGLWindow::handleEvent(SDL_Event& ev) {
 if (ev.type == SDL_KEYDOWN) {
     if (ev.key.keysym.sym == SDLK_LEFT || ev.key.keysym.sym == SDLK_a)
-        m_gameData.m_input.set(static_cast<size_t>(Input::Left));
+        m_input.fetch_or(1UL << static_cast<size_t>(Input::Left));
     if (ev.key.keysym.sym == SDLK_RIGHT || ev.key.keysym.sym == SDLK_d)
-        m_gameData.m_input.set(static_cast<size_t>(Input::Right));
+        m_input.fetch_or(1UL << static_cast<size_t>(Input::Right));
+    // Toggle the depth pre-pass
+    if (ev.key.keysym.sym == SDLK_p)
+        m_renderQueue.setDepthPrepass(!m_renderQueue.isDepthPrepassEnabled());
+    // Toggle dynamic resolution scaling
+    if (ev.key.keysym.sym == SDLK_r) {
+        auto settings{getOpenGLSettings()};
+        settings.dynamicResolution = !settings.dynamicResolution;
+        setOpenGLSettings(settings);
+    }
 }
 if (ev.type == SDL_KEYUP) {
     if (ev.key.keysym.sym == SDLK_LEFT || ev.key.keysym.sym == SDLK_a)
-        m_gameData.m_input.reset(static_cast<size_t>(Input::Left));
+        m_input.fetch_and(~(1UL << static_cast<size_t>(Input::Left)));
     if (ev.key.keysym.sym == SDLK_RIGHT || ev.key.keysym.sym == SDLK_d)
-        m_gameData.m_input.reset(static_cast<size_t>(Input::Right));
+        m_input.fetch_and(~(1UL << static_cast<size_t>(Input::Right)));
 }
 }
 
@@ -56,53 +66,178 @@ void OpenGLWindow::initializeGL() {
     // Create program
     m_program = createProgramFromFile(getAssetsPath() + "shaders/texture.vert",
                                         getAssetsPath() + "shaders/texture.frag");
+    m_instancedProgram = createProgramFromFile(getAssetsPath() + "shaders/instanced.vert",
+                                                getAssetsPath() + "shaders/instanced.frag");
+    m_occlusionProgram = createProgramFromFile(getAssetsPath() + "shaders/occlusion.vert",
+                                                getAssetsPath() + "shaders/occlusion.frag");
+    m_occlusionCuller.initializeGL(m_occlusionProgram);
+    m_clusteredLights.initializeGL();
+    // Depth-only programs of the pre-pass, one per main program
+    m_depthProgram = createProgramFromFile(getAssetsPath() + "shaders/depth.vert",
+                                            getAssetsPath() + "shaders/depth.frag");
+    m_depthInstancedProgram = createProgramFromFile(getAssetsPath() + "shaders/depthinstanced.vert",
+                                                    getAssetsPath() + "shaders/depth.frag");
+
+    // Create the buffers shared by every mesh. Both programs declare the
+    // vertex attributes at these locations.
+    const std::array<abcg::MeshArena::Attribute, 3> attributes{{
+        {.location{0}, .size{3}, .offset{offsetof(Vertex, position)}},
+        {.location{1}, .size{3}, .offset{offsetof(Vertex, normal)}},
+        {.location{2}, .size{2}, .offset{offsetof(Vertex, texCoord)}}}};
+    m_meshArena.initializeGL(sizeof(Vertex), m_maxVertices, m_maxIndices, attributes);
+
+    // Load the models and textures only once; restart() just resets the game
+    m_player.loadDiffuseTexture(getAssetsPath() + "maps/Car_texture.png");
+    m_ground.loadDiffuseTexture(getAssetsPath() + "maps/TexturesCom_Roads0148_1_seamless_S.jpg");
+
+    // The models are independent, so they are parsed in parallel by the
+    // shared job system. The textures of their materials are queued for this
+    // thread, and created once every model is loaded.
+    auto& jobSystem{abcg::JobSystem::getInstance()};
+    abcg::TaskGraph loadGraph;
+    loadGraph.add([&] {
+        m_player.loadObj(getAssetsPath() + "DeLorean_DMC-12_lowpoly_material.obj");
+    });
+    loadGraph.add([&] { m_enemies.loadObj(getAssetsPath() + "DeLorean_DMC-12_lowpoly.obj"); });
+    loadGraph.add([&] { m_ground.loadObj(getAssetsPath() + "GroundLong.obj"); });
+    jobSystem.run(loadGraph);
+    jobSystem.runMainThreadJobs();
+
+    m_camera.setLookAt(glm::vec3(0.0f, 0.5f, 0.0f), glm::vec3(0.0f, 0.5f, -1.0f));
+    m_uniformsCameraVersion = 0;
+
+    m_player.m_material.mappingMode = 3;  // "From mesh" option
+    m_ground.m_material.mappingMode = 3;  // "From mesh" option
+
+    m_transforms.clear();
+    m_scene.clear();
+    m_ground.initializeGL(m_program, m_depthProgram, m_meshArena, m_transforms, m_scene);
+    m_player.initializeGL(m_program, m_depthProgram, m_meshArena, m_transforms, m_scene);
+    m_enemies.initializeGL(m_instancedProgram, m_depthInstancedProgram, m_meshArena, m_transforms,
+                           m_scene);
     
+    // Seeded by abcg, so that a replayed session spawns the same enemies
+    m_enemies.m_randomEngine.seed(
+        static_cast<std::default_random_engine::result_type>(getRandomSeed()));
+
     restart();
+    publishSnapshot();
     resizeGL(getWindowSettings().width, getWindowSettings().height);
 }
 
 void OpenGLWindow::paintGL() {
-    update();
+    // Matrices and frustum are only recomputed if the camera moved
+    m_camera.update();
+
     // Set the clear color
     abcg::glClearColor(m_clearColor[0], m_clearColor[1], m_clearColor[2],
                         m_clearColor[3]);
     // Clear color buffer and depth buffer
     abcg::glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    abcg::glViewport(0, 0, m_viewportWidth, m_viewportHeight);
+    // The scene may be rendered at a lower resolution and upscaled
+    abcg::glViewport(0, 0, getRenderWidth(), getRenderHeight());
+
+    // Set uniform variables shared by every scene object on each program. The
+    // programs keep them, so they are only set again when the camera changes.
+    if (m_uniformsCameraVersion != m_camera.getVersion()) {
+        for (const auto program : {m_program, m_instancedProgram, m_depthProgram,
+                                   m_depthInstancedProgram}) {
+            abcg::glUseProgram(program);
+
+            // Get location of uniform variables (could be precomputed)
+            GLint viewMatrixLoc{abcg::glGetUniformLocation(program, "viewMatrix")};
+            GLint projMatrixLoc{abcg::glGetUniformLocation(program, "projMatrix")};
+            GLint lightDirLoc{abcg::glGetUniformLocation(program, "lightDirWorldSpace")};
+            GLint IaLoc{abcg::glGetUniformLocation(program, "Ia")};
+            GLint IdLoc{abcg::glGetUniformLocation(program, "Id")};
+            GLint IsLoc{abcg::glGetUniformLocation(program, "Is")};
+
+            abcg::glUniformMatrix4fv(viewMatrixLoc, 1, GL_FALSE, &m_camera.getViewMatrix()[0][0]);
+            abcg::glUniformMatrix4fv(projMatrixLoc, 1, GL_FALSE, &m_camera.getProjMatrix()[0][0]);
+
+            abcg::glUniform4fv(lightDirLoc, 1, &m_lightDir.x);
+            abcg::glUniform4fv(IaLoc, 1, &m_Ia.x);
+            abcg::glUniform4fv(IdLoc, 1, &m_Id.x);
+            abcg::glUniform4fv(IsLoc, 1, &m_Is.x);
+        }
+        m_uniformsCameraVersion = m_camera.getVersion();
+    }
 
-    abcg::glUseProgram(m_program);
+    // Update the world matrices of the nodes that moved, then compute the
+    // model, model-view, model-view-projection and normal matrices of every
+    // object in one pass
+    // The objects are drawn between their last two simulated states. Once
+    // the game is over nothing moves, so the last state is drawn.
+    const auto &snapshot{m_snapshots.getReadBuffer()};
+    const auto playing{snapshot.gameData.m_state == State::Playing};
+    const auto alpha{playing ? static_cast<float>(getInterpolationAlpha()) : 1.0f};
+    {
+        ABCG_PROFILE_SCOPE("Scene update");
+        m_ground.updateNodes(m_scene, snapshot.ground, alpha);
+        m_player.updateNodes(m_scene, snapshot.player, alpha);
+        m_enemies.updateNodes(m_scene, snapshot.enemies, alpha);
+        m_scene.update(m_transforms);
+        m_transforms.update(m_camera.getViewMatrix(), m_camera.getProjMatrix());
+    }
 
-    // Get location of uniform variables (could be precomputed)
-    GLint viewMatrixLoc{abcg::glGetUniformLocation(m_program, "viewMatrix")};
-    GLint projMatrixLoc{abcg::glGetUniformLocation(m_program, "projMatrix")};
-    GLint lightDirLoc{abcg::glGetUniformLocation(m_program, "lightDirWorldSpace")}; 
-    GLint IaLoc{abcg::glGetUniformLocation(m_program, "Ia")};
-    GLint IdLoc{abcg::glGetUniformLocation(m_program, "Id")};
-    GLint IsLoc{abcg::glGetUniformLocation(m_program, "Is")};
+    // Bin the lights of the frame into the clusters of the view frustum
+    {
+        ABCG_PROFILE_SCOPE("Light binning");
+        ABCG_GPU_SCOPE("Light binning");
+        m_lights.clear();
+        m_ground.addLights(m_lights, m_scene);
+        m_player.addLights(m_lights, m_scene);
+        m_enemies.addLights(m_lights, m_scene);
+        m_clusteredLights.update(m_lights, m_camera.getViewMatrix());
+        m_clusteredLights.bind(m_program, 2, getRenderWidth(), getRenderHeight());
+    }
 
-    // Set uniform variables for viewMatrix and projMatrix
-    // These matrices are used for every scene object
-    abcg::glUniformMatrix4fv(viewMatrixLoc, 1, GL_FALSE, &m_camera.m_viewMatrix[0][0]);
-    abcg::glUniformMatrix4fv(projMatrixLoc, 1, GL_FALSE, &m_camera.m_projMatrix[0][0]);
+    // Objects outside the view frustum of the camera are not submitted
+    m_cullingStats = {};
 
-    abcg::glUniform4fv(lightDirLoc, 1, &m_lightDir.x);
-    abcg::glUniform4fv(IaLoc, 1, &m_Ia.x);
-    abcg::glUniform4fv(IdLoc, 1, &m_Id.x);
-    abcg::glUniform4fv(IsLoc, 1, &m_Is.x);
+    // Collect this frame's draws and replay them front to back, or sorted by
+    // state after a depth pre-pass
+    {
+        ABCG_PROFILE_SCOPE("Render queue");
+        ABCG_GPU_SCOPE("Render queue");
+        m_renderQueue.begin(m_camera.getViewMatrix(), m_camera.getProjMatrix());
+        m_ground.submit(m_renderQueue, m_camera.getFrustum(), m_transforms, m_cullingStats);
+        m_player.submit(m_renderQueue, m_camera.getFrustum(), m_transforms, m_cullingStats);
+        m_enemies.submit(m_renderQueue, m_camera.getFrustum(), m_transforms, m_cullingStats);
+        m_renderQueue.flush();
+    }
 
+    // Test the cars' bounding boxes against this frame's depth buffer. The
+    // results are used in later frames, so the CPU never waits for them.
+    {
+        ABCG_PROFILE_SCOPE("Occlusion queries");
+        ABCG_GPU_SCOPE("Occlusion queries");
+        m_occlusionCuller.begin(m_camera.getViewProjMatrix(), m_camera.getEye());
+        m_enemies.queryOcclusion(m_occlusionCuller, m_scene);
+        m_occlusionCuller.end();
+    }
 
-    m_ground.paintGL();
-    m_player.paintGL();
-    m_enemies.paintGL();
-    // abcg::glUseProgram(0);
+#if defined(ABCG_GL_STATE_CACHE)
+    m_glStateStats = abcg::glStateCache.getStats();
+    abcg::glStateCache.resetStats();
+#endif
 }
 
 void OpenGLWindow::paintUI() {
     abcg::OpenGLWindow::paintUI();
 
+    // paintUI() runs before paintGL(), so the latest state is taken here and
+    // drawn by both
+    m_snapshots.update();
+    const auto &gameData{m_snapshots.getReadBuffer().gameData};
+
+    // Nothing moves on the game over screen, so only draw a few frames per
+    // second until the game restarts
+    setIdle(gameData.m_state != State::Playing, 0.1);
+
     {
-        if (m_gameData.m_state == State::GameOver) {
+        if (gameData.m_state == State::GameOver) {
             auto size{ImVec2(400, 400)};
             auto position{ImVec2((m_viewportWidth - size.x) / 2.0f, (m_viewportHeight - size.y) / 2.0f)};
             ImGui::SetNextWindowPos(position);
@@ -112,10 +247,10 @@ void OpenGLWindow::paintUI() {
                                 ImGuiWindowFlags_NoInputs};
             ImGui::Begin(" ", nullptr, flags);
             ImGui::PushFont(m_font);
-            ImGui::Text("Game Over\nYour Score:\n%.2f Km", m_gameData.gameScore);
+            ImGui::Text("Game Over\nYour Score:\n%.2f Km", gameData.gameScore);
     }
 
-    if (m_gameData.m_state == State::Playing) {
+    if (gameData.m_state == State::Playing) {
         auto size{ImVec2(600, 600)};
         auto position{ImVec2((m_viewportWidth - size.x) / 2.0f, (m_viewportHeight - size.y) / 2.0f)};
         ImGui::SetNextWindowPos(position);
@@ -125,30 +260,77 @@ void OpenGLWindow::paintUI() {
                             ImGuiWindowFlags_NoInputs};
         ImGui::Begin(" ", nullptr, flags);
         ImGui::PushFont(m_font);
-        ImGui::Text("Score:%.2f Km", m_gameData.gameScore);
+        ImGui::Text("Score:%.2f Km", gameData.gameScore);
     }
 
     ImGui::PopFont();
     ImGui::End();
     }
+
+    // Render queue statistics of the last frame
+    {
+        const auto &stats{m_renderQueue.getStats()};
+        ImGui::SetNextWindowPos(ImVec2(5, m_viewportHeight - 310.0f));
+        ImGuiWindowFlags flags{ImGuiWindowFlags_NoBackground |
+                            ImGuiWindowFlags_NoTitleBar |
+                            ImGuiWindowFlags_NoInputs |
+                            ImGuiWindowFlags_AlwaysAutoResize};
+        ImGui::Begin("Render stats", nullptr, flags);
+        ImGui::Text("Objects drawn/culled/occluded: %zu/%zu/%zu",
+                    m_cullingStats.drawn, m_cullingStats.culled,
+                    m_cullingStats.occluded);
+        ImGui::Text("Resolution scale (R): %.2f (%dx%d)",
+                    getResolutionScale(), getRenderWidth(), getRenderHeight());
+        ImGui::Text("Lights/max per cluster: %zu/%zu",
+                    m_clusteredLights.getNumLights(),
+                    m_clusteredLights.getMaxLightsPerCluster());
+        ImGui::Text("Scene nodes updated: %zu/%zu", m_scene.getNumUpdated(),
+                    m_scene.size());
+        ImGui::Text("Depth pre-pass (P): %s",
+                    m_renderQueue.isDepthPrepassEnabled() ? "on" : "off");
+        ImGui::Text("Draw calls/pre-pass: %zu/%zu", stats.drawCalls,
+                    stats.prepassDrawCalls);
+        ImGui::Text("Program changes: %zu", stats.programChanges);
+        ImGui::Text("Material changes: %zu", stats.materialChanges);
+        ImGui::Text("Texture changes: %zu", stats.textureChanges);
+        ImGui::Text("Mesh changes: %zu", stats.meshChanges);
+        ImGui::Text("Multi-draw indirect: %s",
+                    m_enemies.m_batch.isIndirect() ? "on" : "off");
+        ImGui::Text("Persistent mapping: %s",
+                    m_enemies.m_instanceBuffer.isPersistent() ? "on" : "off");
+        ImGui::Text("Separate vertex format: %s",
+                    m_enemies.m_batch.getLayout().isSeparate() ? "on" : "off");
+#if defined(ABCG_GL_STATE_CACHE)
+        ImGui::Text("GL calls issued/elided: %zu/%zu", m_glStateStats.issued,
+                    m_glStateStats.elided);
+#endif
+        ImGui::End();
+    }
 }
 
 void OpenGLWindow::resizeGL(int width, int height) {
     m_viewportWidth = width;
     m_viewportHeight = height;
 
-    m_camera.computeProjectionMatrix(width, height);
+    const auto aspect{static_cast<float>(width) / static_cast<float>(height)};
+    m_camera.setPerspective(glm::radians(50.0f), aspect, 0.01f, 100.0f);
+    m_camera.update();
+    m_clusteredLights.setProjection(m_camera.getProjMatrix());
 }
 
 void OpenGLWindow::terminateGL() {
     m_ground.terminateGL();
     m_player.terminateGL();
     m_enemies.terminateGL();
+    m_meshArena.terminateGL();
 
     abcg::glDeleteProgram(m_program);
-    abcg::glDeleteBuffers(1, &m_EBO);
-    abcg::glDeleteBuffers(1, &m_VBO);
-    abcg::glDeleteVertexArrays(1, &m_VAO);
+    abcg::glDeleteProgram(m_instancedProgram);
+    abcg::glDeleteProgram(m_depthProgram);
+    abcg::glDeleteProgram(m_depthInstancedProgram);
+    m_occlusionCuller.terminateGL();
+    m_clusteredLights.terminateGL();
+    abcg::glDeleteProgram(m_occlusionProgram);
 }
 
 void OpenGLWindow::restart() {
@@ -157,24 +339,17 @@ void OpenGLWindow::restart() {
     m_gameData.gameScore = 0;
     m_gameData.gameSpeed = 1;
 
-    m_player.loadDiffuseTexture(getAssetsPath() + "maps/Car_texture.png");
-    m_player.loadObj(getAssetsPath() + "DeLorean_DMC-12_lowpoly_material.obj");
-    
-    m_enemies.loadObj(getAssetsPath() + "DeLorean_DMC-12_lowpoly.obj");
-
-    m_ground.loadDiffuseTexture(getAssetsPath() + "maps/TexturesCom_Roads0148_1_seamless_S.jpg");
-    m_ground.loadObj(getAssetsPath() + "GroundLong.obj");
-
-    m_player.m_mappingMode = 3;  // "From mesh" option
-    m_ground.m_mappingMode = 3;  // "From mesh" option
-
-    m_ground.initializeGL(m_program);
-    m_player.initializeGL(m_program);
-    m_enemies.initializeGL(m_program);
+    m_ground.reset();
+    m_player.reset();
+    m_enemies.reset();
 }
 
-void OpenGLWindow::update() {
-    const float deltaTime{static_cast<float>(getDeltaTime())};
+void OpenGLWindow::update(double fixedDeltaTime) {
+    // Called with a fixed step on a thread of its own, so collisions are
+    // checked at the same positions at any frame rate, and the simulation
+    // overlaps with drawing
+    const float deltaTime{static_cast<float>(fixedDeltaTime)};
+    m_gameData.m_input = decltype(m_gameData.m_input){m_input.load(std::memory_order_relaxed)};
 
     // increase score
     if (m_gameData.m_state == State::Playing) {
@@ -186,15 +361,28 @@ void OpenGLWindow::update() {
         checkCollisions();
     }
 
-    // Wait 3 seconds before restarting
-    if (m_gameData.m_state != State::Playing && m_restartWaitTimer.elapsed() > 3) {
-        restart();
+    // Wait 3 seconds before restarting. The time is simulated, not measured,
+    // so that a replayed session restarts at the same step.
+    if (m_gameData.m_state != State::Playing) {
+        m_restartWaitTime += deltaTime;
+        if (m_restartWaitTime > 3) restart();
     }
 
-    m_camera.computeViewMatrix();
+    publishSnapshot();
+}
+
+void OpenGLWindow::publishSnapshot() {
+    // Every member is written, as the buffer holds an older snapshot
+    auto &snapshot{m_snapshots.getWriteBuffer()};
+    snapshot.gameData = m_gameData;
+    snapshot.player = m_player.getState();
+    snapshot.ground = m_ground.getState();
+    snapshot.enemies = m_enemies.getState();
+    m_snapshots.publish();
 }
 
 void OpenGLWindow::checkCollisions() {
+    ABCG_PROFILE_SCOPE("checkCollisions");
     // Check collision between Player and enemies
     for (const auto index : iter::range(m_enemies.m_numCars)) {
         auto &position{m_enemies.m_enemiesPositions.at(index)};
@@ -203,7 +391,7 @@ void OpenGLWindow::checkCollisions() {
 
         if (distance_x < 0.7 && distance_z < 2.25) {
             m_gameData.m_state = State::GameOver;
-            m_restartWaitTimer.restart();
+            m_restartWaitTime = 0.0f;
         }
     }
 }
\ No newline at end of file
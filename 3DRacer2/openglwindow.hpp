@@ -3,12 +3,12 @@
 
 #include <imgui.h>
 
+#include <atomic>
 #include <vector>
 
 #include "abcg.hpp"
 #include "player.hpp"
 #include "gamedata.hpp"
-#include "camera.hpp"
 #include "ground.hpp"
 #include "enemies.hpp"
 
@@ -20,29 +20,54 @@ class OpenGLWindow : public abcg::OpenGLWindow {
         void paintUI() override;
         void resizeGL(int width, int height) override;
         void terminateGL() override;
+        void update(double deltaTime) override;
         void checkCollisions();
 
     private:
-        GLuint m_VAO{};
-        GLuint m_VBO{};
-        GLuint m_EBO{};
         GLuint m_program{};
+        GLuint m_instancedProgram{};
+        GLuint m_occlusionProgram{};
+        GLuint m_depthProgram{};
+        GLuint m_depthInstancedProgram{};
 
         GameData m_gameData;
+        // Keys held, set by handleEvent() and read by update(), which runs on
+        // a thread of its own
+        std::atomic<unsigned long> m_input{};
         Player m_player;
-        Camera m_camera;
+        // Camera shared by every pass, and its version when the uniforms of
+        // the programs were last set
+        abcg::Camera m_camera;
+        std::uint64_t m_uniformsCameraVersion{};
         Ground m_ground;
         Enemy m_enemies;
 
-        abcg::ElapsedTimer m_restartWaitTimer;
+        // Shared buffers and VAO of every mesh with the Vertex layout
+        static const GLuint m_maxVertices{1 << 18};
+        static const GLuint m_maxIndices{1 << 19};
+        abcg::MeshArena m_meshArena;
+
+        // Transforms of every object, whose matrices are computed at once, and
+        // the hierarchy of objects and attached lights that feeds them
+        abcg::TransformBatch m_transforms;
+        abcg::SceneGraph m_scene;
+        abcg::RenderQueue m_renderQueue;
+        abcg::OcclusionCuller m_occlusionCuller;
+        // Headlights, tail lights and street lamps of the frame
+        abcg::ClusteredLights m_clusteredLights;
+        std::vector<abcg::ClusteredLights::Light> m_lights;
+        CullingStats m_cullingStats;
+#if defined(ABCG_GL_STATE_CACHE)
+        abcg::GLStateCache::Stats m_glStateStats;
+#endif
+
+        // Simulated time since the game was over
+        float m_restartWaitTime{};
         ImFont* m_font{};
 
         int m_viewportWidth{};
         int m_viewportHeight{};
 
-        std::vector<Vertex> m_vertices;
-        std::vector<GLuint> m_indices;
-        
         // Light and material properties
         glm::vec4 m_lightDir{-0.25f, -1.0f, 0.25f, 0.0f};
         glm::vec4 m_Ia{1.0f, 1.0f, 1.0f, 1.0f};
@@ -51,8 +76,18 @@ class OpenGLWindow : public abcg::OpenGLWindow {
 
         std::array<float, 4> m_clearColor{0.5f, 0.7f, 1.0f, 1.0f};
 
-        void update();
+        // Game state published by update() at the end of every step, and
+        // drawn by paintUI() and paintGL() while the next steps run
+        struct Snapshot {
+            GameData gameData;
+            Player::State player;
+            Ground::State ground;
+            Enemy::State enemies;
+        };
+        abcg::TripleBuffer<Snapshot> m_snapshots;
+
         void restart();
+        void publishSnapshot();
 };
 
 #endif
\ No newline at end of file
@@ -26,6 +26,18 @@ void Player::loadDiffuseTexture(std::string_view path) {
 
     abcg::glDeleteTextures(1, &m_diffuseTexture);
     m_diffuseTexture = abcg::opengl::loadTexture(path);
+
+    // Sampling parameters belong to the texture object, so set them only once
+    abcg::glBindTexture(GL_TEXTURE_2D, m_diffuseTexture);
+
+    // Set minification and magnification parameters
+    abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    // Set texture wrapping parameters
+    abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    abcg::glBindTexture(GL_TEXTURE_2D, 0);
 }
 
 void Player::loadObj(std::string_view path, bool standardize) {
@@ -117,25 +129,33 @@ void Player::loadObj(std::string_view path, bool standardize) {
     // Use properties of first material, if available
     if (!materials.empty()) {
         const auto& mat{materials.at(0)};  // First material
-        m_Ka = glm::vec4(mat.ambient[0], mat.ambient[1], mat.ambient[2], 1);
-        m_Kd = glm::vec4(mat.diffuse[0], mat.diffuse[1], mat.diffuse[2], 1);
-        m_Ks = glm::vec4(mat.specular[0], mat.specular[1], mat.specular[2], 1);
-        m_shininess = mat.shininess;
-
-        if (!mat.diffuse_texname.empty())
-        loadDiffuseTexture(basePath + mat.diffuse_texname);
+        m_material.Ka = glm::vec4(mat.ambient[0], mat.ambient[1], mat.ambient[2], 1);
+        m_material.Kd = glm::vec4(mat.diffuse[0], mat.diffuse[1], mat.diffuse[2], 1);
+        m_material.Ks = glm::vec4(mat.specular[0], mat.specular[1], mat.specular[2], 1);
+        m_material.shininess = mat.shininess;
+
+        // The model may be loaded by a worker thread, but textures can only be
+        // created by the thread of the OpenGL context
+        if (!mat.diffuse_texname.empty()) {
+            abcg::JobSystem::getInstance().submitToMainThread(
+                [this, texturePath = basePath + mat.diffuse_texname] {
+                    loadDiffuseTexture(texturePath);
+                });
+        }
     } else {
         // Default values
-        m_Ka = {0.1f, 0.1f, 0.1f, 1.0f};
-        m_Kd = {0.7f, 0.7f, 0.7f, 1.0f};
-        m_Ks = {1.0f, 1.0f, 1.0f, 1.0f};
-        m_shininess = 25.0f;
+        m_material.Ka = {0.1f, 0.1f, 0.1f, 1.0f};
+        m_material.Kd = {0.7f, 0.7f, 0.7f, 1.0f};
+        m_material.Ks = {1.0f, 1.0f, 1.0f, 1.0f};
+        m_material.shininess = 25.0f;
     }
 
     if (standardize) {
         this->standardize();
     }
 
+    m_bounds = computeBounds(m_vertices);
+
     if (!m_hasNormals) {
         computeNormals();
     }
@@ -196,116 +216,98 @@ void Player::computeNormals() {
     m_hasNormals = true;
 }
 
-void Player::initializeGL(GLuint program) {
-    terminateGL();
-    m_translation = glm::vec3(0.0f, 0.0f, -5.0f);
-    m_angle = 180.0f;
-
+void Player::initializeGL(GLuint program, GLuint depthProgram, abcg::MeshArena &arena,
+                          abcg::TransformBatch &transforms, abcg::SceneGraph &scene) {
     m_program = program;
-
-    // Generate VBO
-    abcg::glGenBuffers(1, &m_VBO);
-    abcg::glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-    abcg::glBufferData(GL_ARRAY_BUFFER, sizeof(m_vertices[0]) * m_vertices.size(), m_vertices.data(), GL_STATIC_DRAW);
-    abcg::glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-    // Generate EBO
-    abcg::glGenBuffers(1, &m_EBO);
-    abcg::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
-    abcg::glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(m_indices[0]) * m_indices.size(), m_indices.data(), GL_STATIC_DRAW);
-    abcg::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
-    // Create VAO
-    abcg::glGenVertexArrays(1, &m_VAO);
-
-    // Bind vertex attributes to current VAO
-    abcg::glBindVertexArray(m_VAO);
-
-    abcg::glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-    const GLint positionAttribute{abcg::glGetAttribLocation(m_program, "inPosition")};
-    if (positionAttribute >= 0) {
-        abcg::glEnableVertexAttribArray(positionAttribute);
-        abcg::glVertexAttribPointer(positionAttribute, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), nullptr);
-    }
-
-    const GLint normalAttribute{abcg::glGetAttribLocation(program, "inNormal")};
-    if (normalAttribute >= 0) {
-        abcg::glEnableVertexAttribArray(normalAttribute);
-        GLsizei offset{sizeof(glm::vec3)};
-        abcg::glVertexAttribPointer(normalAttribute, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offset));
-    }
-
-    const GLint texCoordAttribute{abcg::glGetAttribLocation(program, "inTexCoord")};
-    if (texCoordAttribute >= 0) {
-        abcg::glEnableVertexAttribArray(texCoordAttribute);
-        GLsizei offset{sizeof(glm::vec3) + sizeof(glm::vec3)};
-        abcg::glVertexAttribPointer(texCoordAttribute, 2, GL_FLOAT, GL_FALSE,
-                                    sizeof(Vertex),
-                                    reinterpret_cast<void*>(offset));
+    m_depthProgram = depthProgram;
+    m_transform = transforms.add();
+    m_node = scene.add(abcg::SceneGraph::noParent, glm::vec3(0.0f),
+                       glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.0f), m_transform);
+
+    // Headlights at the front of the car and tail lights at the back, which
+    // follow the car without any work while it does not move
+    const auto width{m_bounds.max.x - m_bounds.min.x};
+    const auto height{glm::mix(m_bounds.min.y, m_bounds.max.y, 0.4f)};
+    for (const auto side : {0, 1}) {
+        const auto x{(side == 0 ? -0.3f : 0.3f) * width};
+        m_headlightNodes.at(side) = scene.add(m_node, glm::vec3(x, height, m_bounds.max.z));
+        m_tailLightNodes.at(side) = scene.add(m_node, glm::vec3(x, height, m_bounds.min.z));
     }
 
-
-    abcg::glBindBuffer(GL_ARRAY_BUFFER, 0);
-    abcg::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
-
-    // End of binding to current VAO
-    abcg::glBindVertexArray(0);
+    // Copy the mesh to the shared buffers, replacing any previous one
+    arena.free(m_mesh);
+    m_mesh = arena.allocate<Vertex>(m_vertices, m_indices);
+    m_VAO = arena.getVAO();
 }
 
-void Player::paintGL() {
-    abcg::glUseProgram(m_program);
-
-    // Get location of uniform variables (could be precomputed)
-    GLint modelMatrixLoc{abcg::glGetUniformLocation(m_program, "modelMatrix")};
-    GLint normalMatrixLoc{abcg::glGetUniformLocation(m_program, "normalMatrix")};
-    GLint shininessLoc{abcg::glGetUniformLocation(m_program, "shininess")};
-    GLint KaLoc{abcg::glGetUniformLocation(m_program, "Ka")};
-    GLint KdLoc{abcg::glGetUniformLocation(m_program, "Kd")};
-    GLint KsLoc{abcg::glGetUniformLocation(m_program, "Ks")};
-    GLint diffuseTexLoc{abcg::glGetUniformLocation(m_program, "diffuseTex")};
-    GLint mappingModeLoc{abcg::glGetUniformLocation(m_program, "mappingMode")};  
-
-    m_playerPos = glm::mat4{1.0f};
-    m_playerPos = glm::translate(m_playerPos, m_translation); // moves player slightly forward
-    m_playerPos = glm::rotate(m_playerPos, glm::radians(m_angle), glm::vec3(0.0f, 1.0f, 0.0f)); // no initial rotation
-    m_playerPos = glm::scale(m_playerPos, glm::vec3(1.0f)); // no further scaling
-
-    // Set uniform variables of the current object
-    abcg::glUniformMatrix4fv(modelMatrixLoc, 1, GL_FALSE, &m_playerPos[0][0]);
-    abcg::glUniform1i(diffuseTexLoc, 0);
-    abcg::glUniform1i(mappingModeLoc, m_mappingMode);
-
-    abcg::glUniform1f(shininessLoc, m_shininess);
-    abcg::glUniform4fv(KaLoc, 1, &m_Ka.x);
-    abcg::glUniform4fv(KdLoc, 1, &m_Kd.x);
-    abcg::glUniform4fv(KsLoc, 1, &m_Ks.x);
-
-    abcg::glBindVertexArray(m_VAO);
-
-    m_camera.computeViewMatrix();
-    auto modelViewMatrix{glm::mat3(m_camera.m_viewMatrix * m_playerPos)};
-    glm::mat3 normalMatrix{glm::inverseTranspose(modelViewMatrix)};
-    abcg::glUniformMatrix3fv(normalMatrixLoc, 1, GL_FALSE, &normalMatrix[0][0]);
-
-    abcg::glActiveTexture(GL_TEXTURE0);
-    abcg::glBindTexture(GL_TEXTURE_2D, m_diffuseTexture);
+void Player::reset() {
+    m_translation = glm::vec3(0.0f, 0.0f, -5.0f);
+    m_angle = 180.0f;
+    m_previousTranslation = m_translation;
+    m_previousAngle = m_angle;
+}
 
-    // Set minification and magnification parameters
-    abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+Player::State Player::getState() const {
+    return {.previousTranslation{m_previousTranslation},
+            .translation{m_translation},
+            .previousAngle{m_previousAngle},
+            .angle{m_angle}};
+}
 
-    // Set texture wrapping parameters
-    abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+void Player::updateNodes(abcg::SceneGraph &scene, const State &state, float alpha) const {
+    // The node only changes if the car moved
+    const auto translation{glm::mix(state.previousTranslation, state.translation, alpha)};
+    const auto angle{glm::mix(state.previousAngle, state.angle, alpha)};
+    scene.setTranslation(m_node, translation); // moves player slightly forward
+    scene.setRotation(m_node, glm::angleAxis(glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f)));
+}
 
-    // abcg::glUniform4f(colorLoc, 1.0f, 1.0f, 1.0f, 1.0f);
-    abcg::glDrawElements(GL_TRIANGLES, m_indices.size(), GL_UNSIGNED_INT, nullptr);
+void Player::submit(abcg::RenderQueue &queue, const abcg::Frustum &frustum,
+                    const abcg::TransformBatch &transforms, CullingStats &stats) {
+    const auto &modelMatrix{transforms.getModelMatrix(m_transform)};
+    if (!frustum.intersects(transformSphere(modelMatrix, m_bounds.sphere))) {
+        ++stats.culled;
+        return;
+    }
+    ++stats.drawn;
+
+    abcg::RenderQueue::DrawItem item;
+    item.program = m_program;
+    item.depthProgram = m_depthProgram;
+    item.VAO = m_VAO;
+    item.count = static_cast<GLsizei>(m_mesh.count);
+    item.firstIndex = m_mesh.firstIndex;
+    item.baseVertex = m_mesh.baseVertex;
+    item.textures = {m_diffuseTexture};
+    item.material = &m_material;
+    item.transforms = &transforms;
+    item.transform = m_transform;
+    queue.submit(item);
+}
 
-    abcg::glBindVertexArray(0);
-    abcg::glUseProgram(0);
+void Player::addLights(std::vector<abcg::ClusteredLights::Light> &lights,
+                       const abcg::SceneGraph &scene) const {
+    // Lights placed with the cached world matrices of their nodes
+    for (const auto side : {0, 1}) {
+        const auto &headlightMatrix{scene.getWorldMatrix(m_headlightNodes.at(side))};
+        lights.push_back({.position{headlightMatrix[3]},
+                          .radius{15.0f},
+                          .color{8.0f, 7.6f, 6.4f},
+                          .direction{glm::mat3(headlightMatrix) * glm::vec3(0.0f, -0.1f, 1.0f)},
+                          .cosInnerCone{0.95f},
+                          .cosOuterCone{0.85f}});
+
+        const auto &tailLightMatrix{scene.getWorldMatrix(m_tailLightNodes.at(side))};
+        lights.push_back({.position{tailLightMatrix[3]},
+                          .radius{2.0f},
+                          .color{4.0f, 0.0f, 0.0f}});
+    }
 }
 
 void Player::update(const GameData &gameData, float deltaTime) {
+    m_previousTranslation = m_translation;
+    m_previousAngle = m_angle;
+
     // Move
     if (gameData.m_input[static_cast<size_t>(Input::Left)] && m_translation.x>-2) {
         m_translation.x -= 5.0 * deltaTime;
@@ -327,18 +329,20 @@ void Player::update(const GameData &gameData, float deltaTime) {
         }
         // m_angle = 135;
     }
+    // Straighten up without overshooting, so that the car stops changing
     if (! gameData.m_input[static_cast<size_t>(Input::Left)] && 
         ! gameData.m_input[static_cast<size_t>(Input::Right)] &&
         m_angle > 180)
-        m_angle -= 200 * deltaTime;
+        m_angle = std::max(m_angle - 200 * deltaTime, 180.0f);
     if (! gameData.m_input[static_cast<size_t>(Input::Left)] && 
         ! gameData.m_input[static_cast<size_t>(Input::Right)] &&
         m_angle < 180)
-        m_angle += 200 * deltaTime;
+        m_angle = std::min(m_angle + 200 * deltaTime, 180.0f);
 }
 
 void Player::terminateGL() {
-    abcg::glDeleteBuffers(1, &m_EBO);
-    abcg::glDeleteBuffers(1, &m_VBO);
-    abcg::glDeleteVertexArrays(1, &m_VAO);
+    // The mesh is released with the arena
+    m_mesh = {};
+    abcg::glDeleteTextures(1, &m_diffuseTexture);
+    m_diffuseTexture = 0;
 }
\ No newline at end of file
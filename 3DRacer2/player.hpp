@@ -10,10 +10,25 @@ class OpenGLWindow;
 
 class Player {
     public:
+        // State drawn by the render thread, published by the update thread
+        struct State {
+            glm::vec3 previousTranslation{};
+            glm::vec3 translation{};
+            float previousAngle{};
+            float angle{};
+        };
+
         void loadDiffuseTexture(std::string_view path);
         void loadObj(std::string_view path, bool standardize = true);
-        void initializeGL(GLuint program);
-        void paintGL();
+        void initializeGL(GLuint program, GLuint depthProgram, abcg::MeshArena &arena,
+                          abcg::TransformBatch &transforms, abcg::SceneGraph &scene);
+        void reset();
+        [[nodiscard]] State getState() const;
+        void updateNodes(abcg::SceneGraph &scene, const State &state, float alpha) const;
+        void submit(abcg::RenderQueue &queue, const abcg::Frustum &frustum,
+                    const abcg::TransformBatch &transforms, CullingStats &stats);
+        void addLights(std::vector<abcg::ClusteredLights::Light> &lights,
+                       const abcg::SceneGraph &scene) const;
         void terminateGL();
         void update(const GameData &gameData, float deltaTime);
 
@@ -21,42 +36,45 @@ class Player {
         return static_cast<int>(m_indices.size()) / 3;
         }
         
-        [[nodiscard]] glm::vec4 getKa() const { return m_Ka; }
-        [[nodiscard]] glm::vec4 getKd() const { return m_Kd; }
-        [[nodiscard]] glm::vec4 getKs() const { return m_Ks; }
-        [[nodiscard]] float getShininess() const { return m_shininess; }
+        [[nodiscard]] glm::vec4 getKa() const { return m_material.Ka; }
+        [[nodiscard]] glm::vec4 getKd() const { return m_material.Kd; }
+        [[nodiscard]] glm::vec4 getKs() const { return m_material.Ks; }
+        [[nodiscard]] float getShininess() const { return m_material.shininess; }
 
         [[nodiscard]] bool isUVMapped() const { return m_hasTexCoords; }
 
     private:
 
         friend OpenGLWindow;
-        Camera m_camera;
 
+        // The mesh lives in the arena shared by every object
+        abcg::MeshArena::Mesh m_mesh;
         GLuint m_VAO{};
-        GLuint m_VBO{};
-        GLuint m_EBO{};
         GLuint m_program{};
+        GLuint m_depthProgram{};
 
         std::vector<Vertex> m_vertices;
         std::vector<GLuint> m_indices;
+        Bounds m_bounds;
 
         glm::vec3 m_translation{glm::vec3(0.0f)};
         float m_angle{};
-        glm::mat4 m_playerPos{glm::mat4{1.0f}};
+        // State before the last update, drawn interpolated with the current one
+        glm::vec3 m_previousTranslation{glm::vec3(0.0f)};
+        float m_previousAngle{};
+        // Index of the car in the transform batch and in the scene graph of
+        // the window, and the nodes of its lights, attached to the car
+        std::size_t m_transform{};
+        std::size_t m_node{};
+        std::array<std::size_t, 2> m_headlightNodes{};
+        std::array<std::size_t, 2> m_tailLightNodes{};
 
         void standardize();
         void computeNormals();
 
-        // Mapping mode
-        // 0: triplanar; 1: cylindrical; 2: spherical; 3: from mesh
-        int m_mappingMode{};  
-
-        // // Light and material properties
-        glm::vec4 m_Ka;
-        glm::vec4 m_Kd;
-        glm::vec4 m_Ks;
-        float m_shininess{25.0f};
+        // Light and material properties
+        // Mapping mode 0: triplanar; 1: cylindrical; 2: spherical; 3: from mesh
+        abcg::RenderQueue::Material m_material;
         GLuint m_diffuseTexture{};
 
         bool m_hasNormals{false};
@@ -11,9 +11,27 @@
 #define ABCG_HPP_
 
 #include "abcg_application.hpp"
+#include "abcg_camera.hpp"
+#include "abcg_clusteredlights.hpp"
+#include "abcg_framebuffer.hpp"
+#include "abcg_frustum.hpp"
+#include "abcg_gputimer.hpp"
 #include "abcg_image.hpp"
+#include "abcg_inputlog.hpp"
+#include "abcg_jobsystem.hpp"
+#include "abcg_mesharena.hpp"
+#include "abcg_multidrawbatch.hpp"
+#include "abcg_occlusionculler.hpp"
 #include "abcg_openglwindow.hpp"
+#include "abcg_profiler.hpp"
+#include "abcg_renderqueue.hpp"
+#include "abcg_scenegraph.hpp"
+#include "abcg_spritebatch.hpp"
+#include "abcg_streambuffer.hpp"
 #include "abcg_string.hpp"
 #include "abcg_trackball.hpp"
+#include "abcg_transformbatch.hpp"
+#include "abcg_triplebuffer.hpp"
+#include "abcg_vertexlayout.hpp"
 
 #endif
\ No newline at end of file
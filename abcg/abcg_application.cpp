@@ -10,7 +10,11 @@
 
 #include <fmt/core.h>
 
+#include <algorithm>
+#include <charconv>
 #include <span>
+#include <string_view>
+#include <thread>
 
 #include "SDL_image.h"
 #include "abcg_exception.hpp"
@@ -31,9 +35,69 @@ void abcg::mainLoopCallback(void *userData) {
  * Constructs an abcg::Application object and initializes SDL library and
  * subsystems.
  *
- * @throw abcg::Exception if SDL failed to initialize its subsystems.
+ * @param argc Number of command-line arguments.
+ * @param argv Command-line arguments, which may select the headless mode and
+ * input recording or replay.
+ *
+ * @throw abcg::Exception if SDL failed to initialize its subsystems, if the
+ * number of headless frames is invalid, or if the input log could not be
+ * opened.
  */
 abcg::Application::Application([[maybe_unused]] int argc, char **argv) {
+  m_randomSeed = static_cast<std::uint64_t>(
+      std::chrono::steady_clock::now().time_since_epoch().count());
+
+#if !defined(__EMSCRIPTEN__)
+  std::string_view recordPath;
+  std::string_view replayPath;
+  auto headlessFramesGiven{false};
+  for (std::string_view arg :
+       std::span{argv, static_cast<std::size_t>(argc)}.subspan(1)) {
+    if (arg == "--headless") {
+      m_headlessFrames = 600;
+    } else if (arg.starts_with("--headless=")) {
+      auto frames{arg.substr(arg.find('=') + 1)};
+      headlessFramesGiven = true;
+      if (auto [ptr, ec]{std::from_chars(
+              frames.data(), frames.data() + frames.size(), m_headlessFrames)};
+          ec != std::errc{} || ptr != frames.data() + frames.size() ||
+          m_headlessFrames <= 0) {
+        throw abcg::Exception{abcg::Exception::Runtime(
+            fmt::format("Invalid number of headless frames: {}", frames))};
+      }
+    } else if (arg.starts_with("--screenshot=")) {
+      m_screenshotPath = arg.substr(arg.find('=') + 1);
+    } else if (arg.starts_with("--record=")) {
+      recordPath = arg.substr(arg.find('=') + 1);
+    } else if (arg.starts_with("--replay=")) {
+      replayPath = arg.substr(arg.find('=') + 1);
+    }
+  }
+
+  // Headless runs draw the same random numbers each time, and replays draw
+  // those of the recorded session
+  if (m_headlessFrames > 0) m_randomSeed = 0;
+  if (!recordPath.empty() && !replayPath.empty()) {
+    throw abcg::Exception{
+        abcg::Exception::Runtime("Cannot record and replay input at once")};
+  }
+  if (!replayPath.empty()) {
+    m_inputLog.replay(replayPath);
+    m_randomSeed = m_inputLog.getSeed();
+    // Unless told otherwise, a headless replay lasts as long as the recording
+    if (m_headlessFrames > 0 && !headlessFramesGiven &&
+        m_inputLog.getNumSteps() > 0) {
+      m_headlessFrames = static_cast<int>(m_inputLog.getNumSteps());
+    }
+  }
+  if (!recordPath.empty()) m_inputLog.record(recordPath, m_randomSeed);
+
+  if (m_headlessFrames > 0) {
+    // Render without a display, unless another driver is chosen
+    SDL_setenv("SDL_VIDEODRIVER", "offscreen", 0);
+  }
+#endif
+
   Uint32 subsystemMask{SDL_INIT_TIMER | SDL_INIT_VIDEO | SDL_INIT_AUDIO |
                        SDL_INIT_JOYSTICK | SDL_INIT_GAMECONTROLLER |
                        SDL_INIT_EVENTS};
@@ -72,6 +136,8 @@ abcg::Application::Application([[maybe_unused]] int argc, char **argv) {
  * subsystems.
  */
 abcg::Application::~Application() {
+  // update() must not run while the window is destroyed
+  if (m_window != nullptr) m_window->stopUpdates();
 #if !defined(__EMSCRIPTEN__)
   IMG_Quit();
 #endif
@@ -96,16 +162,31 @@ void abcg::Application::run(std::unique_ptr<OpenGLWindow> window) {
 
 void abcg::Application::mainLoopIterator([[maybe_unused]] bool &done) {
   SDL_Event event{};
-  while (SDL_PollEvent(&event) != 0) {
+  auto hasEvent{false};
+#if !defined(__EMSCRIPTEN__)
+  // While idle, block until something happens instead of drawing frames that
+  // would all look the same
+  if (m_window->m_idle && m_headlessFrames == 0) {
+    const auto timeout{std::max(m_window->m_idleTimeout, 0.0) * 1000.0};
+    hasEvent = SDL_WaitEventTimeout(&event, static_cast<int>(timeout)) != 0;
+  }
+#endif
+  while (hasEvent || SDL_PollEvent(&event) != 0) {
+    hasEvent = false;
 #if !defined(__EMSCRIPTEN__)
     if (event.type == SDL_QUIT) done = true;
 #endif
     m_window->handleEvent(event, done);
   }
   m_window->paint();
+  if (m_window->m_headlessDone) done = true;
 }
 
 void abcg::Application::run() {
+  m_window->m_headlessFrames = m_headlessFrames;
+  m_window->m_screenshotPath = m_screenshotPath;
+  m_window->m_inputLog = std::move(m_inputLog);
+  m_window->m_randomSeed = m_randomSeed;
   m_window->initialize(m_basePath);
 
 #if defined(__EMSCRIPTEN__)
@@ -114,6 +195,35 @@ void abcg::Application::run() {
   bool done{};
   while (!done) {
     mainLoopIterator(done);
+    m_window->m_frameRateLimited = waitForNextFrame();
   };
+  m_window->stopUpdates();
+  m_window->m_inputLog.stop(m_window->m_numSteps.load());
 #endif
 }
+
+// Waits until the start of the next frame if the frame rate is limited. Most
+// of the time is slept, as a sleep may overshoot by a scheduler tick, and the
+// rest is spent polling the clock. Returns whether it waited.
+bool abcg::Application::waitForNextFrame() {
+  const auto maxFrameRate{m_window->m_openGLSettings.maxFrameRate};
+  if (maxFrameRate <= 0.0 || m_headlessFrames > 0) return false;
+
+  using Clock = std::chrono::steady_clock;
+  const auto period{std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(1.0 / maxFrameRate))};
+  const auto now{Clock::now()};
+
+  // After a slow frame, start over from now instead of catching up with
+  // shorter frames
+  m_nextFrameTime = std::max(m_nextFrameTime + period, now);
+
+  constexpr std::chrono::milliseconds spinTime{2};
+  if (m_nextFrameTime - now > spinTime) {
+    std::this_thread::sleep_for(m_nextFrameTime - now - spinTime);
+  }
+  while (Clock::now() < m_nextFrameTime) {
+    std::this_thread::yield();
+  }
+  return m_nextFrameTime > now;
+}
@@ -10,9 +10,13 @@
 #ifndef ABCG_APPLICATION_HPP_
 #define ABCG_APPLICATION_HPP_
 
+#include <chrono>
+#include <cstdint>
 #include <memory>
+#include <string>
 
 #include "abcg_exception.hpp"
+#include "abcg_inputlog.hpp"
 
 namespace abcg {
 class Application;
@@ -27,6 +31,29 @@ void mainLoopCallback(void* userData);
  *
  * This is the main application class that starts an ABCg application.
  *
+ * Outside WebAssembly, the application can also run headless as a benchmark,
+ * without a display, by passing these command-line arguments:
+ *
+ * - `--headless[=frames]`: renders the given number of frames (600 by default)
+ * to an offscreen framebuffer, prints the average frame time and exits. SDL
+ * uses its `offscreen` video driver, which creates an EGL context; set
+ * `SDL_VIDEODRIVER` to use another driver, or `LIBGL_ALWAYS_SOFTWARE=1` to
+ * force Mesa's software rasterizer.
+ * - `--screenshot=file.png`: in headless mode, saves the last frame to a PNG
+ * file.
+ *
+ * Any session can also record its keyboard and mouse input, and the seed of
+ * its random number generators, to an abcg::InputLog:
+ *
+ * - `--record=file.log`: records the session to a file.
+ * - `--replay=file.log`: replays a recorded session instead of the live
+ * input. With `--headless` and no number of frames, runs one frame per
+ * update step of the recording, so that the same run can be timed across
+ * builds.
+ *
+ * While recording or replaying, `threadedUpdate` is ignored: the update steps
+ * run on the thread that handles the events, so that each event reaches the
+ * same step in the recording and in the replay.
  */
 class abcg::Application {
  public:
@@ -43,10 +70,20 @@ class abcg::Application {
  private:
   void mainLoopIterator(bool& done);
   void run();
+  bool waitForNextFrame();
 
   std::string m_basePath;
   std::unique_ptr<OpenGLWindow> m_window;
 
+  int m_headlessFrames{};
+  std::string m_screenshotPath;
+
+  InputLog m_inputLog;
+  std::uint64_t m_randomSeed{};
+
+  // Start time of the next frame with a frame rate limit
+  std::chrono::steady_clock::time_point m_nextFrameTime;
+
 #if defined(__EMSCRIPTEN__)
   friend void mainLoopCallback(void* userData);
 #endif
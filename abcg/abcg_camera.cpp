@@ -0,0 +1,78 @@
+/**
+ * @file abcg_camera.cpp
+ * @brief Definition of abcg::Camera class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_camera.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+/**
+ * @brief Sets the position and orientation of the camera.
+ *
+ * The view matrix is only recomputed by update() if a parameter differs from
+ * the current one.
+ *
+ * @param eye Position of the camera.
+ * @param at Point the camera looks at.
+ * @param up Up direction.
+ */
+void abcg::Camera::setLookAt(const glm::vec3 &eye, const glm::vec3 &at,
+                             const glm::vec3 &up) {
+  if (eye == m_eye && at == m_at && up == m_up) return;
+  m_eye = eye;
+  m_at = at;
+  m_up = up;
+  m_viewChanged = true;
+}
+
+/**
+ * @brief Sets the perspective projection of the camera.
+ *
+ * The projection matrix is only recomputed by update() if a parameter
+ * differs from the current one.
+ *
+ * @param fovy Vertical field of view, in radians.
+ * @param aspect Width to height ratio of the viewport.
+ * @param zNear Distance to the near plane.
+ * @param zFar Distance to the far plane.
+ */
+void abcg::Camera::setPerspective(float fovy, float aspect, float zNear,
+                                  float zFar) {
+  if (fovy == m_fovy && aspect == m_aspect && zNear == m_zNear &&
+      zFar == m_zFar) {
+    return;
+  }
+  m_fovy = fovy;
+  m_aspect = aspect;
+  m_zNear = zNear;
+  m_zFar = zFar;
+  m_projChanged = true;
+}
+
+/**
+ * @brief Recomputes the matrices and the frustum if the camera changed.
+ *
+ * @return Whether the camera changed, and its version was incremented.
+ */
+bool abcg::Camera::update() {
+  if (!m_viewChanged && !m_projChanged) return false;
+
+  if (m_viewChanged) {
+    m_viewMatrix = glm::lookAt(m_eye, m_at, m_up);
+    m_inverseViewMatrix = glm::inverse(m_viewMatrix);
+  }
+  if (m_projChanged) {
+    m_projMatrix = glm::perspective(m_fovy, m_aspect, m_zNear, m_zFar);
+  }
+  m_viewProjMatrix = m_projMatrix * m_viewMatrix;
+  m_inverseViewProjMatrix = glm::inverse(m_viewProjMatrix);
+  m_frustum.update(m_viewProjMatrix);
+
+  m_viewChanged = false;
+  m_projChanged = false;
+  ++m_version;
+  return true;
+}
@@ -0,0 +1,91 @@
+/**
+ * @file abcg_camera.hpp
+ * @brief abcg::Camera header file.
+ *
+ * Declaration of abcg::Camera class.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_CAMERA_HPP_
+#define ABCG_CAMERA_HPP_
+
+#include <cstdint>
+#include <glm/mat4x4.hpp>
+#include <glm/trigonometric.hpp>
+#include <glm/vec3.hpp>
+
+#include "abcg_frustum.hpp"
+
+namespace abcg {
+class Camera;
+}  // namespace abcg
+
+/**
+ * @brief abcg::Camera class.
+ *
+ * Perspective camera shared by everything that is drawn from it.
+ *
+ * The setters only store the parameters. update() then computes the view,
+ * projection and view-projection matrices, their inverses and the view
+ * frustum, but only if a parameter changed since the last update. Each
+ * update that recomputes them also increments a version number, so that
+ * state derived from the camera, such as uniforms already set in a program,
+ * can be kept for as long as the version does not change.
+ *
+ * Objects should hold a reference to the camera instead of a copy, so that
+ * they all see the same matrices in a frame.
+ */
+class abcg::Camera {
+ public:
+  void setLookAt(const glm::vec3 &eye, const glm::vec3 &at,
+                 const glm::vec3 &up = glm::vec3{0.0f, 1.0f, 0.0f});
+  void setPerspective(float fovy, float aspect, float zNear, float zFar);
+  bool update();
+
+  [[nodiscard]] const glm::vec3 &getEye() const noexcept { return m_eye; }
+  [[nodiscard]] const glm::vec3 &getAt() const noexcept { return m_at; }
+  [[nodiscard]] const glm::vec3 &getUp() const noexcept { return m_up; }
+  [[nodiscard]] const glm::mat4 &getViewMatrix() const noexcept {
+    return m_viewMatrix;
+  }
+  [[nodiscard]] const glm::mat4 &getProjMatrix() const noexcept {
+    return m_projMatrix;
+  }
+  [[nodiscard]] const glm::mat4 &getViewProjMatrix() const noexcept {
+    return m_viewProjMatrix;
+  }
+  [[nodiscard]] const glm::mat4 &getInverseViewMatrix() const noexcept {
+    return m_inverseViewMatrix;
+  }
+  [[nodiscard]] const glm::mat4 &getInverseViewProjMatrix() const noexcept {
+    return m_inverseViewProjMatrix;
+  }
+  [[nodiscard]] const Frustum &getFrustum() const noexcept {
+    return m_frustum;
+  }
+  [[nodiscard]] std::uint64_t getVersion() const noexcept { return m_version; }
+
+ private:
+  glm::vec3 m_eye{0.0f, 0.0f, 1.0f};
+  glm::vec3 m_at{0.0f};
+  glm::vec3 m_up{0.0f, 1.0f, 0.0f};
+
+  float m_fovy{glm::radians(45.0f)};
+  float m_aspect{1.0f};
+  float m_zNear{0.1f};
+  float m_zFar{100.0f};
+
+  glm::mat4 m_viewMatrix{1.0f};
+  glm::mat4 m_projMatrix{1.0f};
+  glm::mat4 m_viewProjMatrix{1.0f};
+  glm::mat4 m_inverseViewMatrix{1.0f};
+  glm::mat4 m_inverseViewProjMatrix{1.0f};
+  Frustum m_frustum;
+
+  std::uint64_t m_version{};
+  bool m_viewChanged{true};
+  bool m_projChanged{true};
+};
+
+#endif
@@ -0,0 +1,354 @@
+/**
+ * @file abcg_clusteredlights.cpp
+ * @brief Definition of abcg::ClusteredLights class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_clusteredlights.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <glm/geometric.hpp>
+#include <glm/mat3x3.hpp>
+#include <utility>
+
+#include "abcg_exception.hpp"
+
+#if defined(__SSE__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define ABCG_CLUSTEREDLIGHTS_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace {
+
+// Creates a 2D texture sampled with texelFetch
+GLuint createDataTexture(GLint internalFormat, GLsizei width, GLsizei height,
+                         GLenum format, GLenum type) {
+  GLuint texture{};
+  glGenTextures(1, &texture);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format,
+               type, nullptr);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  return texture;
+}
+
+}  // namespace
+
+/**
+ * @brief Creates the textures of the lights and of the light lists.
+ *
+ * Any previously created OpenGL resources are released first.
+ *
+ * @param maxLights Maximum number of lights per frame. Extra lights are
+ * ignored.
+ * @param maxIndices Maximum total length of the light lists of the clusters.
+ * Intersections beyond that are dropped, so the lights given last to update()
+ * lose clusters first.
+ *
+ * @throw abcg::Exception if `maxLights` exceeds the maximum texture size.
+ */
+void abcg::ClusteredLights::initializeGL(std::size_t maxLights,
+                                         std::size_t maxIndices) {
+  terminateGL();
+
+  GLint maxTextureSize{};
+  glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+  if (maxLights == 0 || maxLights > static_cast<std::size_t>(maxTextureSize)) {
+    throw abcg::Exception{
+        abcg::Exception::Runtime("Unsupported number of clustered lights")};
+  }
+
+  const auto indexRows{
+      std::max<std::size_t>((maxIndices + m_indexTextureWidth - 1) /
+                                m_indexTextureWidth,
+                            1)};
+  m_maxLights = maxLights;
+  m_maxIndices = indexRows * m_indexTextureWidth;
+
+  m_lightTexture = createDataTexture(GL_RGBA32F, 3,
+                                     static_cast<GLsizei>(m_maxLights),
+                                     GL_RGBA, GL_FLOAT);
+  m_clusterTexture =
+      createDataTexture(GL_RG32UI, gridWidth * gridHeight, gridDepth,
+                        GL_RG_INTEGER, GL_UNSIGNED_INT);
+  m_indexTexture = createDataTexture(GL_R32UI, m_indexTextureWidth,
+                                     static_cast<GLsizei>(indexRows),
+                                     GL_RED_INTEGER, GL_UNSIGNED_INT);
+
+  m_pairs.reserve(m_maxIndices);
+  m_indices.reserve(m_maxIndices);
+  m_lightData.reserve(3 * m_maxLights);
+}
+
+/**
+ * @brief Computes the view-space bounds of the clusters.
+ *
+ * Must be called whenever the projection changes.
+ *
+ * @param projMatrix Symmetric perspective projection matrix, as created by
+ * `glm::perspective`.
+ */
+void abcg::ClusteredLights::setProjection(const glm::mat4 &projMatrix) {
+  m_tanHalfFovX = 1.0f / projMatrix[0][0];
+  m_tanHalfFovY = 1.0f / projMatrix[1][1];
+  m_zNear = projMatrix[3][2] / (projMatrix[2][2] - 1.0f);
+  m_zFar = projMatrix[3][2] / (projMatrix[2][2] + 1.0f);
+
+  m_minX.resize(m_numClusters);
+  m_minY.resize(m_numClusters);
+  m_minZ.resize(m_numClusters);
+  m_maxX.resize(m_numClusters);
+  m_maxY.resize(m_numClusters);
+  m_maxZ.resize(m_numClusters);
+
+  std::size_t cluster{};
+  for (int z{}; z < gridDepth; ++z) {
+    // Distances to the camera of the near and far sides of the slice
+    const auto ratio{m_zFar / m_zNear};
+    const auto near{m_zNear * std::pow(ratio, static_cast<float>(z) /
+                                                  gridDepth)};
+    const auto far{m_zNear * std::pow(ratio, static_cast<float>(z + 1) /
+                                                 gridDepth)};
+    for (int y{}; y < gridHeight; ++y) {
+      const auto y0{(-1.0f + 2.0f * static_cast<float>(y) / gridHeight) *
+                    m_tanHalfFovY};
+      const auto y1{(-1.0f + 2.0f * static_cast<float>(y + 1) / gridHeight) *
+                    m_tanHalfFovY};
+      for (int x{}; x < gridWidth; ++x, ++cluster) {
+        const auto x0{(-1.0f + 2.0f * static_cast<float>(x) / gridWidth) *
+                      m_tanHalfFovX};
+        const auto x1{(-1.0f + 2.0f * static_cast<float>(x + 1) / gridWidth) *
+                      m_tanHalfFovX};
+        m_minX[cluster] = std::min(x0 * near, x0 * far);
+        m_maxX[cluster] = std::max(x1 * near, x1 * far);
+        m_minY[cluster] = std::min(y0 * near, y0 * far);
+        m_maxY[cluster] = std::max(y1 * near, y1 * far);
+        m_minZ[cluster] = -far;
+        m_maxZ[cluster] = -near;
+      }
+    }
+  }
+}
+
+/**
+ * @brief Bins the lights of the frame and uploads them.
+ *
+ * @param lights Lights in world space.
+ * @param viewMatrix View matrix of the frame.
+ */
+void abcg::ClusteredLights::update(std::span<const Light> lights,
+                                   const glm::mat4 &viewMatrix) {
+  m_numLights = std::min(lights.size(), m_maxLights);
+  m_pairs.clear();
+  m_lightData.resize(3 * m_numLights);
+
+  const glm::mat3 rotation{viewMatrix};
+  for (std::size_t index{}; index < m_numLights; ++index) {
+    const auto &light{lights[index]};
+    const glm::vec3 position{viewMatrix * glm::vec4(light.position, 1.0f)};
+    const auto direction{glm::normalize(rotation * light.direction)};
+
+    m_lightData[3 * index + 0] = glm::vec4(position, light.radius);
+    m_lightData[3 * index + 1] = glm::vec4(light.color, light.cosOuterCone);
+    m_lightData[3 * index + 2] = glm::vec4(direction, light.cosInnerCone);
+
+    binLight(position, light.radius, static_cast<GLuint>(index));
+  }
+  if (m_pairs.size() > m_maxIndices) m_pairs.resize(m_maxIndices);
+
+  // Counting sort of the intersections by cluster. The offsets first point to
+  // the end of each list, and the lists are filled backwards so that lights
+  // keep their order.
+  m_clusters.assign(m_numClusters, glm::uvec2{});
+  for (const auto &pair : m_pairs) ++m_clusters[pair.x].y;
+  GLuint offset{};
+  m_maxLightsPerCluster = 0;
+  for (auto &cluster : m_clusters) {
+    offset += cluster.y;
+    cluster.x = offset;
+    m_maxLightsPerCluster = std::max<std::size_t>(m_maxLightsPerCluster,
+                                                  cluster.y);
+  }
+  m_numIndices = m_pairs.size();
+  const auto indexRows{(m_numIndices + m_indexTextureWidth - 1) /
+                       m_indexTextureWidth};
+  m_indices.resize(indexRows * m_indexTextureWidth);
+  for (auto pair{m_pairs.rbegin()}; pair != m_pairs.rend(); ++pair) {
+    m_indices[--m_clusters[pair->x].x] = pair->y;
+  }
+
+  if (m_numLights > 0) {
+    glBindTexture(GL_TEXTURE_2D, m_lightTexture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 3,
+                    static_cast<GLsizei>(m_numLights), GL_RGBA, GL_FLOAT,
+                    m_lightData.data());
+  }
+  glBindTexture(GL_TEXTURE_2D, m_clusterTexture);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, gridWidth * gridHeight, gridDepth,
+                  GL_RG_INTEGER, GL_UNSIGNED_INT, m_clusters.data());
+  if (indexRows > 0) {
+    glBindTexture(GL_TEXTURE_2D, m_indexTexture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_indexTextureWidth,
+                    static_cast<GLsizei>(indexRows), GL_RED_INTEGER,
+                    GL_UNSIGNED_INT, m_indices.data());
+  }
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+/**
+ * @brief Binds the textures and sets the uniforms of a program.
+ *
+ * The program is left bound. It reads the textures through the samplers
+ * `lightTexture`, `clusterTexture` and `lightIndexTexture`, and locates a
+ * fragment in the grid with `clusterGrid`, `clusterTileSize` (in pixels) and
+ * `clusterDepthParams`, such that the slice of a fragment at distance `d`
+ * from the camera is `log(d) * clusterDepthParams.x + clusterDepthParams.y`.
+ *
+ * @param program Shader program.
+ * @param firstUnit First of the three consecutive texture units used.
+ * @param viewportWidth Width of the viewport, in pixels.
+ * @param viewportHeight Height of the viewport, in pixels.
+ */
+void abcg::ClusteredLights::bind(GLuint program, GLuint firstUnit,
+                                 int viewportWidth, int viewportHeight) const {
+  glActiveTexture(GL_TEXTURE0 + firstUnit + 0);
+  glBindTexture(GL_TEXTURE_2D, m_lightTexture);
+  glActiveTexture(GL_TEXTURE0 + firstUnit + 1);
+  glBindTexture(GL_TEXTURE_2D, m_clusterTexture);
+  glActiveTexture(GL_TEXTURE0 + firstUnit + 2);
+  glBindTexture(GL_TEXTURE_2D, m_indexTexture);
+  glActiveTexture(GL_TEXTURE0);
+
+  const auto unit{static_cast<GLint>(firstUnit)};
+  const auto logRatio{std::log(m_zFar / m_zNear)};
+
+  glUseProgram(program);
+  glUniform1i(glGetUniformLocation(program, "lightTexture"), unit + 0);
+  glUniform1i(glGetUniformLocation(program, "clusterTexture"), unit + 1);
+  glUniform1i(glGetUniformLocation(program, "lightIndexTexture"), unit + 2);
+  glUniform3i(glGetUniformLocation(program, "clusterGrid"), gridWidth,
+              gridHeight, gridDepth);
+  glUniform2f(glGetUniformLocation(program, "clusterTileSize"),
+              static_cast<float>(viewportWidth) / gridWidth,
+              static_cast<float>(viewportHeight) / gridHeight);
+  glUniform2f(glGetUniformLocation(program, "clusterDepthParams"),
+              gridDepth / logRatio, -gridDepth * std::log(m_zNear) / logRatio);
+}
+
+/**
+ * @brief Releases the textures.
+ */
+void abcg::ClusteredLights::terminateGL() {
+  glDeleteTextures(1, &m_indexTexture);
+  glDeleteTextures(1, &m_clusterTexture);
+  glDeleteTextures(1, &m_lightTexture);
+
+  m_indexTexture = 0;
+  m_clusterTexture = 0;
+  m_lightTexture = 0;
+  m_numLights = 0;
+  m_numIndices = 0;
+}
+
+// Appends the clusters intersected by a view-space sphere to the pairs
+void abcg::ClusteredLights::binLight(const glm::vec3 &center, float radius,
+                                     GLuint light) {
+  // Range of slices, from the depth range of the sphere
+  const auto depthNear{std::max(-center.z - radius, m_zNear)};
+  const auto depthFar{std::min(-center.z + radius, m_zFar)};
+  if (depthNear > depthFar) return;
+
+  const auto logRatio{std::log(m_zFar / m_zNear)};
+  const auto slice{[&](float depth) {
+    const auto z{std::floor(std::log(depth / m_zNear) / logRatio * gridDepth)};
+    return std::clamp(static_cast<int>(z), 0, gridDepth - 1);
+  }};
+  const auto z0{slice(depthNear)};
+  const auto z1{slice(depthFar)};
+
+  // Range of tiles, from the projection of the corners of the bounding box
+  // clipped to the depth range. Its projection is convex, so the extreme
+  // corners bound it.
+  const auto tiles{[&](float min, float max, float tanHalfFov, int size) {
+    const auto scale{0.5f * static_cast<float>(size) / tanHalfFov};
+    const auto ndcMin{std::min(min / depthNear, min / depthFar)};
+    const auto ndcMax{std::max(max / depthNear, max / depthFar)};
+    const auto end{static_cast<float>(size)};
+    const auto first{std::floor(ndcMin * scale + 0.5f * end)};
+    const auto last{std::floor(ndcMax * scale + 0.5f * end)};
+    return std::pair{static_cast<int>(std::clamp(first, -1.0f, end)),
+                     static_cast<int>(std::clamp(last, -1.0f, end))};
+  }};
+  const auto [x0, x1]{tiles(center.x - radius, center.x + radius,
+                            m_tanHalfFovX, gridWidth)};
+  const auto [y0, y1]{tiles(center.y - radius, center.y + radius,
+                            m_tanHalfFovY, gridHeight)};
+  if (x1 < 0 || x0 >= gridWidth || y1 < 0 || y0 >= gridHeight) return;
+
+  const auto firstX{std::max(x0, 0)};
+  const auto lastX{std::min(x1, gridWidth - 1)};
+  const auto radius2{radius * radius};
+
+  for (auto z{z0}; z <= z1; ++z) {
+    for (auto y{std::max(y0, 0)}; y <= std::min(y1, gridHeight - 1); ++y) {
+      const auto row{static_cast<std::size_t>((z * gridHeight + y) *
+                                              gridWidth)};
+      auto x{firstX};
+
+#if defined(ABCG_CLUSTEREDLIGHTS_SSE)
+      const auto cx{_mm_set1_ps(center.x)};
+      const auto cy{_mm_set1_ps(center.y)};
+      const auto cz{_mm_set1_ps(center.z)};
+      const auto zero{_mm_setzero_ps()};
+      for (; x + 4 <= lastX + 1; x += 4) {
+        const auto index{row + static_cast<std::size_t>(x)};
+        // Distance from the center to the box along each axis
+        const auto dx{_mm_max_ps(
+            _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&m_minX[index]), cx),
+                       _mm_sub_ps(cx, _mm_loadu_ps(&m_maxX[index]))),
+            zero)};
+        const auto dy{_mm_max_ps(
+            _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&m_minY[index]), cy),
+                       _mm_sub_ps(cy, _mm_loadu_ps(&m_maxY[index]))),
+            zero)};
+        const auto dz{_mm_max_ps(
+            _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&m_minZ[index]), cz),
+                       _mm_sub_ps(cz, _mm_loadu_ps(&m_maxZ[index]))),
+            zero)};
+        auto distance2{_mm_mul_ps(dx, dx)};
+        distance2 = _mm_add_ps(distance2, _mm_mul_ps(dy, dy));
+        distance2 = _mm_add_ps(distance2, _mm_mul_ps(dz, dz));
+
+        const auto mask{_mm_movemask_ps(
+            _mm_cmple_ps(distance2, _mm_set1_ps(radius2)))};
+        for (std::uint32_t lane{}; lane < 4; ++lane) {
+          if ((mask & (1 << lane)) != 0) {
+            m_pairs.emplace_back(static_cast<GLuint>(index) + lane, light);
+          }
+        }
+      }
+#endif
+
+      for (; x <= lastX; ++x) {
+        const auto index{row + static_cast<std::size_t>(x)};
+        const auto dx{std::max({m_minX[index] - center.x,
+                                center.x - m_maxX[index], 0.0f})};
+        const auto dy{std::max({m_minY[index] - center.y,
+                                center.y - m_maxY[index], 0.0f})};
+        const auto dz{std::max({m_minZ[index] - center.z,
+                                center.z - m_maxZ[index], 0.0f})};
+        if (dx * dx + dy * dy + dz * dz <= radius2) {
+          m_pairs.emplace_back(static_cast<GLuint>(index), light);
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,135 @@
+/**
+ * @file abcg_clusteredlights.hpp
+ * @brief abcg::ClusteredLights header file.
+ *
+ * Declaration of abcg::ClusteredLights class.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_CLUSTEREDLIGHTS_HPP_
+#define ABCG_CLUSTEREDLIGHTS_HPP_
+
+#include <cstddef>
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <span>
+#include <vector>
+
+#include "abcg_openglfunctions.hpp"
+
+namespace abcg {
+class ClusteredLights;
+}  // namespace abcg
+
+/**
+ * @brief abcg::ClusteredLights class.
+ *
+ * Point and spot lights binned on the CPU into the clusters of a view-space
+ * grid, so that a fragment shader only evaluates the lights that may reach
+ * its cluster.
+ *
+ * The grid has 16 x 9 tiles across the viewport and 24 slices in depth, with
+ * a thickness that grows exponentially from the near plane to the far plane.
+ * Every frame, update() transforms the lights to view space, finds the
+ * clusters their bounding spheres intersect, and uploads three textures:
+ *
+ * - `lightTexture` (`GL_RGBA32F`): three texels per light in row `i`, holding
+ * the position and radius, the color and the cosine of the outer cone, and
+ * the direction and the cosine of the inner cone, all in view space.
+ * - `clusterTexture` (`GL_RG32UI`): the offset and count of the light list of
+ * the cluster of tile `(x, y)` and slice `z`, at texel `(x + 16 * y, z)`.
+ * - `lightIndexTexture` (`GL_R32UI`): the concatenated light lists, with entry
+ * `k` at texel `(k % width, k / width)`.
+ *
+ * Plain 2D textures are used because WebGL 2.0 and OpenGL 4.1 have neither
+ * shader storage buffers nor buffer textures. bind() binds them and sets the
+ * uniforms that locate a fragment in the grid. See `texture.frag` of 3DRacer2
+ * for a shader that reads them.
+ *
+ * When SSE is available, each light is tested against four clusters of a
+ * row at a time.
+ */
+class abcg::ClusteredLights {
+ public:
+  /**
+   * @brief Point or spot light in world space.
+   *
+   * The light has no effect beyond `radius`. A spot light fades between the
+   * cones whose half-angle cosines are `cosInnerCone` and `cosOuterCone`. A
+   * point light has `cosOuterCone` equal to -1.
+   */
+  struct Light {
+    glm::vec3 position{};
+    float radius{1.0f};
+    glm::vec3 color{1.0f};
+    glm::vec3 direction{0.0f, 0.0f, -1.0f};
+    float cosInnerCone{-1.0f};
+    float cosOuterCone{-1.0f};
+  };
+
+  static constexpr int gridWidth{16};
+  static constexpr int gridHeight{9};
+  static constexpr int gridDepth{24};
+
+  void initializeGL(std::size_t maxLights = 256,
+                    std::size_t maxIndices = 16384);
+  void setProjection(const glm::mat4 &projMatrix);
+  void update(std::span<const Light> lights, const glm::mat4 &viewMatrix);
+  void bind(GLuint program, GLuint firstUnit, int viewportWidth,
+            int viewportHeight) const;
+  void terminateGL();
+
+  [[nodiscard]] std::size_t getNumLights() const noexcept {
+    return m_numLights;
+  }
+  [[nodiscard]] std::size_t getNumIndices() const noexcept {
+    return m_numIndices;
+  }
+  [[nodiscard]] std::size_t getMaxLightsPerCluster() const noexcept {
+    return m_maxLightsPerCluster;
+  }
+
+ private:
+  static constexpr std::size_t m_numClusters{gridWidth * gridHeight *
+                                             gridDepth};
+  static constexpr GLsizei m_indexTextureWidth{1024};
+
+  void binLight(const glm::vec3 &center, float radius, GLuint light);
+
+  // Symmetric perspective projection
+  float m_tanHalfFovX{1.0f};
+  float m_tanHalfFovY{1.0f};
+  float m_zNear{0.1f};
+  float m_zFar{100.0f};
+
+  // View-space bounds of each cluster, stored per component so that a row of
+  // clusters can be tested at once
+  std::vector<float> m_minX;
+  std::vector<float> m_minY;
+  std::vector<float> m_minZ;
+  std::vector<float> m_maxX;
+  std::vector<float> m_maxY;
+  std::vector<float> m_maxZ;
+
+  std::size_t m_maxLights{};
+  std::size_t m_maxIndices{};
+  std::size_t m_numLights{};
+  std::size_t m_numIndices{};
+  std::size_t m_maxLightsPerCluster{};
+
+  // Cluster and light of each intersection, the offset and count of the
+  // light list of each cluster, and the light lists padded to whole rows
+  std::vector<glm::uvec2> m_pairs;
+  std::vector<glm::uvec2> m_clusters;
+  std::vector<GLuint> m_indices;
+  std::vector<glm::vec4> m_lightData;
+
+  GLuint m_lightTexture{};
+  GLuint m_clusterTexture{};
+  GLuint m_indexTexture{};
+};
+
+#endif
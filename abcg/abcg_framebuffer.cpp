@@ -0,0 +1,157 @@
+/**
+ * @file abcg_framebuffer.cpp
+ * @brief Definition of abcg::Framebuffer class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_framebuffer.hpp"
+
+#include "abcg_exception.hpp"
+
+/**
+ * @brief Creates the attachments and the framebuffer objects.
+ *
+ * Any previously created OpenGL resources of the framebuffer are released
+ * first.
+ *
+ * @param width Width in pixels.
+ * @param height Height in pixels.
+ * @param samples Number of samples per pixel, or 0 for no multisampling.
+ *
+ * @throw abcg::Exception if the framebuffer is incomplete.
+ */
+void abcg::Framebuffer::initializeGL(GLsizei width, GLsizei height,
+                                     GLsizei samples) {
+  terminateGL();
+
+  // Color texture, sampled or read back
+  glGenTextures(1, &m_texture);
+  glBindTexture(GL_TEXTURE_2D, m_texture);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA,
+               GL_UNSIGNED_BYTE, nullptr);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  glGenRenderbuffers(1, &m_depthRBO);
+  glBindRenderbuffer(GL_RENDERBUFFER, m_depthRBO);
+  glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples,
+                                   GL_DEPTH24_STENCIL8, width, height);
+
+  glGenFramebuffers(1, &m_FBO);
+  glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
+                            GL_RENDERBUFFER, m_depthRBO);
+  if (samples > 0) {
+    glGenRenderbuffers(1, &m_colorRBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_colorRBO);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, width,
+                                     height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                              GL_RENDERBUFFER, m_colorRBO);
+  } else {
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                           m_texture, 0);
+  }
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+  auto complete{glCheckFramebufferStatus(GL_FRAMEBUFFER) ==
+                GL_FRAMEBUFFER_COMPLETE};
+
+  if (samples > 0) {
+    glGenFramebuffers(1, &m_resolveFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_resolveFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                           m_texture, 0);
+    complete = complete && glCheckFramebufferStatus(GL_FRAMEBUFFER) ==
+                               GL_FRAMEBUFFER_COMPLETE;
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+  if (!complete) {
+    terminateGL();
+    throw abcg::Exception{
+        abcg::Exception::Runtime("Failed to create framebuffer")};
+  }
+
+  m_width = width;
+  m_height = height;
+  m_samples = samples;
+}
+
+/**
+ * @brief Binds the framebuffer for drawing and reading.
+ */
+void abcg::Framebuffer::bind() const {
+  glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+}
+
+/**
+ * @brief Resolves the whole multisampled color to the texture.
+ *
+ * Does nothing without multisampling. Framebuffer 0 is left bound.
+ */
+void abcg::Framebuffer::resolve() const { resolve(m_width, m_height); }
+
+/**
+ * @brief Resolves the lower-left region of the multisampled color to the
+ * texture.
+ *
+ * Does nothing without multisampling. Framebuffer 0 is left bound.
+ *
+ * @param width Width of the region.
+ * @param height Height of the region.
+ */
+void abcg::Framebuffer::resolve(GLsizei width, GLsizei height) const {
+  if (m_resolveFBO == 0) return;
+
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, m_FBO);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_resolveFBO);
+  glBlitFramebuffer(0, 0, width, height, 0, 0, width, height,
+                    GL_COLOR_BUFFER_BIT, GL_NEAREST);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+/**
+ * @brief Reads back the color.
+ *
+ * Waits for the GPU to finish drawing. Framebuffer 0 is left bound.
+ *
+ * @return RGBA pixels with 8 bits per channel, from the bottom row to the top
+ * row.
+ */
+std::vector<std::uint8_t> abcg::Framebuffer::readPixels() const {
+  std::vector<std::uint8_t> pixels(static_cast<std::size_t>(m_width) *
+                                   static_cast<std::size_t>(m_height) * 4);
+
+  glBindFramebuffer(GL_FRAMEBUFFER,
+                    m_resolveFBO != 0 ? m_resolveFBO : m_FBO);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE,
+               pixels.data());
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+  return pixels;
+}
+
+/**
+ * @brief Releases the OpenGL resources of the framebuffer.
+ */
+void abcg::Framebuffer::terminateGL() {
+  glDeleteFramebuffers(1, &m_resolveFBO);
+  glDeleteFramebuffers(1, &m_FBO);
+  glDeleteRenderbuffers(1, &m_colorRBO);
+  glDeleteRenderbuffers(1, &m_depthRBO);
+  glDeleteTextures(1, &m_texture);
+
+  m_resolveFBO = 0;
+  m_FBO = 0;
+  m_colorRBO = 0;
+  m_depthRBO = 0;
+  m_texture = 0;
+  m_width = 0;
+  m_height = 0;
+  m_samples = 0;
+}
@@ -0,0 +1,64 @@
+/**
+ * @file abcg_framebuffer.hpp
+ * @brief abcg::Framebuffer header file.
+ *
+ * Declaration of abcg::Framebuffer class.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_FRAMEBUFFER_HPP_
+#define ABCG_FRAMEBUFFER_HPP_
+
+#include <cstdint>
+#include <vector>
+
+#include "abcg_openglfunctions.hpp"
+
+namespace abcg {
+class Framebuffer;
+}  // namespace abcg
+
+/**
+ * @brief abcg::Framebuffer class.
+ *
+ * Offscreen framebuffer with an RGBA8 color attachment and a 24-bit depth,
+ * 8-bit stencil attachment.
+ *
+ * Without multisampling, the color attachment is a texture that can be
+ * sampled right after drawing. With multisampling, both attachments are
+ * multisampled renderbuffers, and resolve() copies the color to the texture
+ * of a second, single-sampled framebuffer.
+ *
+ * getTexture() and readPixels() always refer to the single-sampled color, so
+ * a multisampled framebuffer must be resolved first.
+ */
+class abcg::Framebuffer {
+ public:
+  void initializeGL(GLsizei width, GLsizei height, GLsizei samples = 0);
+  void bind() const;
+  void resolve() const;
+  void resolve(GLsizei width, GLsizei height) const;
+  [[nodiscard]] std::vector<std::uint8_t> readPixels() const;
+  void terminateGL();
+
+  [[nodiscard]] GLuint getFBO() const noexcept { return m_FBO; }
+  [[nodiscard]] GLuint getTexture() const noexcept { return m_texture; }
+  [[nodiscard]] GLsizei getWidth() const noexcept { return m_width; }
+  [[nodiscard]] GLsizei getHeight() const noexcept { return m_height; }
+  [[nodiscard]] GLsizei getSamples() const noexcept { return m_samples; }
+
+ private:
+  GLsizei m_width{};
+  GLsizei m_height{};
+  GLsizei m_samples{};
+
+  GLuint m_FBO{};
+  GLuint m_colorRBO{};
+  GLuint m_depthRBO{};
+  // Single-sampled framebuffer of the texture, if multisampled
+  GLuint m_resolveFBO{};
+  GLuint m_texture{};
+};
+
+#endif
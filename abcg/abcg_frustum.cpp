@@ -0,0 +1,141 @@
+/**
+ * @file abcg_frustum.cpp
+ * @brief Definition of abcg::Frustum class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_frustum.hpp"
+
+#include <glm/geometric.hpp>
+
+#if defined(__SSE__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define ABCG_FRUSTUM_SSE
+#include <xmmintrin.h>
+#endif
+
+/**
+ * @brief Extracts the frustum planes from a view-projection matrix.
+ *
+ * Each plane is a sum or difference of the fourth row of the matrix and one
+ * of the other rows (Gribb & Hartmann method), normalized so that plane
+ * equations give signed distances.
+ *
+ * @param viewProjMatrix Projection matrix times view matrix.
+ */
+void abcg::Frustum::update(const glm::mat4 &viewProjMatrix) noexcept {
+  // glm matrices are column-major, so row i is (m[0][i], ..., m[3][i])
+  const auto row{[&viewProjMatrix](int i) {
+    return glm::vec4(viewProjMatrix[0][i], viewProjMatrix[1][i],
+                     viewProjMatrix[2][i], viewProjMatrix[3][i]);
+  }};
+
+  const std::array planes{row(3) + row(0),   // Left
+                          row(3) - row(0),   // Right
+                          row(3) + row(1),   // Bottom
+                          row(3) - row(1),   // Top
+                          row(3) + row(2),   // Near
+                          row(3) - row(2)};  // Far
+
+  for (std::size_t i{}; i < planes.size(); ++i) {
+    const auto plane{planes.at(i) / glm::length(glm::vec3(planes.at(i)))};
+    m_a.at(i) = plane.x;
+    m_b.at(i) = plane.y;
+    m_c.at(i) = plane.z;
+    m_d.at(i) = plane.w;
+  }
+}
+
+/**
+ * @brief Tests a bounding sphere against the frustum.
+ *
+ * @param sphere Center (xyz) and radius (w) of the sphere.
+ * @return Whether the sphere may be visible.
+ */
+bool abcg::Frustum::intersects(const glm::vec4 &sphere) const noexcept {
+  for (std::size_t i{}; i < m_a.size(); ++i) {
+    const auto distance{m_a[i] * sphere.x + m_b[i] * sphere.y +
+                        m_c[i] * sphere.z + m_d[i]};
+    if (distance < -sphere.w) return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Tests an axis-aligned bounding box against the frustum.
+ *
+ * For each plane, only the corner of the box farthest along the plane normal
+ * is tested.
+ *
+ * @param min Minimum corner of the box.
+ * @param max Maximum corner of the box.
+ * @return Whether the box may be visible.
+ */
+bool abcg::Frustum::intersects(const glm::vec3 &min,
+                               const glm::vec3 &max) const noexcept {
+  for (std::size_t i{}; i < m_a.size(); ++i) {
+    const auto x{m_a[i] >= 0.0f ? max.x : min.x};
+    const auto y{m_b[i] >= 0.0f ? max.y : min.y};
+    const auto z{m_c[i] >= 0.0f ? max.z : min.z};
+    if (m_a[i] * x + m_b[i] * y + m_c[i] * z + m_d[i] < 0.0f) return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Tests a batch of bounding spheres against the frustum.
+ *
+ * When SSE is available, four spheres are tested at a time against each
+ * plane. Otherwise, and for the remaining spheres, each sphere is tested with
+ * intersects().
+ *
+ * @param spheres Centers (xyz) and radii (w) of the spheres.
+ * @param visible Output array that receives the indices of the spheres that
+ * may be visible, in increasing order. Must have at least `spheres.size()`
+ * elements.
+ * @return Number of indices written to `visible`.
+ */
+std::size_t abcg::Frustum::cull(
+    std::span<const glm::vec4> spheres,
+    std::span<std::uint32_t> visible) const noexcept {
+  std::size_t numVisible{};
+  std::size_t index{};
+
+#if defined(ABCG_FRUSTUM_SSE)
+  for (; index + 4 <= spheres.size(); index += 4) {
+    // Transpose four spheres into x, y, z and radius vectors
+    auto x{_mm_loadu_ps(&spheres[index + 0].x)};
+    auto y{_mm_loadu_ps(&spheres[index + 1].x)};
+    auto z{_mm_loadu_ps(&spheres[index + 2].x)};
+    auto r{_mm_loadu_ps(&spheres[index + 3].x)};
+    _MM_TRANSPOSE4_PS(x, y, z, r);
+
+    const auto zero{_mm_setzero_ps()};
+    const auto negR{_mm_sub_ps(zero, r)};
+    auto inside{_mm_cmpge_ps(zero, zero)};
+    for (std::size_t i{}; i < m_a.size(); ++i) {
+      auto distance{_mm_mul_ps(_mm_set1_ps(m_a[i]), x)};
+      distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(m_b[i]), y));
+      distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(m_c[i]), z));
+      distance = _mm_add_ps(distance, _mm_set1_ps(m_d[i]));
+      inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negR));
+    }
+
+    const auto mask{_mm_movemask_ps(inside)};
+    for (std::uint32_t lane{}; lane < 4; ++lane) {
+      if ((mask & (1 << lane)) != 0) {
+        visible[numVisible++] = static_cast<std::uint32_t>(index) + lane;
+      }
+    }
+  }
+#endif
+
+  for (; index < spheres.size(); ++index) {
+    if (intersects(spheres[index])) {
+      visible[numVisible++] = static_cast<std::uint32_t>(index);
+    }
+  }
+
+  return numVisible;
+}
@@ -0,0 +1,56 @@
+/**
+ * @file abcg_frustum.hpp
+ * @brief abcg::Frustum header file.
+ *
+ * Declaration of abcg::Frustum class.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_FRUSTUM_HPP_
+#define ABCG_FRUSTUM_HPP_
+
+#include <array>
+#include <cstdint>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <span>
+
+namespace abcg {
+class Frustum;
+}  // namespace abcg
+
+/**
+ * @brief abcg::Frustum class.
+ *
+ * View frustum given by six planes extracted from a view-projection matrix.
+ * The planes are in the space the matrix transforms from, which is world
+ * space for `projMatrix * viewMatrix`.
+ *
+ * Bounding spheres are given as `glm::vec4` with the center in `xyz` and the
+ * radius in `w`. The tests are conservative: volumes that are only partially
+ * inside, or that cross a plane outside a corner of the frustum, are reported
+ * as visible.
+ */
+class abcg::Frustum {
+ public:
+  void update(const glm::mat4 &viewProjMatrix) noexcept;
+
+  [[nodiscard]] bool intersects(const glm::vec4 &sphere) const noexcept;
+  [[nodiscard]] bool intersects(const glm::vec3 &min,
+                                const glm::vec3 &max) const noexcept;
+  std::size_t cull(std::span<const glm::vec4> spheres,
+                   std::span<std::uint32_t> visible) const noexcept;
+
+ private:
+  // Plane i holds the points where a*x + b*y + c*z + d = 0, with the normal
+  // (a, b, c) of unit length pointing into the frustum. Coefficients are
+  // stored per component so that the batch test can broadcast them.
+  std::array<float, 6> m_a{};
+  std::array<float, 6> m_b{};
+  std::array<float, 6> m_c{};
+  std::array<float, 6> m_d{};
+};
+
+#endif
@@ -0,0 +1,229 @@
+/**
+ * @file abcg_gputimer.cpp
+ * @brief Definition of abcg::GPUTimer and abcg::GPUScope class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#if defined(ABCG_PROFILE)
+#include "abcg_gputimer.hpp"
+
+#include <algorithm>
+
+/**
+ * @brief Returns the GPU timer shared by the application.
+ *
+ * @return Reference to the GPU timer.
+ */
+abcg::GPUTimer &abcg::GPUTimer::getInstance() {
+  static GPUTimer instance;
+  return instance;
+}
+
+/**
+ * @brief Marks the start of a frame.
+ *
+ * Reads back the times of the previous frames that are already available,
+ * and begins measuring the new frame. Called by abcg::OpenGLWindow before
+ * paintGL(). Does nothing if timer queries are not supported.
+ */
+void abcg::GPUTimer::beginFrame() {
+  if (m_active || !isSupported()) return;
+
+  readBack();
+
+  // The oldest frame is dropped if it is still not available
+  auto &frame{m_frames.at(m_numFrames % framesInFlight)};
+  release(frame);
+
+  m_active = true;
+  split();
+}
+
+/**
+ * @brief Marks the end of a frame.
+ *
+ * Passes that are still open are not measured.
+ */
+void abcg::GPUTimer::endFrame() {
+  if (!m_active) return;
+
+  glEndQuery(m_target);
+  m_frames.at(m_numFrames % framesInFlight).pending = true;
+  m_active = false;
+  ++m_numFrames;
+}
+
+/**
+ * @brief Releases the query objects.
+ *
+ * Must be called before the OpenGL context is destroyed. Support for timer
+ * queries is checked again by the next frame.
+ */
+void abcg::GPUTimer::terminateGL() {
+  if (m_active) {
+    glEndQuery(m_target);
+    m_active = false;
+    ++m_numFrames;
+  }
+  for (auto &frame : m_frames) release(frame);
+  if (!m_pool.empty()) {
+    glDeleteQueries(static_cast<GLsizei>(m_pool.size()), m_pool.data());
+  }
+  m_pool.clear();
+  m_results.clear();
+  m_checked = false;
+}
+
+/**
+ * @brief Returns the average GPU times of the last frames read back.
+ *
+ * @param numFrames Maximum number of frames averaged.
+ * @return Average times per frame.
+ */
+abcg::GPUTimer::Totals abcg::GPUTimer::getTotals(std::size_t numFrames) const {
+  Totals totals;
+  totals.numFrames = std::min(numFrames, m_results.size());
+  if (totals.numFrames == 0) return totals;
+
+  const auto scale{1e-6 / static_cast<double>(totals.numFrames)};
+  for (auto result{m_results.end() -
+                   static_cast<std::ptrdiff_t>(totals.numFrames)};
+       result != m_results.end(); ++result) {
+    totals.frame += static_cast<double>(result->frame) * scale;
+    for (const auto &[name, time] : result->passes) {
+      totals.passes[name] += static_cast<double>(time) * scale;
+    }
+  }
+  return totals;
+}
+
+// Checks once whether time elapsed queries are supported, enabling the WebGL
+// extension that provides them
+bool abcg::GPUTimer::isSupported() {
+  if (!m_checked) {
+    m_checked = true;
+#if defined(__EMSCRIPTEN__)
+    m_supported = emscripten_webgl_enable_extension(
+                      emscripten_webgl_get_current_context(),
+                      "EXT_disjoint_timer_query_webgl2") == EM_TRUE;
+    m_target = GL_TIME_ELAPSED_EXT;
+#else
+    m_supported = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+    m_target = GL_TIME_ELAPSED;
+#endif
+  }
+  return m_supported;
+}
+
+// Ends the current segment of the frame, if any, and begins a new one.
+// Returns the index of the new segment.
+std::size_t abcg::GPUTimer::split() {
+  auto &frame{m_frames.at(m_numFrames % framesInFlight)};
+  if (!frame.queries.empty()) glEndQuery(m_target);
+
+  GLuint query{};
+  if (m_pool.empty()) {
+    glGenQueries(1, &query);
+  } else {
+    query = m_pool.back();
+    m_pool.pop_back();
+  }
+  glBeginQuery(m_target, query);
+  frame.queries.push_back(query);
+  return frame.queries.size() - 1;
+}
+
+// Ends a pass that began at a given segment of a given frame. Passes that
+// began during another frame are ignored.
+void abcg::GPUTimer::endPass(const char *name, std::uint64_t frame,
+                             std::size_t first) {
+  if (!m_active || frame != m_numFrames) return;
+
+  const auto last{split()};
+  m_frames.at(m_numFrames % framesInFlight)
+      .passes.push_back({.name{name}, .first{first}, .last{last}});
+}
+
+// Reads the times of the pending frames, from the oldest, until a frame whose
+// results are not available yet. The results are read as 32-bit values, as
+// 64-bit ones are not available everywhere, which limits each segment to
+// about 4 s.
+void abcg::GPUTimer::readBack() {
+#if defined(__EMSCRIPTEN__)
+  // The times of the pending frames are unreliable, e.g., after the GPU
+  // changed its frequency
+  GLint disjoint{};
+  glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+  if (disjoint != 0) {
+    for (auto &frame : m_frames) release(frame);
+    return;
+  }
+#endif
+
+  const auto first{m_numFrames > framesInFlight ? m_numFrames - framesInFlight
+                                                : 0};
+  std::vector<std::uint64_t> times;
+  for (auto index{first}; index < m_numFrames; ++index) {
+    auto &frame{m_frames.at(index % framesInFlight)};
+    if (!frame.pending) continue;
+
+    // Queries complete in order, so the last one is checked first
+    GLuint available{};
+    glGetQueryObjectuiv(frame.queries.back(), GL_QUERY_RESULT_AVAILABLE,
+                        &available);
+    if (available == GL_FALSE) return;
+
+    Result result;
+    times.clear();
+    for (const auto query : frame.queries) {
+      GLuint time{};
+      glGetQueryObjectuiv(query, GL_QUERY_RESULT, &time);
+      times.push_back(time);
+      result.frame += time;
+    }
+    for (const auto &pass : frame.passes) {
+      std::uint64_t time{};
+      for (auto segment{pass.first}; segment < pass.last; ++segment) {
+        time += times.at(segment);
+      }
+      result.passes.emplace_back(pass.name, time);
+    }
+    release(frame);
+
+    m_results.push_back(std::move(result));
+    if (m_results.size() > maxFrames) m_results.pop_front();
+  }
+}
+
+// Returns the queries of a frame to the pool
+void abcg::GPUTimer::release(Frame &frame) {
+  m_pool.insert(m_pool.end(), frame.queries.begin(), frame.queries.end());
+  frame.queries.clear();
+  frame.passes.clear();
+  frame.pending = false;
+}
+
+/**
+ * @brief Begins a pass.
+ *
+ * Does nothing unless a frame is being measured.
+ *
+ * @param name Name of the pass. Must outlive the GPU timer.
+ */
+abcg::GPUScope::GPUScope(const char *name) : m_name{name} {
+  auto &timer{GPUTimer::getInstance()};
+  if (!timer.m_active) return;
+
+  m_frame = timer.m_numFrames;
+  m_first = timer.split();
+  m_active = true;
+}
+
+/**
+ * @brief Ends the pass.
+ */
+abcg::GPUScope::~GPUScope() {
+  if (m_active) GPUTimer::getInstance().endPass(m_name, m_frame, m_first);
+}
+#endif
@@ -0,0 +1,168 @@
+/**
+ * @file abcg_gputimer.hpp
+ * @brief abcg::GPUTimer header file.
+ *
+ * Declaration of abcg::GPUTimer and abcg::GPUScope classes, and of the GPU
+ * profiling macro.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_GPUTIMER_HPP_
+#define ABCG_GPUTIMER_HPP_
+
+#if defined(ABCG_PROFILE)
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string_view>
+#include <vector>
+
+#include "abcg_openglfunctions.hpp"
+#include "abcg_profilemacros.hpp"
+
+/**
+ * @brief Measures the GPU time of the OpenGL commands issued until the end of
+ * the enclosing scope as a pass of abcg::GPUTimer::getInstance().
+ *
+ * The pass is shown in the profiler window beside the CPU zone of the same
+ * name, if any. Must be used by the thread that owns the OpenGL context,
+ * while a frame is being painted. Compiles to nothing unless `ABCG_PROFILE`
+ * is defined (CMake option `ENABLE_PROFILER`).
+ *
+ * @param name Name of the pass. Must be a string literal, or otherwise
+ * outlive the timer.
+ */
+#define ABCG_GPU_SCOPE(name) \
+  const abcg::GPUScope ABCG_PROFILE_CONCAT(abcgPass, __LINE__) { name }
+
+namespace abcg {
+class GPUTimer;
+class GPUScope;
+}  // namespace abcg
+
+/**
+ * @brief abcg::GPUTimer class.
+ *
+ * Measures the GPU time of the passes recorded by ABCG_GPU_SCOPE() with
+ * `GL_TIME_ELAPSED` queries, which are available with OpenGL 3.3 and with
+ * WebGL 2 through the `EXT_disjoint_timer_query_webgl2` extension.
+ *
+ * As time elapsed queries cannot be nested, the frame is split into
+ * consecutive segments, with a new query at every begin and end of a pass.
+ * The time of a pass is the sum of the segments between its begin and its
+ * end, so it includes the passes nested in it.
+ *
+ * The queries of a frame are only read back some frames later, when their
+ * results are already available, so that the CPU never waits for the GPU.
+ * If they are still not available after abcg::GPUTimer::framesInFlight
+ * frames, the frame is dropped. Queries are reused from frame to frame.
+ *
+ * If timer queries are not supported, or the GPU reports that the times of a
+ * frame are unreliable, the affected frames are simply not measured.
+ *
+ * The class only exists if `ABCG_PROFILE` is defined.
+ */
+class abcg::GPUTimer {
+ public:
+  /** @brief Number of frames whose queries may be in flight at once. */
+  static constexpr std::size_t framesInFlight{4};
+  /** @brief Number of frames read back that are kept for getTotals(). */
+  static constexpr std::size_t maxFrames{32};
+
+  /**
+   * @brief Average GPU times per frame.
+   */
+  struct Totals {
+    /** @brief Number of measured frames averaged. */
+    std::size_t numFrames{};
+    /** @brief Time of the whole frame, in milliseconds. */
+    double frame{};
+    /** @brief Time of each pass, in milliseconds. */
+    std::map<std::string_view, double> passes;
+  };
+
+  static GPUTimer &getInstance();
+
+  void beginFrame();
+  void endFrame();
+  void terminateGL();
+
+  [[nodiscard]] Totals getTotals(std::size_t numFrames) const;
+
+ private:
+  friend GPUScope;
+
+  struct Pass {
+    const char *name{};
+    // Range of segments of the pass
+    std::size_t first{};
+    std::size_t last{};
+  };
+
+  struct Frame {
+    // Query of each segment
+    std::vector<GLuint> queries;
+    std::vector<Pass> passes;
+    bool pending{};
+  };
+
+  // GPU times of a frame read back, in nanoseconds
+  struct Result {
+    std::uint64_t frame{};
+    std::vector<std::pair<const char *, std::uint64_t>> passes;
+  };
+
+  bool isSupported();
+  std::size_t split();
+  void endPass(const char *name, std::uint64_t frame, std::size_t first);
+  void readBack();
+  void release(Frame &frame);
+
+  // Whether support for timer queries was checked, and the result
+  bool m_checked{};
+  bool m_supported{};
+  GLenum m_target{};
+
+  std::array<Frame, framesInFlight> m_frames;
+  std::uint64_t m_numFrames{};
+  bool m_active{};
+
+  // Queries not used by any frame
+  std::vector<GLuint> m_pool;
+
+  // Times of the last frames read back, from the oldest
+  std::deque<Result> m_results;
+};
+
+/**
+ * @brief abcg::GPUScope class.
+ *
+ * Pass of abcg::GPUTimer::getInstance() that begins when constructed and ends
+ * when destroyed. Created by ABCG_GPU_SCOPE().
+ */
+class abcg::GPUScope {
+ public:
+  explicit GPUScope(const char *name);
+  ~GPUScope();
+
+  GPUScope(const GPUScope &) = delete;
+  GPUScope(GPUScope &&) = delete;
+  GPUScope &operator=(const GPUScope &) = delete;
+  GPUScope &operator=(GPUScope &&) = delete;
+
+ private:
+  const char *m_name{};
+  // Frame during which the pass began, and its first segment
+  std::uint64_t m_frame{};
+  std::size_t m_first{};
+  bool m_active{};
+};
+
+#else
+#define ABCG_GPU_SCOPE(name) static_cast<void>(0)
+#endif
+
+#endif
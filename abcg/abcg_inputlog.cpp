@@ -0,0 +1,248 @@
+/**
+ * @file abcg_inputlog.cpp
+ * @brief Definition of abcg::InputLog class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_inputlog.hpp"
+
+#include <fmt/core.h>
+
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <iterator>
+#include <string>
+
+#include "abcg_exception.hpp"
+
+namespace {
+constexpr std::array<char, 4> logMagic{'A', 'B', 'I', 'L'};
+constexpr std::uint32_t logVersion{1};
+// Type of the record that ends a stopped recording
+constexpr std::uint32_t endOfLog{0};
+
+template <typename T>
+void put(std::ofstream &output, T value) {
+  output.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+}  // namespace
+
+/**
+ * @brief Starts recording to a file.
+ *
+ * @param path Path to the file, which is overwritten.
+ * @param seed Seed of the random number generators of the session.
+ *
+ * @throw abcg::Exception if the file could not be created.
+ */
+void abcg::InputLog::record(std::string_view path, std::uint64_t seed) {
+  m_output =
+      std::ofstream{std::string{path}, std::ios::binary | std::ios::trunc};
+  if (!m_output) {
+    throw abcg::Exception{abcg::Exception::Runtime(
+        fmt::format("Failed to create input log {}", path))};
+  }
+
+  m_seed = seed;
+  m_thread = std::this_thread::get_id();
+  m_lastStep = 0;
+  m_output.write(logMagic.data(), logMagic.size());
+  put(m_output, logVersion);
+  put(m_output, seed);
+}
+
+/**
+ * @brief Starts replaying a file.
+ *
+ * The whole file is decoded at once. A truncated record, as left by a
+ * recording that was not stopped, ends the replay.
+ *
+ * @param path Path to the file.
+ *
+ * @throw abcg::Exception if the file could not be read, or is not an input
+ * log.
+ */
+void abcg::InputLog::replay(std::string_view path) {
+  std::ifstream input(std::string{path}, std::ios::binary);
+  if (!input) {
+    throw abcg::Exception{abcg::Exception::Runtime(
+        fmt::format("Failed to open input log {}", path))};
+  }
+  const std::vector<char> data{std::istreambuf_iterator<char>{input},
+                               std::istreambuf_iterator<char>{}};
+
+  std::size_t position{};
+  auto get{[&](auto &value) {
+    if (data.size() - position < sizeof(value)) return false;
+    std::memcpy(&value, data.data() + position, sizeof(value));
+    position += sizeof(value);
+    return true;
+  }};
+
+  std::array<char, logMagic.size()> magic{};
+  std::uint32_t version{};
+  if (!get(magic) || magic != logMagic || !get(version) ||
+      version != logVersion || !get(m_seed)) {
+    throw abcg::Exception{abcg::Exception::Runtime(
+        fmt::format("Invalid input log {}", path))};
+  }
+
+  m_events.clear();
+  m_nextEvent = 0;
+  m_numSteps = 0;
+  m_replaying = true;
+  m_thread = std::this_thread::get_id();
+
+  std::uint64_t step{};
+  while (true) {
+    std::uint32_t stepDelta{};
+    std::uint32_t type{};
+    if (!get(stepDelta) || !get(type)) break;
+    step += stepDelta;
+    if (type == endOfLog) {
+      m_numSteps = step;
+      break;
+    }
+
+    SDL_Event event{};
+    event.type = type;
+    auto complete{false};
+    switch (type) {
+      case SDL_KEYDOWN:
+      case SDL_KEYUP: {
+        std::int32_t scancode{};
+        std::int32_t sym{};
+        complete = get(scancode) && get(sym) && get(event.key.keysym.mod) &&
+                   get(event.key.repeat);
+        event.key.keysym.scancode = static_cast<SDL_Scancode>(scancode);
+        event.key.keysym.sym = sym;
+        event.key.state = type == SDL_KEYDOWN ? SDL_PRESSED : SDL_RELEASED;
+      } break;
+      case SDL_MOUSEMOTION:
+        complete = get(event.motion.state) && get(event.motion.x) &&
+                   get(event.motion.y) && get(event.motion.xrel) &&
+                   get(event.motion.yrel);
+        break;
+      case SDL_MOUSEBUTTONDOWN:
+      case SDL_MOUSEBUTTONUP:
+        complete = get(event.button.button) && get(event.button.clicks) &&
+                   get(event.button.x) && get(event.button.y);
+        event.button.state =
+            type == SDL_MOUSEBUTTONDOWN ? SDL_PRESSED : SDL_RELEASED;
+        break;
+      case SDL_MOUSEWHEEL:
+        complete = get(event.wheel.x) && get(event.wheel.y) &&
+                   get(event.wheel.direction);
+        break;
+    }
+    if (!complete) break;
+    m_events.push_back({.step{step}, .event{event}});
+  }
+}
+
+/**
+ * @brief Ends the recording.
+ *
+ * Does nothing if not recording.
+ *
+ * @param numSteps Total number of update steps of the session.
+ */
+void abcg::InputLog::stop(std::uint64_t numSteps) {
+  if (!m_output.is_open()) return;
+  assert(std::this_thread::get_id() == m_thread);
+
+  put(m_output, static_cast<std::uint32_t>(numSteps - m_lastStep));
+  put(m_output, endOfLog);
+  m_output.close();
+  m_numSteps = numSteps;
+}
+
+/**
+ * @brief Writes an event to the recording.
+ *
+ * Events that are not keyboard or mouse input are ignored, as is every event
+ * when not recording.
+ *
+ * @param step Number of update steps run before the event was received.
+ * @param event Event.
+ */
+void abcg::InputLog::write(std::uint64_t step, const SDL_Event &event) {
+  if (!m_output.is_open() || !isInput(event)) return;
+  assert(std::this_thread::get_id() == m_thread);
+
+  put(m_output, static_cast<std::uint32_t>(step - m_lastStep));
+  put(m_output, event.type);
+  m_lastStep = step;
+
+  switch (event.type) {
+    case SDL_KEYDOWN:
+    case SDL_KEYUP:
+      put(m_output, static_cast<std::int32_t>(event.key.keysym.scancode));
+      put(m_output, static_cast<std::int32_t>(event.key.keysym.sym));
+      put(m_output, event.key.keysym.mod);
+      put(m_output, event.key.repeat);
+      break;
+    case SDL_MOUSEMOTION:
+      put(m_output, event.motion.state);
+      put(m_output, event.motion.x);
+      put(m_output, event.motion.y);
+      put(m_output, event.motion.xrel);
+      put(m_output, event.motion.yrel);
+      break;
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+      put(m_output, event.button.button);
+      put(m_output, event.button.clicks);
+      put(m_output, event.button.x);
+      put(m_output, event.button.y);
+      break;
+    case SDL_MOUSEWHEEL:
+      put(m_output, event.wheel.x);
+      put(m_output, event.wheel.y);
+      put(m_output, event.wheel.direction);
+      break;
+  }
+}
+
+/**
+ * @brief Reads the next replayed event that was received before a given
+ * update step.
+ *
+ * Called repeatedly before the step, until it returns false.
+ *
+ * @param step Number of update steps run so far.
+ * @param event Receives the event.
+ * @return Whether an event was read.
+ */
+bool abcg::InputLog::read(std::uint64_t step, SDL_Event &event) {
+  if (!m_replaying) return false;
+  assert(std::this_thread::get_id() == m_thread);
+  if (m_nextEvent == m_events.size() || m_events[m_nextEvent].step > step) {
+    return false;
+  }
+  event = m_events[m_nextEvent++].event;
+  return true;
+}
+
+/**
+ * @brief Returns whether an event is keyboard or mouse input, which is what
+ * gets recorded.
+ *
+ * @param event Event.
+ * @return Whether the event is recorded.
+ */
+bool abcg::InputLog::isInput(const SDL_Event &event) noexcept {
+  switch (event.type) {
+    case SDL_KEYDOWN:
+    case SDL_KEYUP:
+    case SDL_MOUSEMOTION:
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+    case SDL_MOUSEWHEEL:
+      return true;
+    default:
+      return false;
+  }
+}
@@ -0,0 +1,90 @@
+/**
+ * @file abcg_inputlog.hpp
+ * @brief abcg::InputLog header file.
+ *
+ * Declaration of abcg::InputLog class.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_INPUTLOG_HPP_
+#define ABCG_INPUTLOG_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "SDL_events.h"
+
+namespace abcg {
+class InputLog;
+}  // namespace abcg
+
+/**
+ * @brief abcg::InputLog class.
+ *
+ * Binary log of the keyboard and mouse events of a session, and of the seed
+ * of its random number generators, from which the session can be replayed.
+ *
+ * Each event is stamped with the number of update steps run before it was
+ * received, instead of a time, so a replay hands it to the same update step
+ * however long the frames take. Replays are thus identical across runs and
+ * builds, as long as the simulation only depends on the input, the seed and
+ * a fixed time step.
+ *
+ * The log starts with the seed and holds a compact record per event. When a
+ * recording is stopped, the total number of steps is appended. The fields
+ * are stored in the byte order of the machine that recorded them.
+ *
+ * The class is not thread-safe. Once a recording or a replay has started,
+ * write(), read() and stop() must be called by the thread that started it,
+ * which debug builds assert. abcg::OpenGLWindow thus runs the update steps on
+ * the thread that handles the events while recording or replaying.
+ */
+class abcg::InputLog {
+ public:
+  void record(std::string_view path, std::uint64_t seed);
+  void replay(std::string_view path);
+  void stop(std::uint64_t numSteps);
+
+  void write(std::uint64_t step, const SDL_Event &event);
+  bool read(std::uint64_t step, SDL_Event &event);
+
+  [[nodiscard]] static bool isInput(const SDL_Event &event) noexcept;
+
+  [[nodiscard]] bool isRecording() const noexcept {
+    return m_output.is_open();
+  }
+  [[nodiscard]] bool isReplaying() const noexcept { return m_replaying; }
+  [[nodiscard]] std::uint64_t getSeed() const noexcept { return m_seed; }
+  [[nodiscard]] std::uint64_t getNumSteps() const noexcept {
+    return m_numSteps;
+  }
+
+ private:
+  struct Event {
+    std::uint64_t step{};
+    SDL_Event event{};
+  };
+
+  std::uint64_t m_seed{};
+  // Thread that started the recording or the replay
+  std::thread::id m_thread;
+  // Total number of steps of a stopped recording, or zero if unknown
+  std::uint64_t m_numSteps{};
+
+  // Recording, and the step of the last event written to it, as records only
+  // store the difference
+  std::ofstream m_output;
+  std::uint64_t m_lastStep{};
+
+  // Decoded events of the replayed log
+  std::vector<Event> m_events;
+  std::size_t m_nextEvent{};
+  bool m_replaying{};
+};
+
+#endif
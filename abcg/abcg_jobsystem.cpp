@@ -0,0 +1,354 @@
+/**
+ * @file abcg_jobsystem.cpp
+ * @brief Definition of abcg::JobSystem and abcg::TaskGraph class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_jobsystem.hpp"
+
+#include <algorithm>
+
+#include "abcg_exception.hpp"
+#include "abcg_profiler.hpp"
+
+namespace {
+// Job system whose worker is the current thread, if any, and the index of the
+// worker's queue
+thread_local const abcg::JobSystem *currentJobSystem{};
+thread_local std::size_t currentQueue{};
+}  // namespace
+
+/**
+ * @brief Constructs a job system and starts its worker threads.
+ *
+ * @param numWorkers Number of worker threads. With no worker threads, jobs
+ * are run by the threads that wait for them.
+ */
+abcg::JobSystem::JobSystem(std::size_t numWorkers) {
+  m_queues.reserve(numWorkers + 1);
+  for (std::size_t index{}; index <= numWorkers; ++index) {
+    m_queues.push_back(std::make_unique<Queue>());
+  }
+
+  m_threads.reserve(numWorkers);
+  try {
+    for (std::size_t index{}; index < numWorkers; ++index) {
+      m_threads.emplace_back(&JobSystem::workerLoop, this, index);
+    }
+  } catch (...) {
+    stopWorkers();
+    throw;
+  }
+}
+
+/**
+ * @brief Runs the jobs still queued and stops the worker threads.
+ */
+abcg::JobSystem::~JobSystem() { stopWorkers(); }
+
+/**
+ * @brief Returns the job system shared by the application.
+ *
+ * It is created by the first call, with the default number of worker threads.
+ *
+ * @return Reference to the shared job system.
+ */
+abcg::JobSystem &abcg::JobSystem::getInstance() {
+  static JobSystem instance;
+  return instance;
+}
+
+/**
+ * @brief Returns the default number of worker threads.
+ *
+ * @return One less than the number of hardware threads, so that the workers
+ * and the main thread do not compete for them, or zero under Emscripten.
+ */
+std::size_t abcg::JobSystem::defaultNumWorkers() noexcept {
+#if defined(__EMSCRIPTEN__)
+  return 0;
+#else
+  const auto numThreads{std::thread::hardware_concurrency()};
+  return numThreads > 1 ? numThreads - 1 : 0;
+#endif
+}
+
+/**
+ * @brief Submits a job.
+ *
+ * @param job Job to run. Must not throw.
+ */
+void abcg::JobSystem::submit(Job job) { push(std::move(job)); }
+
+/**
+ * @brief Submits a job counted by a counter.
+ *
+ * @param job Job to run.
+ * @param counter Counter of the job. Must outlive the job, and is usually
+ * passed to wait() afterwards.
+ */
+void abcg::JobSystem::submit(Job job, Counter &counter) {
+  counter.m_value.fetch_add(1, std::memory_order_relaxed);
+  push([job = std::move(job), &counter] {
+    try {
+      job();
+    } catch (...) {
+      const std::scoped_lock lock{counter.m_mutex};
+      if (!counter.m_exception) counter.m_exception = std::current_exception();
+    }
+    counter.m_value.fetch_sub(1, std::memory_order_release);
+  });
+}
+
+/**
+ * @brief Waits until every job submitted with a counter is done.
+ *
+ * The calling thread runs queued jobs while it waits.
+ *
+ * @param counter Counter of the jobs.
+ *
+ * @throw The first exception thrown by one of the jobs, if any.
+ */
+void abcg::JobSystem::wait(Counter &counter) {
+  while (counter.get() > 0) {
+    if (!runNextJob()) std::this_thread::yield();
+  }
+
+  std::exception_ptr exception;
+  {
+    const std::scoped_lock lock{counter.m_mutex};
+    std::swap(exception, counter.m_exception);
+  }
+  if (exception) std::rethrow_exception(exception);
+}
+
+/**
+ * @brief Calls a function on consecutive subranges of a range of indices in
+ * parallel, and waits until every call returns.
+ *
+ * The calling thread handles the last subrange and runs queued jobs while it
+ * waits.
+ *
+ * @param begin First index of the range.
+ * @param end One past the last index of the range.
+ * @param grainSize Maximum number of indices of each subrange. Should be large
+ * enough for a call to take much longer than submitting a job.
+ * @param function Function called with the first index of a subrange and one
+ * past its last index.
+ *
+ * @throw The first exception thrown by one of the calls, if any.
+ */
+void abcg::JobSystem::parallelFor(
+    std::size_t begin, std::size_t end, std::size_t grainSize,
+    const std::function<void(std::size_t, std::size_t)> &function) {
+  if (begin >= end) return;
+  grainSize = std::max<std::size_t>(grainSize, 1);
+
+  Counter counter;
+  auto first{begin};
+  for (; end - first > grainSize; first += grainSize) {
+    submit([&function, first, last = first + grainSize] {
+      function(first, last);
+    }, counter);
+  }
+
+  try {
+    function(first, end);
+  } catch (...) {
+    // The other calls still reference the function
+    while (counter.get() > 0) {
+      if (!runNextJob()) std::this_thread::yield();
+    }
+    throw;
+  }
+  wait(counter);
+}
+
+/**
+ * @brief Runs the tasks of a task graph and waits until they are done.
+ *
+ * The calling thread runs queued jobs while it waits. If a task throws, the
+ * tasks it precedes are not run.
+ *
+ * @param graph Task graph.
+ *
+ * @throw The first exception thrown by one of the tasks, if any.
+ */
+void abcg::JobSystem::run(const TaskGraph &graph) {
+  const auto &tasks{graph.m_tasks};
+  if (tasks.empty()) return;
+
+  // Number of unfinished predecessors of each task
+  std::vector<std::atomic<std::size_t>> numPending(tasks.size());
+  for (std::size_t index{}; index < tasks.size(); ++index) {
+    numPending[index].store(tasks[index].numPredecessors,
+                            std::memory_order_relaxed);
+  }
+
+  Counter counter;
+  std::function<void(std::size_t)> schedule;
+  schedule = [&](std::size_t index) {
+    submit([&, index] {
+      tasks[index].job();
+      for (const auto successor : tasks[index].successors) {
+        if (numPending[successor].fetch_sub(1, std::memory_order_acq_rel) ==
+            1) {
+          schedule(successor);
+        }
+      }
+    }, counter);
+  };
+
+  for (std::size_t index{}; index < tasks.size(); ++index) {
+    if (tasks[index].numPredecessors == 0) schedule(index);
+  }
+  wait(counter);
+}
+
+/**
+ * @brief Submits a job to be run by the main thread.
+ *
+ * Used for jobs that call OpenGL functions. abcg::OpenGLWindow runs them
+ * before each frame is painted.
+ *
+ * @param job Job to run.
+ */
+void abcg::JobSystem::submitToMainThread(Job job) {
+  const std::scoped_lock lock{m_mainThreadMutex};
+  m_mainThreadJobs.push_back(std::move(job));
+}
+
+/**
+ * @brief Runs the jobs submitted to the main thread.
+ *
+ * Must be called by the main thread. Jobs submitted meanwhile are left for
+ * the next call.
+ *
+ * @return Number of jobs run.
+ *
+ * @throw The exception thrown by a job, if any. The jobs after it are not
+ * run.
+ */
+std::size_t abcg::JobSystem::runMainThreadJobs() {
+  std::vector<Job> jobs;
+  {
+    const std::scoped_lock lock{m_mainThreadMutex};
+    std::swap(jobs, m_mainThreadJobs);
+  }
+  for (auto &job : jobs) job();
+  return jobs.size();
+}
+
+// Queues a job in the queue of the current worker, or in the shared queue,
+// and wakes up a sleeping worker. The job is counted before it is queued, so
+// the count is never lower than the number of queued jobs.
+void abcg::JobSystem::push(Job job) {
+  const auto index{currentJobSystem == this ? currentQueue
+                                            : m_queues.size() - 1};
+  m_numQueued.fetch_add(1, std::memory_order_release);
+  {
+    auto &queue{*m_queues[index]};
+    const std::scoped_lock lock{queue.mutex};
+    queue.jobs.push_back(std::move(job));
+  }
+
+  // Taking the lock ensures that a worker about to sleep sees the new count
+  { const std::scoped_lock lock{m_sleepMutex}; }
+  m_wakeUp.notify_one();
+}
+
+// Runs the most recently queued job of the current worker, or else steals the
+// oldest job of another queue. Returns whether a job was run.
+bool abcg::JobSystem::runNextJob() {
+  const auto numWorkers{m_queues.size() - 1};
+  const auto own{currentJobSystem == this ? currentQueue : numWorkers};
+
+  Job job;
+  for (std::size_t offset{}; offset < m_queues.size() && !job; ++offset) {
+    const auto index{(own + offset) % m_queues.size()};
+    auto &queue{*m_queues[index]};
+    const std::scoped_lock lock{queue.mutex};
+    if (queue.jobs.empty()) continue;
+    if (offset == 0 && index < numWorkers) {
+      job = std::move(queue.jobs.back());
+      queue.jobs.pop_back();
+    } else {
+      job = std::move(queue.jobs.front());
+      queue.jobs.pop_front();
+    }
+  }
+  if (!job) return false;
+
+  m_numQueued.fetch_sub(1, std::memory_order_relaxed);
+  ABCG_PROFILE_SCOPE("Job");
+  job();
+  return true;
+}
+
+// Runs jobs until the job system is stopped and no job is left, sleeping
+// whenever there is nothing to run
+void abcg::JobSystem::workerLoop(std::size_t index) {
+  currentJobSystem = this;
+  currentQueue = index;
+  ABCG_PROFILE_THREAD("Worker");
+
+  while (true) {
+    if (runNextJob()) continue;
+
+    std::unique_lock lock{m_sleepMutex};
+    m_wakeUp.wait(lock, [this] {
+      return m_stop || m_numQueued.load(std::memory_order_acquire) > 0;
+    });
+    if (m_stop && m_numQueued.load(std::memory_order_acquire) == 0) return;
+  }
+}
+
+// Wakes up the workers so that they finish the queued jobs and return
+void abcg::JobSystem::stopWorkers() noexcept {
+  {
+    const std::scoped_lock lock{m_sleepMutex};
+    m_stop = true;
+  }
+  m_wakeUp.notify_all();
+  for (auto &thread : m_threads) thread.join();
+  m_threads.clear();
+}
+
+/**
+ * @brief Adds a task.
+ *
+ * @param job Job run by the task.
+ * @return Index of the task.
+ */
+std::size_t abcg::TaskGraph::add(JobSystem::Job job) {
+  m_tasks.push_back({.job{std::move(job)}, .successors{}, .numPredecessors{}});
+  return m_tasks.size() - 1;
+}
+
+/**
+ * @brief Makes a task run only after another one is done.
+ *
+ * @param task Index of the task that runs first.
+ * @param successor Index of the task that runs after it.
+ *
+ * @throw abcg::Exception if a task does not exist, or if the successor was
+ * not added after the task.
+ */
+void abcg::TaskGraph::precede(std::size_t task, std::size_t successor) {
+  if (successor >= m_tasks.size()) {
+    throw abcg::Exception{abcg::Exception::Runtime("Task does not exist")};
+  }
+  if (task >= successor) {
+    throw abcg::Exception{abcg::Exception::Runtime(
+        "Task must be added before the tasks it precedes")};
+  }
+
+  m_tasks[task].successors.push_back(successor);
+  ++m_tasks[successor].numPredecessors;
+}
+
+/**
+ * @brief Removes every task.
+ */
+void abcg::TaskGraph::clear() noexcept { m_tasks.clear(); }
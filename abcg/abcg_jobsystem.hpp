@@ -0,0 +1,159 @@
+/**
+ * @file abcg_jobsystem.hpp
+ * @brief abcg::JobSystem and abcg::TaskGraph header files.
+ *
+ * Declaration of abcg::JobSystem and abcg::TaskGraph classes.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_JOBSYSTEM_HPP_
+#define ABCG_JOBSYSTEM_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace abcg {
+class JobSystem;
+class TaskGraph;
+}  // namespace abcg
+
+/**
+ * @brief abcg::JobSystem class.
+ *
+ * Pool of worker threads shared by every subsystem that has work to run in
+ * parallel, such as asset loaders, culling and simulation, so that none of
+ * them has to spawn threads of its own.
+ *
+ * Each worker has its own queue of jobs. A job submitted by a worker goes to
+ * the back of that worker's queue, from which the worker also takes its next
+ * job, so that related jobs tend to run on the same thread. A worker whose
+ * queue is empty steals from the front of the other queues. Jobs submitted
+ * by any other thread go to a shared queue from which every worker steals.
+ *
+ * Waiting for jobs does not block: wait(), parallelFor() and run() keep the
+ * calling thread running queued jobs until the awaited ones are done. With no
+ * worker threads, as under Emscripten, every job is run this way by the
+ * thread that waits for it.
+ *
+ * OpenGL functions can only be called by the thread of the OpenGL context.
+ * Jobs that call them are submitted with submitToMainThread() and run by
+ * abcg::OpenGLWindow before each frame is painted.
+ *
+ * An exception thrown by a job submitted with a counter is rethrown by
+ * wait(), and thus by parallelFor() and run(). Other jobs must not throw.
+ */
+class abcg::JobSystem {
+ public:
+  /** @brief Function run by a job. */
+  using Job = std::function<void()>;
+
+  /**
+   * @brief Number of unfinished jobs submitted with it, and the first
+   * exception thrown by one of them.
+   *
+   * Passed to submit() and then to wait().
+   */
+  class Counter {
+   public:
+    [[nodiscard]] std::size_t get() const noexcept {
+      return m_value.load(std::memory_order_acquire);
+    }
+
+   private:
+    friend JobSystem;
+
+    std::atomic<std::size_t> m_value{};
+    std::mutex m_mutex;
+    std::exception_ptr m_exception;
+  };
+
+  explicit JobSystem(std::size_t numWorkers = defaultNumWorkers());
+  JobSystem(const JobSystem &) = delete;
+  JobSystem(JobSystem &&) = delete;
+  JobSystem &operator=(const JobSystem &) = delete;
+  JobSystem &operator=(JobSystem &&) = delete;
+  ~JobSystem();
+
+  static JobSystem &getInstance();
+  [[nodiscard]] static std::size_t defaultNumWorkers() noexcept;
+
+  void submit(Job job);
+  void submit(Job job, Counter &counter);
+  void wait(Counter &counter);
+  void parallelFor(
+      std::size_t begin, std::size_t end, std::size_t grainSize,
+      const std::function<void(std::size_t, std::size_t)> &function);
+  void run(const TaskGraph &graph);
+
+  void submitToMainThread(Job job);
+  std::size_t runMainThreadJobs();
+
+  [[nodiscard]] std::size_t getNumWorkers() const noexcept {
+    return m_threads.size();
+  }
+
+ private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Job> jobs;
+  };
+
+  void push(Job job);
+  bool runNextJob();
+  void workerLoop(std::size_t index);
+  void stopWorkers() noexcept;
+
+  // One queue per worker, followed by the queue of jobs submitted by other
+  // threads
+  std::vector<std::unique_ptr<Queue>> m_queues;
+  std::vector<std::thread> m_threads;
+  std::atomic<std::size_t> m_numQueued{};
+
+  std::mutex m_sleepMutex;
+  std::condition_variable m_wakeUp;
+  bool m_stop{};
+
+  std::mutex m_mainThreadMutex;
+  std::vector<Job> m_mainThreadJobs;
+};
+
+/**
+ * @brief abcg::TaskGraph class.
+ *
+ * Tasks and the dependencies between them, run by abcg::JobSystem::run().
+ *
+ * A task is submitted as a job as soon as every task that precedes it is
+ * done, so independent tasks run in parallel. A task can only precede tasks
+ * added after it, so the graph never has cycles. It can be run any number of
+ * times.
+ */
+class abcg::TaskGraph {
+ public:
+  std::size_t add(JobSystem::Job job);
+  void precede(std::size_t task, std::size_t successor);
+  void clear() noexcept;
+
+  [[nodiscard]] std::size_t size() const noexcept { return m_tasks.size(); }
+
+ private:
+  friend JobSystem;
+
+  struct Task {
+    JobSystem::Job job;
+    std::vector<std::size_t> successors;
+    std::size_t numPredecessors{};
+  };
+
+  std::vector<Task> m_tasks;
+};
+
+#endif
@@ -0,0 +1,185 @@
+/**
+ * @file abcg_mesharena.cpp
+ * @brief Definition of abcg::MeshArena class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_mesharena.hpp"
+
+#include <array>
+#include <iterator>
+#include <vector>
+
+#include "abcg_exception.hpp"
+
+/**
+ * @brief Creates the buffers and the VAO of the arena.
+ *
+ * Any previously created OpenGL resources of the arena are released first,
+ * which frees every mesh.
+ *
+ * @param vertexSize Size in bytes of each vertex.
+ * @param maxVertices Capacity of the vertex buffer.
+ * @param maxIndices Capacity of the index buffer.
+ * @param attributes Attributes read from the vertices.
+ */
+void abcg::MeshArena::initializeGL(std::size_t vertexSize, GLuint maxVertices,
+                                   GLuint maxIndices,
+                                   std::span<const Attribute> attributes) {
+  terminateGL();
+
+  m_vertexSize = vertexSize;
+  m_attributes.clear();
+  for (const auto &attribute : attributes) {
+    m_attributes.push_back({.location = attribute.location,
+                            .size = attribute.size,
+                            .offset = attribute.offset});
+  }
+  m_freeVertices.reset(maxVertices);
+  m_freeIndices.reset(maxIndices);
+
+  // Generate VBO
+  glGenBuffers(1, &m_VBO);
+  glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+  glBufferData(GL_ARRAY_BUFFER,
+               static_cast<GLsizeiptr>(maxVertices * m_vertexSize), nullptr,
+               GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  // Generate EBO. It is filled through GL_COPY_WRITE_BUFFER, as binding it to
+  // GL_ELEMENT_ARRAY_BUFFER would change the bound VAO.
+  glGenBuffers(1, &m_EBO);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, m_EBO);
+  glBufferData(GL_COPY_WRITE_BUFFER,
+               static_cast<GLsizeiptr>(maxIndices * sizeof(GLuint)), nullptr,
+               GL_STATIC_DRAW);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+  // Create VAO
+  const std::array bindings{
+      VertexLayout::Binding{.stride = static_cast<GLsizei>(m_vertexSize)}};
+  m_layout.initializeGL(m_attributes, bindings);
+  m_VAO = m_layout.bind(std::array{m_VBO}, std::array<GLintptr, 1>{}, m_EBO);
+  glBindVertexArray(0);
+}
+
+// Internal overload of allocate() with the vertices seen as raw bytes
+abcg::MeshArena::Mesh abcg::MeshArena::allocate(
+    std::span<const std::byte> vertices, std::size_t vertexSize,
+    std::span<const GLuint> indices) {
+  if (vertexSize != m_vertexSize) {
+    throw abcg::Exception{
+        abcg::Exception::Runtime("Wrong vertex size for mesh arena")};
+  }
+
+  const auto numVertices{static_cast<GLuint>(vertices.size() / vertexSize)};
+  const auto count{static_cast<GLuint>(indices.size())};
+
+  const auto firstVertex{m_freeVertices.allocate(numVertices)};
+  if (!firstVertex) {
+    throw abcg::Exception{abcg::Exception::Runtime("Mesh arena is full")};
+  }
+  const auto firstIndex{m_freeIndices.allocate(count)};
+  if (!firstIndex) {
+    m_freeVertices.free(*firstVertex, numVertices);
+    throw abcg::Exception{abcg::Exception::Runtime("Mesh arena is full")};
+  }
+
+  Mesh mesh;
+  mesh.count = count;
+  mesh.firstIndex = *firstIndex;
+  mesh.firstVertex = *firstVertex;
+  mesh.numVertices = numVertices;
+
+  glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+  glBufferSubData(GL_ARRAY_BUFFER,
+                  static_cast<GLintptr>(mesh.firstVertex * m_vertexSize),
+                  static_cast<GLsizeiptr>(vertices.size()), vertices.data());
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  const auto indexOffset{
+      static_cast<GLintptr>(mesh.firstIndex * sizeof(GLuint))};
+  const auto indexSize{static_cast<GLsizeiptr>(indices.size_bytes())};
+  glBindBuffer(GL_COPY_WRITE_BUFFER, m_EBO);
+#if defined(__EMSCRIPTEN__)
+  // No base vertex in WebGL 2.0: rebase the indices here instead
+  std::vector<GLuint> rebased;
+  rebased.reserve(indices.size());
+  for (const auto index : indices) rebased.push_back(index + mesh.firstVertex);
+  glBufferSubData(GL_COPY_WRITE_BUFFER, indexOffset, indexSize,
+                  rebased.data());
+  mesh.baseVertex = 0;
+#else
+  glBufferSubData(GL_COPY_WRITE_BUFFER, indexOffset, indexSize,
+                  indices.data());
+  mesh.baseVertex = static_cast<GLint>(mesh.firstVertex);
+#endif
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+  return mesh;
+}
+
+/**
+ * @brief Returns the space of a mesh to the arena.
+ *
+ * @param mesh Mesh returned by allocate(). Meshes with no vertices are
+ * ignored.
+ */
+void abcg::MeshArena::free(const Mesh &mesh) {
+  if (mesh.numVertices == 0) return;
+  m_freeVertices.free(mesh.firstVertex, mesh.numVertices);
+  m_freeIndices.free(mesh.firstIndex, mesh.count);
+}
+
+/**
+ * @brief Releases the OpenGL resources of the arena.
+ */
+void abcg::MeshArena::terminateGL() {
+  m_layout.terminateGL();
+  glDeleteBuffers(1, &m_EBO);
+  glDeleteBuffers(1, &m_VBO);
+
+  m_EBO = 0;
+  m_VBO = 0;
+  m_VAO = 0;
+  m_freeVertices.reset(0);
+  m_freeIndices.reset(0);
+}
+
+// Makes the whole capacity a single free range
+void abcg::MeshArena::FreeList::reset(GLuint capacity) {
+  m_ranges.clear();
+  if (capacity > 0) m_ranges.emplace(0, capacity);
+}
+
+// Returns the offset of the first free range with enough space
+std::optional<GLuint> abcg::MeshArena::FreeList::allocate(GLuint size) {
+  for (auto iter{m_ranges.begin()}; iter != m_ranges.end(); ++iter) {
+    const auto [offset, rangeSize]{*iter};
+    if (rangeSize < size) continue;
+    m_ranges.erase(iter);
+    if (rangeSize > size) m_ranges.emplace(offset + size, rangeSize - size);
+    return offset;
+  }
+  return std::nullopt;
+}
+
+// Inserts a free range, merging it with adjacent free ranges
+void abcg::MeshArena::FreeList::free(GLuint offset, GLuint size) {
+  if (size == 0) return;
+
+  auto next{m_ranges.lower_bound(offset)};
+  if (next != m_ranges.end() && offset + size == next->first) {
+    size += next->second;
+    next = m_ranges.erase(next);
+  }
+  if (next != m_ranges.begin()) {
+    const auto previous{std::prev(next)};
+    if (previous->first + previous->second == offset) {
+      previous->second += size;
+      return;
+    }
+  }
+  m_ranges.emplace_hint(next, offset, size);
+}
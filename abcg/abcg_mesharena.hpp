@@ -0,0 +1,131 @@
+/**
+ * @file abcg_mesharena.hpp
+ * @brief abcg::MeshArena header file.
+ *
+ * Declaration of abcg::MeshArena class.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_MESHARENA_HPP_
+#define ABCG_MESHARENA_HPP_
+
+#include <cstddef>
+#include <map>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "abcg_openglfunctions.hpp"
+#include "abcg_vertexlayout.hpp"
+
+namespace abcg {
+class MeshArena;
+}  // namespace abcg
+
+/**
+ * @brief abcg::MeshArena class.
+ *
+ * Vertex and index buffers of fixed capacity shared by every mesh of the same
+ * vertex layout, with a single VAO.
+ *
+ * Meshes are suballocated from the two buffers with first-fit free lists, and
+ * are referenced by the range of their indices and by the offset of their
+ * first vertex (base vertex), so that their indices remain local to the mesh.
+ * Freed ranges are merged with their free neighbors.
+ *
+ * Attributes are bound to fixed locations, so the VAO can be used with any
+ * program that declares them with the same `layout(location = ...)`. Other
+ * VAOs can read the same buffers through an abcg::VertexLayout that extends
+ * getAttributes(), e.g. with per-instance attributes.
+ *
+ * WebGL 2.0 has no base vertex, so there the indices are offset on the CPU
+ * when the mesh is allocated, and Mesh::baseVertex is zero.
+ */
+class abcg::MeshArena {
+ public:
+  /**
+   * @brief Location of a mesh in the shared buffers.
+   */
+  struct Mesh {
+    GLuint count{};
+    GLuint firstIndex{};
+    GLint baseVertex{};
+    GLuint firstVertex{};
+    GLuint numVertices{};
+  };
+
+  /**
+   * @brief Vertex attribute of floats read from the interleaved vertices.
+   */
+  struct Attribute {
+    GLuint location{};
+    GLint size{};
+    std::size_t offset{};
+  };
+
+  void initializeGL(std::size_t vertexSize, GLuint maxVertices,
+                    GLuint maxIndices, std::span<const Attribute> attributes);
+  template <typename T>
+  Mesh allocate(std::span<const T> vertices, std::span<const GLuint> indices);
+  void free(const Mesh &mesh);
+  void terminateGL();
+
+  [[nodiscard]] GLuint getVAO() const noexcept { return m_VAO; }
+  [[nodiscard]] GLuint getVBO() const noexcept { return m_VBO; }
+  [[nodiscard]] GLuint getEBO() const noexcept { return m_EBO; }
+  [[nodiscard]] std::size_t getVertexSize() const noexcept {
+    return m_vertexSize;
+  }
+  [[nodiscard]] std::span<const VertexLayout::Attribute> getAttributes()
+      const noexcept {
+    return m_attributes;
+  }
+
+ private:
+  // First-fit allocator of ranges of elements
+  class FreeList {
+   public:
+    void reset(GLuint capacity);
+    std::optional<GLuint> allocate(GLuint size);
+    void free(GLuint offset, GLuint size);
+
+   private:
+    // Offset and size of each free range
+    std::map<GLuint, GLuint> m_ranges;
+  };
+
+  Mesh allocate(std::span<const std::byte> vertices, std::size_t vertexSize,
+                std::span<const GLuint> indices);
+
+  GLuint m_VAO{};
+  GLuint m_VBO{};
+  GLuint m_EBO{};
+
+  std::size_t m_vertexSize{};
+  // Attributes read from binding 0 of the layout
+  std::vector<VertexLayout::Attribute> m_attributes;
+  VertexLayout m_layout;
+
+  FreeList m_freeVertices;
+  FreeList m_freeIndices;
+};
+
+/**
+ * @brief Copies a mesh to the shared buffers.
+ *
+ * @tparam T Vertex type. Its size must be the one given to initializeGL().
+ * @param vertices Vertices of the mesh.
+ * @param indices Triangle indices, local to the vertices of the mesh.
+ * @return Location of the mesh.
+ *
+ * @throw abcg::Exception if the vertex size is wrong or if there is not
+ * enough free space.
+ */
+template <typename T>
+abcg::MeshArena::Mesh abcg::MeshArena::allocate(
+    std::span<const T> vertices, std::span<const GLuint> indices) {
+  return allocate(std::as_bytes(vertices), sizeof(T), indices);
+}
+
+#endif
@@ -0,0 +1,173 @@
+/**
+ * @file abcg_multidrawbatch.cpp
+ * @brief Definition of abcg::MultiDrawBatch class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_multidrawbatch.hpp"
+
+#include <string>
+
+/**
+ * @brief Creates the VAO of the batch.
+ *
+ * Any previously created OpenGL resources of the batch are released first.
+ * Instance attributes not declared by the program are ignored.
+ *
+ * @param arena Arena of the meshes drawn by the batch.
+ * @param program Shader program used with the batch.
+ * @param instanceVBO Buffer with per-instance data, or 0 if none.
+ * @param instanceStride Size in bytes of the data of each instance.
+ * @param instanceAttributes Attributes read from `instanceVBO`, advancing
+ * once per instance.
+ */
+void abcg::MultiDrawBatch::initializeGL(
+    const MeshArena &arena, GLuint program, GLuint instanceVBO,
+    GLsizei instanceStride, std::span<const Attribute> instanceAttributes) {
+  terminateGL();
+
+  m_buffers = {arena.getVBO(), instanceVBO};
+  m_numBindings = instanceVBO != 0 ? 2 : 1;
+  m_EBO = arena.getEBO();
+  m_instanceStride = instanceStride;
+
+#if defined(__EMSCRIPTEN__)
+  m_indirect = false;
+#else
+  // A nonzero baseInstance in the indirect commands needs OpenGL 4.2 or
+  // GL_ARB_base_instance
+  m_indirect = (GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect) &&
+               (GLEW_VERSION_4_2 || GLEW_ARB_base_instance);
+  if (m_indirect) glGenBuffers(1, &m_indirectBuffer);
+#endif
+
+  // Vertices of the arena in binding 0, and instances in binding 1
+  std::vector<VertexLayout::Attribute> attributes(
+      arena.getAttributes().begin(), arena.getAttributes().end());
+  if (instanceVBO != 0) {
+    for (const auto &attribute : instanceAttributes) {
+      const auto location{
+          glGetAttribLocation(program, std::string{attribute.name}.c_str())};
+      if (location < 0) continue;
+      for (GLint column{}; column < attribute.columns; ++column) {
+        attributes.push_back(
+            {.location = static_cast<GLuint>(location + column),
+             .size = attribute.size,
+             .offset = attribute.offset +
+                       static_cast<std::size_t>(column * attribute.size) *
+                           sizeof(float),
+             .binding = 1});
+      }
+    }
+  }
+  const std::array<VertexLayout::Binding, 2> bindings{
+      {{.stride = static_cast<GLsizei>(arena.getVertexSize())},
+       {.stride = instanceStride, .divisor = 1}}};
+  m_layout.initializeGL(attributes,
+                        std::span(bindings).first(m_numBindings));
+
+  // Create VAO
+  bindVertexArray(0);
+  glBindVertexArray(0);
+}
+
+/**
+ * @brief Removes the commands recorded since the last call.
+ */
+void abcg::MultiDrawBatch::clearCommands() noexcept { m_commands.clear(); }
+
+/**
+ * @brief Records a command that draws a mesh of the batch.
+ *
+ * @param mesh Mesh of the arena given to initializeGL().
+ * @param instanceCount Number of instances to draw.
+ * @param baseInstance Index of the first instance in the instance buffer.
+ */
+void abcg::MultiDrawBatch::addCommand(const MeshArena::Mesh &mesh,
+                                      GLuint instanceCount,
+                                      GLuint baseInstance) {
+  if (instanceCount == 0) return;
+
+  Command command;
+  command.count = mesh.count;
+  command.instanceCount = instanceCount;
+  command.firstIndex = mesh.firstIndex;
+  command.baseVertex = mesh.baseVertex;
+  command.baseInstance = baseInstance;
+  m_commands.push_back(command);
+}
+
+/**
+ * @brief Issues the commands recorded since clearCommands().
+ *
+ * The program must be in use. The VAO of the batch is left bound.
+ */
+void abcg::MultiDrawBatch::draw() {
+  bindVertexArray(m_indirect ? 0 : m_currentBaseInstance);
+  if (m_commands.empty()) return;
+
+#if !defined(__EMSCRIPTEN__)
+  if (m_indirect) {
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER,
+                 static_cast<GLsizeiptr>(m_commands.size() * sizeof(Command)),
+                 m_commands.data(), GL_STREAM_DRAW);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr,
+                                static_cast<GLsizei>(m_commands.size()), 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    return;
+  }
+#endif
+
+  for (const auto &command : m_commands) {
+    if (command.baseInstance != m_currentBaseInstance) {
+      bindVertexArray(command.baseInstance);
+    }
+
+    const auto count{static_cast<GLsizei>(command.count)};
+    const auto *indices{
+        reinterpret_cast<void *>(command.firstIndex * sizeof(GLuint))};
+#if defined(__EMSCRIPTEN__)
+    if (command.instanceCount > 1) {
+      glDrawElementsInstanced(GL_TRIANGLES, count, GL_UNSIGNED_INT, indices,
+                              static_cast<GLsizei>(command.instanceCount));
+    } else {
+      glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, indices);
+    }
+#else
+    if (command.instanceCount > 1) {
+      glDrawElementsInstancedBaseVertex(
+          GL_TRIANGLES, count, GL_UNSIGNED_INT, indices,
+          static_cast<GLsizei>(command.instanceCount), command.baseVertex);
+    } else {
+      glDrawElementsBaseVertex(GL_TRIANGLES, count, GL_UNSIGNED_INT, indices,
+                               command.baseVertex);
+    }
+#endif
+  }
+}
+
+/**
+ * @brief Releases the OpenGL resources of the batch.
+ *
+ * The arena and the instance buffer are not deleted.
+ */
+void abcg::MultiDrawBatch::terminateGL() {
+  glDeleteBuffers(1, &m_indirectBuffer);
+  m_layout.terminateGL();
+
+  m_indirectBuffer = 0;
+  m_VAO = 0;
+  m_buffers = {};
+  m_currentBaseInstance = 0;
+}
+
+// Binds the VAO with the instance buffer attached at the given instance
+void abcg::MultiDrawBatch::bindVertexArray(GLuint baseInstance) {
+  const std::array<GLintptr, 2> offsets{
+      0, static_cast<GLintptr>(baseInstance) * m_instanceStride};
+  m_VAO = m_layout.bind(std::span(m_buffers).first(m_numBindings),
+                        std::span(offsets).first(m_numBindings), m_EBO);
+  m_currentBaseInstance = baseInstance;
+}
@@ -0,0 +1,116 @@
+/**
+ * @file abcg_multidrawbatch.hpp
+ * @brief abcg::MultiDrawBatch header file.
+ *
+ * Declaration of abcg::MultiDrawBatch class.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_MULTIDRAWBATCH_HPP_
+#define ABCG_MULTIDRAWBATCH_HPP_
+
+#include <array>
+#include <cstddef>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "abcg_mesharena.hpp"
+#include "abcg_openglfunctions.hpp"
+#include "abcg_vertexlayout.hpp"
+
+namespace abcg {
+class MultiDrawBatch;
+}  // namespace abcg
+
+/**
+ * @brief abcg::MultiDrawBatch class.
+ *
+ * Meshes of an abcg::MeshArena drawn with one call per frame.
+ *
+ * Every frame, the application records one command per mesh to be drawn,
+ * then calls draw():
+ *
+ * - On OpenGL 4.3, or with `GL_ARB_multi_draw_indirect` and
+ * `GL_ARB_base_instance`, the commands are uploaded to a
+ * `GL_DRAW_INDIRECT_BUFFER` and issued with a single
+ * `glMultiDrawElementsIndirect`.
+ * - Otherwise (e.g. OpenGL 4.1 on macOS), each command is issued with
+ * `glDrawElementsBaseVertex` or `glDrawElementsInstancedBaseVertex`.
+ * - On WebGL 2.0, which has no base vertex, each command is issued with
+ * `glDrawElements` or `glDrawElementsInstanced`, as the arena has already
+ * offset the indices.
+ *
+ * The batch has its own VAO, which reads the vertices from the arena and
+ * per-instance attributes from a buffer owned by the application. The first
+ * instance of a command is read at `baseInstance`. Without multi-draw
+ * indirect, this is emulated by attaching the instance buffer at an offset
+ * before the command is issued, which the abcg::VertexLayout of the batch does
+ * without specifying the attributes again.
+ */
+class abcg::MultiDrawBatch {
+ public:
+  /**
+   * @brief Draw command with the layout of `DrawElementsIndirectCommand`.
+   */
+  struct Command {
+    GLuint count{};
+    GLuint instanceCount{1};
+    GLuint firstIndex{};
+    GLint baseVertex{};
+    GLuint baseInstance{};
+  };
+
+  /**
+   * @brief Per-instance attribute of floats read from an interleaved buffer.
+   *
+   * Matrix attributes use one location per column. `columns` consecutive
+   * locations are then set up, each with `size` floats.
+   */
+  struct Attribute {
+    std::string_view name;
+    GLint size{};
+    std::size_t offset{};
+    GLint columns{1};
+  };
+
+  void initializeGL(const MeshArena &arena, GLuint program,
+                    GLuint instanceVBO = 0, GLsizei instanceStride = 0,
+                    std::span<const Attribute> instanceAttributes = {});
+  void clearCommands() noexcept;
+  void addCommand(const MeshArena::Mesh &mesh, GLuint instanceCount = 1,
+                  GLuint baseInstance = 0);
+  void draw();
+  void terminateGL();
+
+  [[nodiscard]] GLuint getVAO() const noexcept { return m_VAO; }
+  [[nodiscard]] const VertexLayout &getLayout() const noexcept {
+    return m_layout;
+  }
+  [[nodiscard]] bool isIndirect() const noexcept { return m_indirect; }
+  [[nodiscard]] std::size_t getNumCommands() const noexcept {
+    return m_commands.size();
+  }
+
+ private:
+  void bindVertexArray(GLuint baseInstance);
+
+  VertexLayout m_layout;
+  // Vertex buffer of the arena and instance buffer, attached to bindings 0
+  // and 1 of the layout
+  std::array<GLuint, 2> m_buffers{};
+  std::size_t m_numBindings{};
+  GLuint m_EBO{};
+  GLsizei m_instanceStride{};
+
+  // VAO bound by the last draw
+  GLuint m_VAO{};
+  GLuint m_indirectBuffer{};
+  bool m_indirect{};
+
+  std::vector<Command> m_commands;
+  GLuint m_currentBaseInstance{};
+};
+
+#endif
@@ -0,0 +1,216 @@
+/**
+ * @file abcg_occlusionculler.cpp
+ * @brief Definition of abcg::OcclusionCuller class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_occlusionculler.hpp"
+
+#include <array>
+#include <glm/common.hpp>
+#include <glm/vector_relational.hpp>
+
+/**
+ * @brief Reads the query result if it is already available.
+ *
+ * Never waits for the GPU. If the result is not available yet, the last
+ * known visibility is kept.
+ */
+void abcg::OcclusionCuller::Query::update() {
+  if (!m_pending) return;
+
+  GLuint available{};
+  glGetQueryObjectuiv(m_id, GL_QUERY_RESULT_AVAILABLE, &available);
+  if (available == GL_FALSE) return;
+
+  GLuint anySamplesPassed{};
+  glGetQueryObjectuiv(m_id, GL_QUERY_RESULT, &anySamplesPassed);
+  if (!m_discard) m_visible = anySamplesPassed != GL_FALSE;
+
+  m_pending = false;
+  m_discard = false;
+}
+
+/**
+ * @brief Marks the object as visible, as when it is moved to a new place.
+ *
+ * The result of a query still in flight is discarded when it arrives.
+ */
+void abcg::OcclusionCuller::Query::reset() noexcept {
+  m_visible = true;
+  m_discard = m_pending;
+}
+
+/**
+ * @brief Releases the query object.
+ */
+void abcg::OcclusionCuller::Query::terminateGL() {
+  if (m_id != 0) glDeleteQueries(1, &m_id);
+  m_id = 0;
+  m_pending = false;
+  m_discard = false;
+  m_visible = true;
+}
+
+/**
+ * @brief Creates the unit cube used for drawing the bounding boxes.
+ *
+ * Any previously created OpenGL resources of the culler are released first.
+ *
+ * @param program Shader program used for drawing the boxes.
+ */
+void abcg::OcclusionCuller::initializeGL(GLuint program) {
+  terminateGL();
+
+  m_program = program;
+  m_boxMinLoc = glGetUniformLocation(m_program, "boxMin");
+  m_boxMaxLoc = glGetUniformLocation(m_program, "boxMax");
+
+#if defined(__EMSCRIPTEN__)
+  m_target = GL_ANY_SAMPLES_PASSED_CONSERVATIVE;
+#else
+  m_target = (GLEW_VERSION_4_3 || GLEW_ARB_ES3_compatibility)
+                 ? GL_ANY_SAMPLES_PASSED_CONSERVATIVE
+                 : GL_ANY_SAMPLES_PASSED;
+#endif
+
+  // clang-format off
+  const std::array<glm::vec3, 8> positions{{{0, 0, 0}, {1, 0, 0},
+                                            {1, 1, 0}, {0, 1, 0},
+                                            {0, 0, 1}, {1, 0, 1},
+                                            {1, 1, 1}, {0, 1, 1}}};
+  const std::array<GLubyte, 36> indices{0, 2, 1, 0, 3, 2,  // Back
+                                        4, 5, 6, 4, 6, 7,  // Front
+                                        0, 1, 5, 0, 5, 4,  // Bottom
+                                        3, 7, 6, 3, 6, 2,  // Top
+                                        0, 4, 7, 0, 7, 3,  // Left
+                                        1, 2, 6, 1, 6, 5}; // Right
+  // clang-format on
+
+  // Generate VBO
+  glGenBuffers(1, &m_VBO);
+  glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(positions), positions.data(),
+               GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  // Generate EBO
+  glGenBuffers(1, &m_EBO);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices.data(),
+               GL_STATIC_DRAW);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+  // Create VAO
+  glGenVertexArrays(1, &m_VAO);
+
+  // Bind vertex attributes to current VAO
+  glBindVertexArray(m_VAO);
+
+  glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+  if (auto location{glGetAttribLocation(m_program, "inPosition")};
+      location >= 0) {
+    glEnableVertexAttribArray(static_cast<GLuint>(location));
+    glVertexAttribPointer(static_cast<GLuint>(location), 3, GL_FLOAT, GL_FALSE,
+                          sizeof(glm::vec3), nullptr);
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+
+  // End of binding to current VAO
+  glBindVertexArray(0);
+}
+
+/**
+ * @brief Prepares the OpenGL state for issuing queries.
+ *
+ * Must be called after the visible objects of the frame are drawn. Color and
+ * depth writes are disabled until end() is called.
+ *
+ * @param viewProjMatrix Projection matrix times view matrix.
+ * @param eye Camera position in world space.
+ */
+void abcg::OcclusionCuller::begin(const glm::mat4 &viewProjMatrix,
+                                  const glm::vec3 &eye) {
+  m_eye = eye;
+  m_numQueries = 0;
+
+  glUseProgram(m_program);
+  const auto viewProjMatrixLoc{
+      glGetUniformLocation(m_program, "viewProjMatrix")};
+  glUniformMatrix4fv(viewProjMatrixLoc, 1, GL_FALSE, &viewProjMatrix[0][0]);
+
+  glBindVertexArray(m_VAO);
+  glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+  glDepthMask(GL_FALSE);
+}
+
+/**
+ * @brief Issues an occlusion query for a bounding box.
+ *
+ * Nothing is issued while the previous query of the object is in flight.
+ * Boxes that contain the camera are visible without a query, since their
+ * faces may be clipped by the near plane.
+ *
+ * @param query Occlusion state of the object.
+ * @param min Minimum corner of the box in world space.
+ * @param max Maximum corner of the box in world space.
+ */
+void abcg::OcclusionCuller::query(Query &query, const glm::vec3 &min,
+                                  const glm::vec3 &max) {
+  if (glm::all(glm::greaterThanEqual(m_eye, min)) &&
+      glm::all(glm::lessThanEqual(m_eye, max))) {
+    query.reset();
+    return;
+  }
+
+  if (query.m_pending) return;
+
+  if (query.m_id == 0) glGenQueries(1, &query.m_id);
+
+  glUniform3fv(m_boxMinLoc, 1, &min.x);
+  glUniform3fv(m_boxMaxLoc, 1, &max.x);
+
+  glBeginQuery(m_target, query.m_id);
+  glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_BYTE, nullptr);
+  glEndQuery(m_target);
+
+  query.m_pending = true;
+  ++m_numQueries;
+}
+
+/**
+ * @brief Restores the OpenGL state changed by begin().
+ */
+void abcg::OcclusionCuller::end() {
+  glDepthMask(GL_TRUE);
+  glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+  glBindVertexArray(0);
+  glUseProgram(0);
+}
+
+/**
+ * @brief Releases the OpenGL resources of the culler.
+ *
+ * The program given to initializeGL() is not deleted.
+ */
+void abcg::OcclusionCuller::terminateGL() {
+  glDeleteBuffers(1, &m_EBO);
+  glDeleteBuffers(1, &m_VBO);
+  glDeleteVertexArrays(1, &m_VAO);
+
+  m_EBO = 0;
+  m_VBO = 0;
+  m_VAO = 0;
+}
+
+/**
+ * @brief Returns the number of queries issued since the last begin().
+ *
+ * @return Number of queries.
+ */
+std::size_t abcg::OcclusionCuller::getNumQueries() const noexcept {
+  return m_numQueries;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file abcg_occlusionculler.hpp
+ * @brief abcg::OcclusionCuller header file.
+ *
+ * Declaration of abcg::OcclusionCuller class.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_OCCLUSIONCULLER_HPP_
+#define ABCG_OCCLUSIONCULLER_HPP_
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+
+#include "abcg_openglfunctions.hpp"
+
+namespace abcg {
+class OcclusionCuller;
+}  // namespace abcg
+
+/**
+ * @brief abcg::OcclusionCuller class.
+ *
+ * Hardware occlusion culling with bounding boxes and temporal coherence.
+ *
+ * Each object that can be occluded owns an abcg::OcclusionCuller::Query.
+ * Every frame, the application:
+ *
+ * -# Calls Query::update() and skips the full draw of objects whose
+ * Query::isVisible() is false. This only reads results that are already
+ * available, so the CPU never waits for the GPU; until a new result arrives
+ * the previous one is used.
+ * -# Draws the visible objects, which fill the depth buffer.
+ * -# Between begin() and end(), calls query() with the world-space bounding
+ * box of each object, occluded or not, so that hidden objects are detected
+ * again once they come into view.
+ *
+ * Boxes are rasterized with color and depth writes disabled, against the
+ * depth buffer of the current frame. The query target is
+ * `GL_ANY_SAMPLES_PASSED_CONSERVATIVE` when supported (OpenGL 4.3, OpenGL ES
+ * 3.0 and WebGL 2.0), and `GL_ANY_SAMPLES_PASSED` otherwise.
+ *
+ * The program given to initializeGL() must declare the vertex attribute
+ * `inPosition` (vec3, unit cube corners in [0, 1]) and the uniforms
+ * `viewProjMatrix` (mat4), `boxMin` and `boxMax` (vec3).
+ */
+class abcg::OcclusionCuller {
+ public:
+  /**
+   * @brief Occlusion state of one object.
+   */
+  class Query {
+   public:
+    void update();
+    void reset() noexcept;
+    void terminateGL();
+
+    [[nodiscard]] bool isVisible() const noexcept { return m_visible; }
+
+   private:
+    friend OcclusionCuller;
+
+    GLuint m_id{};
+    bool m_pending{};
+    bool m_discard{};
+    bool m_visible{true};
+  };
+
+  void initializeGL(GLuint program);
+  void begin(const glm::mat4 &viewProjMatrix, const glm::vec3 &eye);
+  void query(Query &query, const glm::vec3 &min, const glm::vec3 &max);
+  void end();
+  void terminateGL();
+
+  [[nodiscard]] std::size_t getNumQueries() const noexcept;
+
+ private:
+  GLuint m_program{};
+  GLuint m_VAO{};
+  GLuint m_VBO{};
+  GLuint m_EBO{};
+
+  GLenum m_target{};
+  GLint m_boxMinLoc{};
+  GLint m_boxMaxLoc{};
+
+  glm::vec3 m_eye{};
+  std::size_t m_numQueries{};
+};
+
+#endif
@@ -9,6 +9,10 @@
 
 #include "abcg_exception.hpp"
 
+#if defined(ABCG_GL_STATE_CACHE)
+#include <algorithm>
+#endif
+
 #if !defined(NDEBUG) && !defined(__EMSCRIPTEN__) && !defined(__APPLE__)
 /**
  * @brief Checks OpenGL error status and throws on error with a log message.
@@ -27,4 +31,362 @@ void abcg::checkGLError(
         abcg::Exception::OpenGL(prefix, status, sourceLocation)};
   }
 }
-#endif
\ No newline at end of file
+#endif
+
+#if defined(ABCG_GL_STATE_CACHE)
+namespace {
+
+constexpr std::size_t invalidIndex{std::numeric_limits<std::size_t>::max()};
+
+std::size_t bufferTargetIndex(GLenum target) noexcept {
+  // GL_ELEMENT_ARRAY_BUFFER is not listed as it is part of the VAO state
+  switch (target) {
+    case GL_ARRAY_BUFFER:
+      return 0;
+    case GL_COPY_READ_BUFFER:
+      return 1;
+    case GL_COPY_WRITE_BUFFER:
+      return 2;
+    case GL_PIXEL_PACK_BUFFER:
+      return 3;
+    case GL_PIXEL_UNPACK_BUFFER:
+      return 4;
+    case GL_TRANSFORM_FEEDBACK_BUFFER:
+      return 5;
+    case GL_UNIFORM_BUFFER:
+      return 6;
+    default:
+      return invalidIndex;
+  }
+}
+
+std::size_t textureTargetIndex(GLenum target) noexcept {
+  switch (target) {
+    case GL_TEXTURE_2D:
+      return 0;
+    case GL_TEXTURE_CUBE_MAP:
+      return 1;
+    case GL_TEXTURE_3D:
+      return 2;
+    case GL_TEXTURE_2D_ARRAY:
+      return 3;
+    default:
+      return invalidIndex;
+  }
+}
+
+std::size_t capabilityIndex(GLenum cap) noexcept {
+  switch (cap) {
+    case GL_BLEND:
+      return 0;
+    case GL_CULL_FACE:
+      return 1;
+    case GL_DEPTH_TEST:
+      return 2;
+    case GL_DITHER:
+      return 3;
+    case GL_POLYGON_OFFSET_FILL:
+      return 4;
+    case GL_PRIMITIVE_RESTART_FIXED_INDEX:
+      return 5;
+    case GL_RASTERIZER_DISCARD:
+      return 6;
+    case GL_SAMPLE_ALPHA_TO_COVERAGE:
+      return 7;
+    case GL_SAMPLE_COVERAGE:
+      return 8;
+    case GL_SCISSOR_TEST:
+      return 9;
+    case GL_STENCIL_TEST:
+      return 10;
+    default:
+      return invalidIndex;
+  }
+}
+
+// Replaces every occurrence of the deleted names with zero
+template <typename TContainer>
+void unbindDeleted(TContainer &bindings, GLsizei n, const GLuint *names) {
+  for (auto &binding : bindings) {
+    if (std::find(names, names + n, binding) != names + n) binding = 0;
+  }
+}
+
+}  // namespace
+
+bool abcg::GLStateCache::issue() noexcept {
+  ++m_stats.issued;
+  return true;
+}
+
+bool abcg::GLStateCache::elide() noexcept {
+  ++m_stats.elided;
+  return false;
+}
+
+/**
+ * @brief Records a glUseProgram call.
+ *
+ * @param program Program to be made current.
+ * @return Whether the call must be issued.
+ */
+bool abcg::GLStateCache::useProgram(GLuint program) noexcept {
+  if (m_programUnbindPending) {
+    m_programUnbindPending = false;
+    if (program == m_program) {
+      // Both the pending unbind and this call are redundant
+      ++m_stats.elided;
+      return elide();
+    }
+    if (program != 0) {
+      // The pending unbind is superseded by this call
+      ++m_stats.elided;
+    } else {
+      return elide();
+    }
+  } else if (program == m_program) {
+    return elide();
+  } else if (program == 0 && m_program != m_unknown) {
+    m_programUnbindPending = true;
+    return false;
+  }
+  m_program = program;
+  return issue();
+}
+
+/**
+ * @brief Records a glBindVertexArray call.
+ *
+ * @param array Vertex array object to be bound.
+ * @return Whether the call must be issued.
+ */
+bool abcg::GLStateCache::bindVertexArray(GLuint array) noexcept {
+  if (m_vertexArrayUnbindPending) {
+    m_vertexArrayUnbindPending = false;
+    if (array == m_vertexArray) {
+      ++m_stats.elided;
+      return elide();
+    }
+    if (array != 0) {
+      ++m_stats.elided;
+    } else {
+      return elide();
+    }
+  } else if (array == m_vertexArray) {
+    return elide();
+  } else if (array == 0 && m_vertexArray != m_unknown) {
+    m_vertexArrayUnbindPending = true;
+    return false;
+  }
+  m_vertexArray = array;
+  return issue();
+}
+
+/**
+ * @brief Records a glBindBuffer call.
+ *
+ * Binding to `GL_ELEMENT_ARRAY_BUFFER` is never elided, and issues any
+ * pending VAO unbind first since the binding is stored in the bound VAO.
+ *
+ * @param target Buffer binding target.
+ * @param buffer Buffer to be bound.
+ * @return Whether the call must be issued.
+ */
+bool abcg::GLStateCache::bindBuffer(GLenum target, GLuint buffer) {
+  if (target == GL_ELEMENT_ARRAY_BUFFER) {
+    flushVertexArray();
+    return issue();
+  }
+  const auto index{bufferTargetIndex(target)};
+  if (index == invalidIndex) return issue();
+  if (m_buffers.at(index) == buffer) return elide();
+  m_buffers.at(index) = buffer;
+  return issue();
+}
+
+/**
+ * @brief Records a glActiveTexture call.
+ *
+ * @param texture Texture unit to be made active.
+ * @return Whether the call must be issued.
+ */
+bool abcg::GLStateCache::activeTexture(GLenum texture) noexcept {
+  const std::size_t unit{texture - GL_TEXTURE0};
+  if (unit >= m_maxTextureUnits) {
+    m_activeTextureUnit = m_maxTextureUnits;
+    return issue();
+  }
+  if (unit == m_activeTextureUnit) return elide();
+  m_activeTextureUnit = unit;
+  return issue();
+}
+
+/**
+ * @brief Records a glBindTexture call on the active texture unit.
+ *
+ * @param target Texture binding target.
+ * @param texture Texture to be bound.
+ * @return Whether the call must be issued.
+ */
+bool abcg::GLStateCache::bindTexture(GLenum target, GLuint texture) noexcept {
+  const auto index{textureTargetIndex(target)};
+  if (index == invalidIndex || m_activeTextureUnit >= m_maxTextureUnits) {
+    return issue();
+  }
+  auto &binding{m_textures.at(m_activeTextureUnit).at(index)};
+  if (binding == texture) return elide();
+  binding = texture;
+  return issue();
+}
+
+/**
+ * @brief Records a glBindSampler call.
+ *
+ * @param unit Texture unit.
+ * @param sampler Sampler to be bound.
+ * @return Whether the call must be issued.
+ */
+bool abcg::GLStateCache::bindSampler(GLuint unit, GLuint sampler) noexcept {
+  if (unit >= m_maxTextureUnits) return issue();
+  if (m_samplers.at(unit) == sampler) return elide();
+  m_samplers.at(unit) = sampler;
+  return issue();
+}
+
+/**
+ * @brief Records a glEnable or glDisable call.
+ *
+ * @param cap Capability.
+ * @param enabled Whether the capability is being enabled.
+ * @return Whether the call must be issued.
+ */
+bool abcg::GLStateCache::setCapability(GLenum cap, bool enabled) noexcept {
+  const auto index{capabilityIndex(cap)};
+  if (index == invalidIndex) return issue();
+  const std::int8_t value{enabled ? std::int8_t{1} : std::int8_t{0}};
+  if (m_capabilities.at(index) == value) return elide();
+  m_capabilities.at(index) = value;
+  return issue();
+}
+
+/**
+ * @brief Records an indexed buffer binding.
+ *
+ * glBindBufferBase and glBindBufferRange also bind the buffer to the generic
+ * binding point of the target.
+ *
+ * @param target Buffer binding target.
+ * @param buffer Buffer bound to the target.
+ */
+void abcg::GLStateCache::setBuffer(GLenum target, GLuint buffer) noexcept {
+  ++m_stats.issued;
+  if (const auto index{bufferTargetIndex(target)}; index != invalidIndex) {
+    m_buffers.at(index) = buffer;
+  }
+}
+
+/**
+ * @brief Issues a pending glUseProgram(0) call, if any.
+ */
+void abcg::GLStateCache::flushProgram() {
+  if (!m_programUnbindPending) return;
+  m_programUnbindPending = false;
+  m_program = 0;
+  issue();
+  callGL(sl::current(), ::glUseProgram, 0U);
+}
+
+/**
+ * @brief Issues a pending glBindVertexArray(0) call, if any.
+ */
+void abcg::GLStateCache::flushVertexArray() {
+  if (!m_vertexArrayUnbindPending) return;
+  m_vertexArrayUnbindPending = false;
+  m_vertexArray = 0;
+  issue();
+  callGL(sl::current(), ::glBindVertexArray, 0U);
+}
+
+/**
+ * @brief Records the deletion of buffers, which unbinds them.
+ *
+ * @param n Number of buffers.
+ * @param buffers Array of buffer names.
+ */
+void abcg::GLStateCache::deleteBuffers(GLsizei n,
+                                       const GLuint *buffers) noexcept {
+  unbindDeleted(m_buffers, n, buffers);
+}
+
+/**
+ * @brief Records the deletion of a program.
+ *
+ * A pending unbind of the program is issued first so that the program is
+ * deleted right away instead of when it stops being current.
+ *
+ * @param program Program name.
+ */
+void abcg::GLStateCache::deleteProgram(GLuint program) {
+  if (program == m_program) flushProgram();
+}
+
+/**
+ * @brief Records the deletion of samplers, which unbinds them.
+ *
+ * @param n Number of samplers.
+ * @param samplers Array of sampler names.
+ */
+void abcg::GLStateCache::deleteSamplers(GLsizei n,
+                                        const GLuint *samplers) noexcept {
+  unbindDeleted(m_samplers, n, samplers);
+}
+
+/**
+ * @brief Records the deletion of textures, which unbinds them.
+ *
+ * @param n Number of textures.
+ * @param textures Array of texture names.
+ */
+void abcg::GLStateCache::deleteTextures(GLsizei n,
+                                        const GLuint *textures) noexcept {
+  for (auto &unit : m_textures) {
+    unbindDeleted(unit, n, textures);
+  }
+}
+
+/**
+ * @brief Records the deletion of vertex array objects.
+ *
+ * Deleting the bound VAO reverts the binding to zero, which also settles a
+ * pending unbind.
+ *
+ * @param n Number of vertex array objects.
+ * @param arrays Array of vertex array object names.
+ */
+void abcg::GLStateCache::deleteVertexArrays(GLsizei n,
+                                            const GLuint *arrays) noexcept {
+  if (std::find(arrays, arrays + n, m_vertexArray) != arrays + n) {
+    m_vertexArray = 0;
+    m_vertexArrayUnbindPending = false;
+  }
+}
+
+/**
+ * @brief Marks the whole state as unknown.
+ *
+ * Pending unbinds are dropped: the objects simply remain bound.
+ */
+void abcg::GLStateCache::invalidate() noexcept {
+  m_program = m_unknown;
+  m_vertexArray = m_unknown;
+  m_programUnbindPending = false;
+  m_vertexArrayUnbindPending = false;
+  m_buffers.fill(m_unknown);
+  m_activeTextureUnit = m_maxTextureUnits;
+  for (auto &unit : m_textures) {
+    unit.fill(m_unknown);
+  }
+  m_samplers.fill(m_unknown);
+  m_capabilities.fill(-1);
+}
+#endif
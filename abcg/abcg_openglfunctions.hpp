@@ -17,6 +17,12 @@
 
 #include <string_view>
 
+#if defined(ABCG_GL_STATE_CACHE)
+#include <array>
+#include <cstdint>
+#include <limits>
+#endif
+
 #include "abcg_external.hpp"
 
 namespace abcg {
@@ -78,10 +84,102 @@ auto callGL([[maybe_unused]] sl /*unused*/, TFun&& function, TArgs&&... args) {
 }
 #endif
 
+#if defined(ABCG_GL_STATE_CACHE)
+/**
+ * @brief Shadow copy of the OpenGL state changed by the wrappers below.
+ *
+ * Enabled by defining `ABCG_GL_STATE_CACHE` (CMake option
+ * `ENABLE_GL_STATE_CACHE`). The cache tracks the bound program, vertex array
+ * object, non-indexed buffer bindings, active texture unit, textures and
+ * samplers of each unit, and the enable bits of the common capabilities. The
+ * wrappers ask the cache before each call and skip the calls that would not
+ * change the state.
+ *
+ * Binding program or VAO zero is deferred: it is dropped if the same object
+ * is bound again, as when objects unbind at the end of their paintGL and the
+ * next one binds the same program. A pending VAO unbind is issued before any
+ * call that would otherwise modify the VAO that is still bound, and before
+ * draw calls.
+ *
+ * State not yet known, such as right after the context is created or after
+ * third-party code issues OpenGL calls directly, is never elided. Call
+ * invalidate() after such code runs.
+ */
+class GLStateCache {
+ public:
+  /**
+   * @brief Number of calls issued to OpenGL and elided by the cache.
+   */
+  struct Stats {
+    std::size_t issued{};
+    std::size_t elided{};
+  };
+
+  GLStateCache() noexcept { invalidate(); }
+
+  [[nodiscard]] bool useProgram(GLuint program) noexcept;
+  [[nodiscard]] bool bindVertexArray(GLuint array) noexcept;
+  [[nodiscard]] bool bindBuffer(GLenum target, GLuint buffer);
+  [[nodiscard]] bool activeTexture(GLenum texture) noexcept;
+  [[nodiscard]] bool bindTexture(GLenum target, GLuint texture) noexcept;
+  [[nodiscard]] bool bindSampler(GLuint unit, GLuint sampler) noexcept;
+  [[nodiscard]] bool setCapability(GLenum cap, bool enabled) noexcept;
+
+  void setBuffer(GLenum target, GLuint buffer) noexcept;
+  void flushProgram();
+  void flushVertexArray();
+
+  void deleteBuffers(GLsizei n, const GLuint* buffers) noexcept;
+  void deleteProgram(GLuint program);
+  void deleteSamplers(GLsizei n, const GLuint* samplers) noexcept;
+  void deleteTextures(GLsizei n, const GLuint* textures) noexcept;
+  void deleteVertexArrays(GLsizei n, const GLuint* arrays) noexcept;
+
+  void invalidate() noexcept;
+
+  [[nodiscard]] const Stats& getStats() const noexcept { return m_stats; }
+  void resetStats() noexcept { m_stats = {}; }
+
+ private:
+  static constexpr GLuint m_unknown{std::numeric_limits<GLuint>::max()};
+  static constexpr std::size_t m_maxTextureUnits{32};
+  static constexpr std::size_t m_numBufferTargets{7};
+  static constexpr std::size_t m_numTextureTargets{4};
+  static constexpr std::size_t m_numCapabilities{11};
+
+  bool issue() noexcept;
+  bool elide() noexcept;
+
+  GLuint m_program{m_unknown};
+  GLuint m_vertexArray{m_unknown};
+  bool m_programUnbindPending{};
+  bool m_vertexArrayUnbindPending{};
+
+  std::array<GLuint, m_numBufferTargets> m_buffers{};
+  std::size_t m_activeTextureUnit{m_maxTextureUnits};
+  std::array<std::array<GLuint, m_numTextureTargets>, m_maxTextureUnits>
+      m_textures{};
+  std::array<GLuint, m_maxTextureUnits> m_samplers{};
+
+  // -1: unknown; 0: disabled; 1: enabled
+  std::array<std::int8_t, m_numCapabilities> m_capabilities{};
+
+  Stats m_stats;
+};
+
+/**
+ * @brief State cache of the current OpenGL context.
+ */
+inline GLStateCache glStateCache;
+#endif
+
 // OpenGL ES 2.0 function definitions
 
 inline void glActiveTexture(GLenum texture,
                             const sl& sourceLocation = sl::current()) {
+#if defined(ABCG_GL_STATE_CACHE)
+  if (!glStateCache.activeTexture(texture)) return;
+#endif
   callGL(sourceLocation, ::glActiveTexture, texture);
 }
 inline void glAttachShader(GLuint program, GLuint shader,
@@ -95,6 +193,9 @@ inline void glBindAttribLocation(GLuint program, GLuint index,
 }
 inline void glBindBuffer(GLenum target, GLuint buffer,
                          const sl& sourceLocation = sl::current()) {
+#if defined(ABCG_GL_STATE_CACHE)
+  if (!glStateCache.bindBuffer(target, buffer)) return;
+#endif
   callGL(sourceLocation, ::glBindBuffer, target, buffer);
 }
 inline void glBindFramebuffer(GLenum target, GLuint framebuffer,
@@ -107,6 +208,9 @@ inline void glBindRenderbuffer(GLenum target, GLuint renderbuffer,
 }
 inline void glBindTexture(GLenum target, GLuint texture,
                           const sl& sourceLocation = sl::current()) {
+#if defined(ABCG_GL_STATE_CACHE)
+  if (!glStateCache.bindTexture(target, texture)) return;
+#endif
   callGL(sourceLocation, ::glBindTexture, target, texture);
 }
 inline void glBlendColor(GLfloat red, GLfloat green, GLfloat blue,
@@ -211,6 +315,9 @@ inline void glCullFace(GLenum mode, const sl& sourceLocation = sl::current()) {
 inline void glDeleteBuffers(GLsizei n, const GLuint* buffers,
                             const sl& sourceLocation = sl::current()) {
   if (buffers == nullptr || *buffers == 0) return;
+#if defined(ABCG_GL_STATE_CACHE)
+  glStateCache.deleteBuffers(n, buffers);
+#endif
   callGL(sourceLocation, ::glDeleteBuffers, n, buffers);
 }
 inline void glDeleteFramebuffers(GLsizei n, const GLuint* framebuffers,
@@ -221,6 +328,9 @@ inline void glDeleteFramebuffers(GLsizei n, const GLuint* framebuffers,
 inline void glDeleteProgram(GLuint program,
                             const sl& sourceLocation = sl::current()) {
   if (program == 0) return;
+#if defined(ABCG_GL_STATE_CACHE)
+  glStateCache.deleteProgram(program);
+#endif
   callGL(sourceLocation, ::glDeleteProgram, program);
 }
 inline void glDeleteRenderbuffers(GLsizei n, GLuint* renderbuffers,
@@ -236,6 +346,9 @@ inline void glDeleteShader(GLuint shader,
 inline void glDeleteTextures(GLsizei n, const GLuint* textures,
                              const sl& sourceLocation = sl::current()) {
   if (textures == nullptr || *textures == 0) return;
+#if defined(ABCG_GL_STATE_CACHE)
+  glStateCache.deleteTextures(n, textures);
+#endif
   callGL(sourceLocation, ::glDeleteTextures, n, textures);
 }
 inline void glDepthFunc(GLenum func, const sl& sourceLocation = sl::current()) {
@@ -254,26 +367,44 @@ inline void glDetachShader(GLuint program, GLuint shader,
   callGL(sourceLocation, ::glDetachShader, program, shader);
 }
 inline void glDisable(GLenum cap, const sl& sourceLocation = sl::current()) {
+#if defined(ABCG_GL_STATE_CACHE)
+  if (!glStateCache.setCapability(cap, false)) return;
+#endif
   callGL(sourceLocation, ::glDisable, cap);
 }
 inline void glDisableVertexAttribArray(
     GLuint index, const sl& sourceLocation = sl::current()) {
+#if defined(ABCG_GL_STATE_CACHE)
+  glStateCache.flushVertexArray();
+#endif
   callGL(sourceLocation, ::glDisableVertexAttribArray, index);
 }
 inline void glDrawArrays(GLenum mode, GLint first, GLsizei count,
                          const sl& sourceLocation = sl::current()) {
+#if defined(ABCG_GL_STATE_CACHE)
+  glStateCache.flushVertexArray();
+#endif
   callGL(sourceLocation, ::glDrawArrays, mode, first, count);
 }
 inline void glDrawElements(GLenum mode, GLsizei count, GLenum type,
                            const void* indices,
                            const sl& sourceLocation = sl::current()) {
+#if defined(ABCG_GL_STATE_CACHE)
+  glStateCache.flushVertexArray();
+#endif
   callGL(sourceLocation, ::glDrawElements, mode, count, type, indices);
 }
 inline void glEnable(GLenum cap, const sl& sourceLocation = sl::current()) {
+#if defined(ABCG_GL_STATE_CACHE)
+  if (!glStateCache.setCapability(cap, true)) return;
+#endif
   callGL(sourceLocation, ::glEnable, cap);
 }
 inline void glEnableVertexAttribArray(
     GLuint index, const sl& sourceLocation = sl::current()) {
+#if defined(ABCG_GL_STATE_CACHE)
+  glStateCache.flushVertexArray();
+#endif
   callGL(sourceLocation, ::glEnableVertexAttribArray, index);
 }
 inline void glFinish(const sl& sourceLocation = sl::current()) {
@@ -661,6 +792,9 @@ inline void glUniformMatrix4fv(GLint location, GLsizei count,
 }
 inline void glUseProgram(GLuint program,
                          const sl& sourceLocation = sl::current()) {
+#if defined(ABCG_GL_STATE_CACHE)
+  if (!glStateCache.useProgram(program)) return;
+#endif
   callGL(sourceLocation, ::glUseProgram, program);
 }
 inline void glValidateProgram(GLuint program,
@@ -704,6 +838,9 @@ inline void glVertexAttribPointer(GLuint index, GLint size, GLenum type,
                                   GLboolean normalized, GLsizei stride,
                                   const void* pointer,
                                   const sl& sourceLocation = sl::current()) {
+#if defined(ABCG_GL_STATE_CACHE)
+  glStateCache.flushVertexArray();
+#endif
   callGL(sourceLocation, ::glVertexAttribPointer, index, size, type, normalized,
          stride, pointer);
 }
@@ -720,6 +857,9 @@ inline void glReadBuffer(GLenum src, const sl& sourceLocation = sl::current()) {
 inline void glDrawRangeElements(GLenum mode, GLuint start, GLuint end,
                                 GLsizei count, GLenum type, const void* indices,
                                 const sl& sourceLocation = sl::current()) {
+#if defined(ABCG_GL_STATE_CACHE)
+  glStateCache.flushVertexArray();
+#endif
   callGL(sourceLocation, ::glDrawRangeElements, mode, start, end, count, type,
          indices);
 }
@@ -871,10 +1011,16 @@ inline void glFlushMappedBufferRange(GLenum target, GLintptr offset,
 }
 inline void glBindVertexArray(GLuint array,
                               const sl& sourceLocation = sl::current()) {
+#if defined(ABCG_GL_STATE_CACHE)
+  if (!glStateCache.bindVertexArray(array)) return;
+#endif
   callGL(sourceLocation, ::glBindVertexArray, array);
 }
 inline void glDeleteVertexArrays(GLsizei n, const GLuint* arrays,
                                  const sl& sourceLocation = sl::current()) {
+#if defined(ABCG_GL_STATE_CACHE)
+  glStateCache.deleteVertexArrays(n, arrays);
+#endif
   callGL(sourceLocation, ::glDeleteVertexArrays, n, arrays);
 }
 inline void glGenVertexArrays(GLsizei n, GLuint* arrays,
@@ -899,11 +1045,17 @@ inline void glEndTransformFeedback(const sl& sourceLocation = sl::current()) {
 inline void glBindBufferRange(GLenum target, GLuint index, GLuint buffer,
                               GLintptr offset, GLsizeiptr size,
                               const sl& sourceLocation = sl::current()) {
+#if defined(ABCG_GL_STATE_CACHE)
+  glStateCache.setBuffer(target, buffer);
+#endif
   callGL(sourceLocation, ::glBindBufferRange, target, index, buffer, offset,
          size);
 }
 inline void glBindBufferBase(GLenum target, GLuint index, GLuint buffer,
                              const sl& sourceLocation = sl::current()) {
+#if defined(ABCG_GL_STATE_CACHE)
+  glStateCache.setBuffer(target, buffer);
+#endif
   callGL(sourceLocation, ::glBindBufferBase, target, index, buffer);
 }
 inline void glTransformFeedbackVaryings(
@@ -922,6 +1074,9 @@ inline void glGetTransformFeedbackVarying(
 inline void glVertexAttribIPointer(GLuint index, GLint size, GLenum type,
                                    GLsizei stride, const void* pointer,
                                    const sl& sourceLocation = sl::current()) {
+#if defined(ABCG_GL_STATE_CACHE)
+  glStateCache.flushVertexArray();
+#endif
   callGL(sourceLocation, ::glVertexAttribIPointer, index, size, type, stride,
          pointer);
 }
@@ -1062,12 +1217,18 @@ inline void glUniformBlockBinding(GLuint program, GLuint uniformBlockIndex,
 inline void glDrawArraysInstanced(GLenum mode, GLint first, GLsizei count,
                                   GLsizei instancecount,
                                   const sl& sourceLocation = sl::current()) {
+#if defined(ABCG_GL_STATE_CACHE)
+  glStateCache.flushVertexArray();
+#endif
   callGL(sourceLocation, ::glDrawArraysInstanced, mode, first, count,
          instancecount);
 }
 inline void glDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type,
                                     const void* indices, GLsizei instancecount,
                                     const sl& sourceLocation = sl::current()) {
+#if defined(ABCG_GL_STATE_CACHE)
+  glStateCache.flushVertexArray();
+#endif
   callGL(sourceLocation, ::glDrawElementsInstanced, mode, count, type, indices,
          instancecount);
 }
@@ -1115,6 +1276,9 @@ inline void glGenSamplers(GLsizei count, GLuint* samplers,
 }
 inline void glDeleteSamplers(GLsizei count, const GLuint* samplers,
                              const sl& sourceLocation = sl::current()) {
+#if defined(ABCG_GL_STATE_CACHE)
+  glStateCache.deleteSamplers(count, samplers);
+#endif
   callGL(sourceLocation, ::glDeleteSamplers, count, samplers);
 }
 inline GLboolean glIsSampler(GLuint sampler,
@@ -1123,6 +1287,9 @@ inline GLboolean glIsSampler(GLuint sampler,
 }
 inline void glBindSampler(GLuint unit, GLuint sampler,
                           const sl& sourceLocation = sl::current()) {
+#if defined(ABCG_GL_STATE_CACHE)
+  if (!glStateCache.bindSampler(unit, sampler)) return;
+#endif
   callGL(sourceLocation, ::glBindSampler, unit, sampler);
 }
 inline void glSamplerParameteri(GLuint sampler, GLenum pname, GLint param,
@@ -1154,6 +1321,9 @@ inline void glGetSamplerParameterfv(GLuint sampler, GLenum pname,
 }
 inline void glVertexAttribDivisor(GLuint index, GLuint divisor,
                                   const sl& sourceLocation = sl::current()) {
+#if defined(ABCG_GL_STATE_CACHE)
+  glStateCache.flushVertexArray();
+#endif
   callGL(sourceLocation, ::glVertexAttribDivisor, index, divisor);
 }
 inline void glBindTransformFeedback(GLenum target, GLuint id,
@@ -1227,6 +1397,85 @@ inline void glGetInternalformativ(GLenum target, GLenum internalformat,
          count, params);
 }
 
+#if !defined(__EMSCRIPTEN__)
+
+// OpenGL 3.2+ function definitions (not available in WebGL 2.0)
+
+inline void glDrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type,
+                                     const void* indices, GLint basevertex,
+                                     const sl& sourceLocation = sl::current()) {
+#if defined(ABCG_GL_STATE_CACHE)
+  glStateCache.flushVertexArray();
+#endif
+  callGL(sourceLocation, ::glDrawElementsBaseVertex, mode, count, type,
+         indices, basevertex);
+}
+inline void glDrawElementsInstancedBaseVertex(
+    GLenum mode, GLsizei count, GLenum type, const void* indices,
+    GLsizei instancecount, GLint basevertex,
+    const sl& sourceLocation = sl::current()) {
+#if defined(ABCG_GL_STATE_CACHE)
+  glStateCache.flushVertexArray();
+#endif
+  callGL(sourceLocation, ::glDrawElementsInstancedBaseVertex, mode, count,
+         type, indices, instancecount, basevertex);
+}
+
+// OpenGL 4.3+ function definitions (not available in WebGL 2.0)
+
+inline void glBindVertexBuffer(GLuint bindingindex, GLuint buffer,
+                               GLintptr offset, GLsizei stride,
+                               const sl& sourceLocation = sl::current()) {
+#if defined(ABCG_GL_STATE_CACHE)
+  glStateCache.flushVertexArray();
+#endif
+  callGL(sourceLocation, ::glBindVertexBuffer, bindingindex, buffer, offset,
+         stride);
+}
+inline void glVertexAttribFormat(GLuint attribindex, GLint size, GLenum type,
+                                 GLboolean normalized, GLuint relativeoffset,
+                                 const sl& sourceLocation = sl::current()) {
+#if defined(ABCG_GL_STATE_CACHE)
+  glStateCache.flushVertexArray();
+#endif
+  callGL(sourceLocation, ::glVertexAttribFormat, attribindex, size, type,
+         normalized, relativeoffset);
+}
+inline void glVertexAttribBinding(GLuint attribindex, GLuint bindingindex,
+                                  const sl& sourceLocation = sl::current()) {
+#if defined(ABCG_GL_STATE_CACHE)
+  glStateCache.flushVertexArray();
+#endif
+  callGL(sourceLocation, ::glVertexAttribBinding, attribindex, bindingindex);
+}
+inline void glVertexBindingDivisor(GLuint bindingindex, GLuint divisor,
+                                   const sl& sourceLocation = sl::current()) {
+#if defined(ABCG_GL_STATE_CACHE)
+  glStateCache.flushVertexArray();
+#endif
+  callGL(sourceLocation, ::glVertexBindingDivisor, bindingindex, divisor);
+}
+
+inline void glMultiDrawElementsIndirect(
+    GLenum mode, GLenum type, const void* indirect, GLsizei drawcount,
+    GLsizei stride, const sl& sourceLocation = sl::current()) {
+#if defined(ABCG_GL_STATE_CACHE)
+  glStateCache.flushVertexArray();
+#endif
+  callGL(sourceLocation, ::glMultiDrawElementsIndirect, mode, type, indirect,
+         drawcount, stride);
+}
+
+// OpenGL 4.4+ function definitions (not available in WebGL 2.0)
+
+inline void glBufferStorage(GLenum target, GLsizeiptr size, const void* data,
+                            GLbitfield flags,
+                            const sl& sourceLocation = sl::current()) {
+  callGL(sourceLocation, ::glBufferStorage, target, size, data, flags);
+}
+
+#endif
+
 #if !defined(NDEBUG) && !defined(__EMSCRIPTEN__) && !defined(__APPLE__)
 
 // OpenGL 3.0+ function definitions
@@ -13,15 +13,22 @@
 #include <imgui_impl_sdl.h>
 
 #include <algorithm>
+#include <cmath>
+#include <cppitertools/itertools.hpp>
 #include <fstream>
+#include <chrono>
 #include <regex>
 #include <sstream>
 #include <string_view>
 
 #include "SDL_events.h"
+#include "SDL_image.h"
 #include "SDL_video.h"
 #include "abcg_application.hpp"
 #include "abcg_embeddedfonts.hpp"
+#include "abcg_gputimer.hpp"
+#include "abcg_jobsystem.hpp"
+#include "abcg_profiler.hpp"
 #include "abcg_string.hpp"
 
 void printShaderInfoLog(GLuint shader, std::string_view prefix) {
@@ -165,6 +172,13 @@ abcg::OpenGLWindow::~OpenGLWindow() {
   if (m_window != nullptr) {
     if (ImGui::GetCurrentContext() != nullptr) {
       terminateGL();
+#if defined(ABCG_PROFILE)
+      GPUTimer::getInstance().terminateGL();
+#endif
+      m_sceneFramebuffer.terminateGL();
+      m_headlessFramebuffer.terminateGL();
+      glDeleteProgram(m_upscaleProgram);
+      glDeleteVertexArrays(1, &m_upscaleVAO);
       ImGui_ImplOpenGL3_Shutdown();
       ImGui_ImplSDL2_Shutdown();
       ImGui::DestroyContext();
@@ -239,6 +253,10 @@ void abcg::OpenGLWindow::paintUI() {
     ImGui::End();
   }
 
+#if defined(ABCG_PROFILE)
+  Profiler::getInstance().paintUI();
+#endif
+
   // Fullscreen button
   if (m_windowSettings.showFullscreenButton) {
 #if defined(__EMSCRIPTEN__)
@@ -281,6 +299,20 @@ void abcg::OpenGLWindow::resizeGL(int width, int height) {
 
 void abcg::OpenGLWindow::terminateGL() {}
 
+/**
+ * @brief Advances the state of the application.
+ *
+ * Called before paintUI() and paintGL() of each frame. With a fixed time step
+ * (see abcg::OpenGLSettings), it is called zero or more times per frame,
+ * always with the same step, so that the simulation does not depend on the
+ * frame rate. paintGL() should then draw the state interpolated between the
+ * last two steps with getInterpolationAlpha(). With a threaded update, it is
+ * instead called on a thread of its own, once per step.
+ *
+ * @param deltaTime Time step, in seconds.
+ */
+void abcg::OpenGLWindow::update([[maybe_unused]] double deltaTime) {}
+
 GLuint abcg::OpenGLWindow::createProgramFromFile(
     std::string_view pathToVertexShader,
     std::string_view pathToFragmentShader) {
@@ -401,6 +433,91 @@ double abcg::OpenGLWindow::getElapsedTime() const {
   return m_windowStartTime.elapsed();
 }
 
+/**
+ * @brief Returns how far the current frame is between the last two calls to
+ * update().
+ *
+ * With a fixed time step, this is the fraction of a step of elapsed time not
+ * yet simulated, so that drawing `mix(previous, current, alpha)` of each
+ * simulated value moves smoothly at any frame rate. With a threaded update,
+ * this is the time since the last step ended, as a fraction of a step and
+ * clamped to 1. Without a fixed time step, and in headless mode, this is
+ * always 1.
+ *
+ * @return Interpolation factor in the range [0, 1].
+ */
+double abcg::OpenGLWindow::getInterpolationAlpha() const noexcept {
+  return m_interpolationAlpha;
+}
+
+/**
+ * @brief Returns the seed for the random number generators of the
+ * application.
+ *
+ * When replaying an input log, this is the seed of the recorded session, so
+ * that the replay draws the same numbers. In headless mode it is always 0,
+ * so that benchmarks are repeatable, and otherwise it changes with each run.
+ *
+ * @return Seed.
+ */
+std::uint64_t abcg::OpenGLWindow::getRandomSeed() const noexcept {
+  return m_randomSeed;
+}
+
+/**
+ * @brief Returns the width of the framebuffer paintGL() draws to.
+ *
+ * @return Width of the viewport scaled by the current resolution scale, or of
+ * the window if dynamic resolution is disabled.
+ */
+int abcg::OpenGLWindow::getRenderWidth() const noexcept {
+  return m_renderWidth;
+}
+
+/**
+ * @brief Returns the height of the framebuffer paintGL() draws to.
+ *
+ * @return Height of the viewport scaled by the current resolution scale, or
+ * of the window if dynamic resolution is disabled.
+ */
+int abcg::OpenGLWindow::getRenderHeight() const noexcept {
+  return m_renderHeight;
+}
+
+/**
+ * @brief Returns the current resolution scale.
+ *
+ * @return Ratio between the render size and the window size.
+ */
+float abcg::OpenGLWindow::getResolutionScale() const noexcept {
+  return m_resolutionScale;
+}
+
+/**
+ * @brief Sets whether anything is animating.
+ *
+ * While idle, the main loop blocks until an event arrives or the timeout
+ * expires, and only then draws a frame, instead of drawing frames
+ * continuously. Set it when nothing on screen changes by itself, such as on
+ * a pause menu, and clear it when animation resumes. It has no effect in
+ * WebAssembly nor in headless mode.
+ *
+ * @param idle Whether the window is idle.
+ * @param timeout Maximum time between frames while idle, in seconds, so that
+ * timers still advance.
+ */
+void abcg::OpenGLWindow::setIdle(bool idle, double timeout) noexcept {
+  m_idle = idle;
+  m_idleTimeout = timeout;
+}
+
+/**
+ * @brief Returns whether the window is idle.
+ *
+ * @return Whether the main loop waits for events before drawing a frame.
+ */
+bool abcg::OpenGLWindow::isIdle() const noexcept { return m_idle; }
+
 void abcg::OpenGLWindow::toggleFullscreen() {
 #if defined(__EMSCRIPTEN__)
   EM_ASM(toggleFullscreen(););
@@ -499,6 +616,12 @@ void abcg::OpenGLWindow::handleEvent(SDL_Event &event, bool &done) {
     useCustomEventHandler = false;
   }
 
+  if (useCustomEventHandler && InputLog::isInput(event)) {
+    // Replayed input replaces the live input
+    if (m_inputLog.isReplaying()) return;
+    m_inputLog.write(m_numSteps.load(std::memory_order_relaxed), event);
+  }
+
   if (useCustomEventHandler) handleEvent(event);
 }
 
@@ -574,7 +697,8 @@ void abcg::OpenGLWindow::initialize(std::string_view basePath) {
 
   SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, m_openGLSettings.depthBufferSize);
   SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, m_openGLSettings.stencilSize);
-  if (m_openGLSettings.samples > 0) {
+  // In headless mode, multisampling is done by the headless framebuffer
+  if (m_openGLSettings.samples > 0 && m_headlessFrames == 0) {
     // Enable multisample
     SDL_GL_SetAttribute(SDL_GL_MULTISAMPLEBUFFERS, 1);
     // Can be 2, 4, 8 or 16
@@ -584,12 +708,15 @@ void abcg::OpenGLWindow::initialize(std::string_view basePath) {
   }
 
   // Create window with graphics context
+  Uint32 windowFlags{SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE};
+  if (m_headlessFrames > 0) windowFlags |= SDL_WINDOW_HIDDEN;
   while (true) {
     m_window = SDL_CreateWindow(m_windowSettings.title.c_str(),
                                 SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
                                 m_windowSettings.width, m_windowSettings.height,
-                                SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE);
-    if (m_window == nullptr && m_openGLSettings.samples > 0) {
+                                windowFlags);
+    if (m_window == nullptr && m_openGLSettings.samples > 0 &&
+        m_headlessFrames == 0) {
       // Try again, but this time with multisampling disabled
       m_openGLSettings.samples = 0;
       SDL_GL_SetAttribute(SDL_GL_MULTISAMPLESAMPLES, 0);
@@ -618,11 +745,19 @@ void abcg::OpenGLWindow::initialize(std::string_view basePath) {
   }
 
 #if !defined(__EMSCRIPTEN__)
-  SDL_GL_SetSwapInterval(m_openGLSettings.vsync ? 1 : 0);  // Disable vsync
+  // Disable vsync
+  SDL_GL_SetSwapInterval(m_openGLSettings.vsync && m_headlessFrames == 0 ? 1
+                                                                         : 0);
 #endif
 
 #if !defined(__EMSCRIPTEN__)
-  if (GLenum err{glewInit()}; GLEW_OK != err) {
+  GLenum err{glewInit()};
+#if defined(GLEW_ERROR_NO_GLX_DISPLAY)
+  // A GLX build of GLEW fails to load GLX extensions with an EGL context, as
+  // created by the offscreen video driver, but the core functions are loaded
+  if (err == GLEW_ERROR_NO_GLX_DISPLAY) err = GLEW_OK;
+#endif
+  if (GLEW_OK != err) {
     std::string header{"Failed to initialize OpenGL loader: "};
     const auto *const message{
         reinterpret_cast<const char *>(glewGetErrorString(err))};
@@ -679,9 +814,27 @@ void abcg::OpenGLWindow::initialize(std::string_view basePath) {
   } else {
     resizeGL(m_windowSettings.width, m_windowSettings.height);
   }
+
+  // Do not count the initialization as a frame
+  m_headlessTime.restart();
+  m_updateTime.restart();
+  m_updateAccumulator = 0.0;
+#if !defined(__EMSCRIPTEN__)
+  // Recordings and replays run the steps on this thread, which handles the
+  // input. An event is then always handled between the same two steps,
+  // whereas the update thread could be in the middle of a step when it is
+  // stamped.
+  if (m_openGLSettings.threadedUpdate && m_openGLSettings.fixedTimeStep > 0.0 &&
+      m_headlessFrames == 0 && !m_inputLog.isRecording() &&
+      !m_inputLog.isReplaying()) {
+    startUpdates();
+  }
+#endif
 }
 
 void abcg::OpenGLWindow::paint() {
+  ABCG_PROFILE_FRAME();
+  m_frameTime.restart();
   SDL_GL_MakeCurrent(m_window, m_GLContext);
 
 #if defined(__EMSCRIPTEN__)
@@ -694,23 +847,354 @@ void abcg::OpenGLWindow::paint() {
   }
 #endif
 
-  ImGui_ImplOpenGL3_NewFrame();
-  ImGui_ImplSDL2_NewFrame();
-  ImGui::NewFrame();
-  paintUI();
-  ImGui::Render();
-  paintGL();
-  ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+  // Jobs that need the OpenGL context
+  {
+    ABCG_PROFILE_SCOPE("Main thread jobs");
+    JobSystem::getInstance().runMainThreadJobs();
+  }
 
-  if (m_openGLSettings.preserveWebGLDrawingBuffer) {
+  runUpdates();
+
+  {
+    ABCG_PROFILE_SCOPE("paintUI");
+    ImGui_ImplOpenGL3_NewFrame();
+    ImGui_ImplSDL2_NewFrame();
+    ImGui::NewFrame();
+    paintUI();
+    ImGui::Render();
+  }
+  if (m_headlessFrames > 0) beginHeadlessFrame();
+#if defined(ABCG_PROFILE)
+  GPUTimer::getInstance().beginFrame();
+#endif
+  if (m_openGLSettings.dynamicResolution && m_viewportWidth > 0 &&
+      m_viewportHeight > 0) {
+    // Frames drawn while idle are not representative
+    if (!m_idle) updateResolutionScale(m_lastFrameTime);
+    beginScaledFrame();
+    {
+      ABCG_PROFILE_SCOPE("paintGL");
+      ABCG_GPU_SCOPE("paintGL");
+      paintGL();
+    }
+    endScaledFrame();
+  } else {
+    m_averageFrameTime = 0.0;
+    m_resolutionScale = 1.0f;
+    m_renderWidth = m_viewportWidth;
+    m_renderHeight = m_viewportHeight;
+    ABCG_PROFILE_SCOPE("paintGL");
+    ABCG_GPU_SCOPE("paintGL");
+    paintGL();
+  }
+  {
+    ABCG_PROFILE_SCOPE("ImGui rendering");
+    ABCG_GPU_SCOPE("ImGui rendering");
+    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+  }
+#if defined(ABCG_PROFILE)
+  GPUTimer::getInstance().endFrame();
+#endif
+#if defined(ABCG_GL_STATE_CACHE)
+  // The ImGui backend calls OpenGL directly
+  glStateCache.invalidate();
+#endif
+
+  if (m_headlessFrames > 0) {
+    endHeadlessFrame();
+  } else if (m_openGLSettings.preserveWebGLDrawingBuffer) {
     glFinish();
   } else {
+    ABCG_PROFILE_SCOPE("Swap");
     SDL_GL_SwapWindow(m_window);
   }
+  m_lastFrameTime = m_frameTime.elapsed();
 
   // Cap to 480 Hz
   if (m_deltaTime.elapsed() >= 1.0 / 480.0) {
     m_lastDeltaTime = m_deltaTime.restart();
   } else
     m_lastDeltaTime = 0.0;
-}
\ No newline at end of file
+}
+
+// Calls update() for the time elapsed since the last frame, in fixed steps
+// if enabled
+void abcg::OpenGLWindow::runUpdates() {
+  const auto elapsed{m_updateTime.restart()};
+  const auto step{m_openGLSettings.fixedTimeStep};
+
+  if (m_updateThread.joinable()) {
+    if (m_updateFailed.load(std::memory_order_acquire)) {
+      stopUpdates();
+      std::rethrow_exception(m_updateException);
+    }
+    const auto sinceUpdate{getElapsedTime() -
+                           m_lastUpdateTime.load(std::memory_order_acquire)};
+    m_interpolationAlpha = std::clamp(sinceUpdate / step, 0.0, 1.0);
+    return;
+  }
+
+  if (step <= 0.0) {
+    m_interpolationAlpha = 1.0;
+    runStep(elapsed);
+    return;
+  }
+
+  // A headless run advances exactly one step per frame, so that it simulates
+  // the same thing however long its frames take
+  if (m_headlessFrames > 0) {
+    m_interpolationAlpha = 1.0;
+    runStep(step);
+    return;
+  }
+
+  m_updateAccumulator += elapsed;
+  const auto maxSteps{std::max(m_openGLSettings.maxFixedSteps, 1)};
+  for (auto steps{0}; m_updateAccumulator >= step && steps < maxSteps;
+       ++steps) {
+    runStep(step);
+    m_updateAccumulator -= step;
+  }
+
+  // After a long hitch, drop the time that could not be simulated instead of
+  // falling further behind
+  m_updateAccumulator = std::fmod(m_updateAccumulator, step);
+  m_interpolationAlpha = m_updateAccumulator / step;
+}
+
+// Calls update() for the next step, after handing the application the
+// replayed input received before that step
+void abcg::OpenGLWindow::runStep(double deltaTime) {
+  // Replays never run on the update thread
+  if (m_inputLog.isReplaying()) {
+    SDL_Event event{};
+    while (
+        m_inputLog.read(m_numSteps.load(std::memory_order_relaxed), event)) {
+      event.window.windowID = m_windowID;
+      handleEvent(event);
+    }
+  }
+
+  ABCG_PROFILE_SCOPE("update");
+  update(deltaTime);
+  m_numSteps.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Starts the thread that calls update() once per fixed step. The settings are
+// copied, as the window may change them meanwhile.
+void abcg::OpenGLWindow::startUpdates() {
+  using Clock = std::chrono::steady_clock;
+  const auto step{m_openGLSettings.fixedTimeStep};
+  const auto period{std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(step))};
+  const auto maxLag{period * std::max(m_openGLSettings.maxFixedSteps, 1)};
+
+  m_stopUpdates.store(false);
+  m_updateFailed.store(false);
+  m_lastUpdateTime.store(getElapsedTime());
+  m_updateThread = std::thread{[this, step, period, maxLag] {
+    ABCG_PROFILE_THREAD("Update");
+    try {
+      auto nextStep{Clock::now()};
+      while (!m_stopUpdates.load(std::memory_order_relaxed)) {
+        runStep(step);
+        m_lastUpdateTime.store(getElapsedTime(), std::memory_order_release);
+
+        // After a long hitch, drop the steps that could not be simulated
+        // instead of running them back to back
+        nextStep += period;
+        if (const auto now{Clock::now()}; now - nextStep > maxLag) {
+          nextStep = now;
+        }
+        std::this_thread::sleep_until(nextStep);
+      }
+    } catch (...) {
+      m_updateException = std::current_exception();
+      m_updateFailed.store(true, std::memory_order_release);
+    }
+  }};
+}
+
+// Stops the update thread, if running, and waits for the step in progress
+void abcg::OpenGLWindow::stopUpdates() {
+  if (!m_updateThread.joinable()) return;
+  m_stopUpdates.store(true, std::memory_order_relaxed);
+  m_updateThread.join();
+}
+
+// Moves the resolution scale towards the one expected to meet the target
+// frame time, assuming the cost of a frame is proportional to its pixels. If
+// the frame rate limit waited after the last frame, the frame already fit in
+// its period, so the scale may only rise.
+void abcg::OpenGLWindow::updateResolutionScale(double frameTime) {
+  const auto maxScale{std::max(m_openGLSettings.maxResolutionScale, 0.1f)};
+  const auto minScale{
+      std::clamp(m_openGLSettings.minResolutionScale, 0.1f, maxScale)};
+
+  // Smooth out spikes
+  m_averageFrameTime = m_averageFrameTime > 0.0
+                           ? std::lerp(m_averageFrameTime, frameTime, 0.1)
+                           : frameTime;
+  if (m_averageFrameTime <= 0.0) return;
+
+  auto idealScale{
+      static_cast<double>(m_resolutionScale) *
+      std::sqrt(m_openGLSettings.targetFrameTime / m_averageFrameTime)};
+  if (m_frameRateLimited) {
+    idealScale = std::max(idealScale, static_cast<double>(m_resolutionScale));
+  }
+  m_resolutionScale = std::clamp(
+      std::lerp(m_resolutionScale, static_cast<float>(idealScale), 0.1f),
+      minScale, maxScale);
+}
+
+// Binds the offscreen framebuffer and sets the viewport to the render size
+void abcg::OpenGLWindow::beginScaledFrame() {
+  const auto maxScale{std::max(m_openGLSettings.maxResolutionScale, 0.1f)};
+  const auto width{static_cast<int>(
+      std::ceil(static_cast<float>(m_viewportWidth) * maxScale))};
+  const auto height{static_cast<int>(
+      std::ceil(static_cast<float>(m_viewportHeight) * maxScale))};
+  if (width != m_sceneFramebuffer.getWidth() ||
+      height != m_sceneFramebuffer.getHeight() ||
+      m_openGLSettings.samples != m_sceneFramebuffer.getSamples()) {
+    m_sceneFramebuffer.initializeGL(width, height, m_openGLSettings.samples);
+  }
+
+  if (m_upscaleProgram == 0) {
+    // Fullscreen triangle generated from the vertex index
+    m_upscaleProgram = createProgramFromString(
+        R"(out vec2 fragTexCoord;
+           uniform vec2 texCoordScale;
+           void main() {
+             vec2 position = vec2(gl_VertexID == 1 ? 3.0 : -1.0,
+                                  gl_VertexID == 2 ? 3.0 : -1.0);
+             fragTexCoord = (position * 0.5 + 0.5) * texCoordScale;
+             gl_Position = vec4(position, 0.0, 1.0);
+           })",
+        R"(in vec2 fragTexCoord;
+           out vec4 outColor;
+           uniform sampler2D colorTexture;
+           uniform vec2 texCoordMax;
+           void main() {
+             vec2 texCoord = min(fragTexCoord, texCoordMax);
+             outColor = vec4(texture(colorTexture, texCoord).rgb, 1.0);
+           })");
+    glGenVertexArrays(1, &m_upscaleVAO);
+  }
+
+  m_renderWidth = std::clamp(
+      static_cast<int>(std::lround(static_cast<float>(m_viewportWidth) *
+                                   m_resolutionScale)),
+      1, width);
+  m_renderHeight = std::clamp(
+      static_cast<int>(std::lround(static_cast<float>(m_viewportHeight) *
+                                   m_resolutionScale)),
+      1, height);
+
+  m_sceneFramebuffer.bind();
+  glViewport(0, 0, m_renderWidth, m_renderHeight);
+}
+
+// Resolves the scene if multisampled and stretches it to the window, or to the
+// headless framebuffer, with bilinear filtering. The program, VAO and texture
+// of unit 0 are reset to zero.
+void abcg::OpenGLWindow::endScaledFrame() {
+  m_sceneFramebuffer.resolve(m_renderWidth, m_renderHeight);
+  glBindFramebuffer(GL_FRAMEBUFFER, m_headlessFramebuffer.getFBO());
+  glViewport(0, 0, m_viewportWidth, m_viewportHeight);
+
+  const auto depthTest{glIsEnabled(GL_DEPTH_TEST) == GL_TRUE};
+  const auto cullFace{glIsEnabled(GL_CULL_FACE) == GL_TRUE};
+  const auto blend{glIsEnabled(GL_BLEND) == GL_TRUE};
+  glDisable(GL_DEPTH_TEST);
+  glDisable(GL_CULL_FACE);
+  glDisable(GL_BLEND);
+
+  // Texture coordinates of the rendered region, clamped to the centers of
+  // its border texels so that the rest of the texture is never sampled
+  const auto scaledWidth{static_cast<float>(m_sceneFramebuffer.getWidth())};
+  const auto scaledHeight{static_cast<float>(m_sceneFramebuffer.getHeight())};
+  const auto renderWidth{static_cast<float>(m_renderWidth)};
+  const auto renderHeight{static_cast<float>(m_renderHeight)};
+
+  glUseProgram(m_upscaleProgram);
+  glUniform2f(glGetUniformLocation(m_upscaleProgram, "texCoordScale"),
+              renderWidth / scaledWidth, renderHeight / scaledHeight);
+  glUniform2f(glGetUniformLocation(m_upscaleProgram, "texCoordMax"),
+              (renderWidth - 0.5f) / scaledWidth,
+              (renderHeight - 0.5f) / scaledHeight);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, m_sceneFramebuffer.getTexture());
+  glBindVertexArray(m_upscaleVAO);
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+  glBindVertexArray(0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glUseProgram(0);
+
+  if (depthTest) glEnable(GL_DEPTH_TEST);
+  if (cullFace) glEnable(GL_CULL_FACE);
+  if (blend) glEnable(GL_BLEND);
+}
+
+// Binds the headless framebuffer, recreated if the window was resized
+void abcg::OpenGLWindow::beginHeadlessFrame() {
+  const auto width{std::max(m_viewportWidth, 1)};
+  const auto height{std::max(m_viewportHeight, 1)};
+  if (width != m_headlessFramebuffer.getWidth() ||
+      height != m_headlessFramebuffer.getHeight()) {
+    m_headlessFramebuffer.initializeGL(width, height,
+                                       m_openGLSettings.samples);
+  }
+  m_headlessFramebuffer.bind();
+}
+
+// Counts the frame and, after the last one, prints the average frame time
+// and saves the screenshot, if any
+void abcg::OpenGLWindow::endHeadlessFrame() {
+  if (++m_headlessFrame < m_headlessFrames) return;
+
+  glFinish();
+  const auto elapsed{m_headlessTime.elapsed()};
+  const auto frames{static_cast<double>(m_headlessFrames)};
+  fmt::print(
+      "Rendered {} frames in {:.3f} s: {:.3f} ms per frame, {:.1f} FPS\n",
+      m_headlessFrames, elapsed, elapsed / frames * 1000.0, frames / elapsed);
+
+  if (!m_screenshotPath.empty()) saveScreenshot(m_screenshotPath);
+  m_headlessDone = true;
+}
+
+// Saves the color of the headless framebuffer to a PNG file
+void abcg::OpenGLWindow::saveScreenshot(
+    [[maybe_unused]] std::string_view path) {
+#if !defined(__EMSCRIPTEN__)
+  m_headlessFramebuffer.resolve();
+  const auto pixels{m_headlessFramebuffer.readPixels()};
+
+  // OpenGL stores the rows from the bottom to the top
+  const auto width{m_headlessFramebuffer.getWidth()};
+  const auto height{m_headlessFramebuffer.getHeight()};
+  const auto pitch{static_cast<std::size_t>(width) * 4};
+  std::vector<std::uint8_t> image(pixels.size());
+  for (auto row : iter::range(static_cast<std::size_t>(height))) {
+    std::copy_n(pixels.begin() + static_cast<std::ptrdiff_t>(row * pitch),
+                pitch,
+                image.end() - static_cast<std::ptrdiff_t>((row + 1) * pitch));
+  }
+
+  auto *surface{SDL_CreateRGBSurfaceWithFormatFrom(
+      image.data(), width, height, 32, static_cast<int>(pitch),
+      SDL_PIXELFORMAT_RGBA32)};
+  if (surface == nullptr) {
+    throw abcg::Exception{
+        abcg::Exception::SDL("SDL_CreateRGBSurfaceWithFormatFrom failed")};
+  }
+  const auto saved{IMG_SavePNG(surface, std::string{path}.c_str()) == 0};
+  SDL_FreeSurface(surface);
+  if (!saved) {
+    throw abcg::Exception{abcg::Exception::SDLImage("IMG_SavePNG failed")};
+  }
+  fmt::print("Saved {}\n", path);
+#endif
+}
@@ -10,9 +10,15 @@
 #ifndef ABCG_OPENGLWINDOW_HPP_
 #define ABCG_OPENGLWINDOW_HPP_
 
+#include <atomic>
+#include <cstdint>
+#include <exception>
 #include <string>
+#include <thread>
 
 #include "abcg_elapsedtimer.hpp"
+#include "abcg_framebuffer.hpp"
+#include "abcg_inputlog.hpp"
 #include "abcg_openglfunctions.hpp"
 
 namespace abcg {
@@ -34,6 +40,37 @@ EM_BOOL fullscreenchangeCallback(int eventType,
  */
 enum class abcg::OpenGLProfile { Core, Compatibility, ES };
 
+/**
+ * @brief OpenGL settings of the window.
+ *
+ * With `dynamicResolution` set, the scene drawn by paintGL() is rendered to
+ * an offscreen framebuffer and upscaled to the window before the UI is drawn.
+ * The resolution scale is adjusted every frame between `minResolutionScale`
+ * and `maxResolutionScale` so that the frame time approaches
+ * `targetFrameTime`, in seconds. The frame time is measured from the start of
+ * a frame until its buffers are swapped, so it excludes the waits of the
+ * frame rate limit and of the idle mode, but includes waiting for vsync: the
+ * target should then be above the refresh period. The scale is kept while
+ * idle, and is not lowered after a frame that the frame rate limit had to
+ * wait for.
+ *
+ * With `fixedTimeStep` above zero, in seconds, update() is called with that
+ * step as many times as needed to keep up with the elapsed time, and at most
+ * `maxFixedSteps` times per frame. Otherwise, update() is called once per
+ * frame with the time elapsed since the previous frame.
+ *
+ * With `maxFrameRate` above zero, in frames per second, the main loop waits
+ * after each frame so that frames start no more often than that. This limits
+ * CPU and power use when vsync is off. It has no effect in WebAssembly, where
+ * the browser paces the frames, nor in headless mode.
+ *
+ * With `threadedUpdate` also set, the fixed-step update() runs on a thread of
+ * its own, at its own rate, instead of on the thread that draws. update() and
+ * paintGL() then run at the same time, so they must only share data through
+ * thread-safe means, such as the snapshots of an abcg::TripleBuffer. The
+ * setting is ignored without a fixed time step, in WebAssembly, in headless
+ * mode, and while recording or replaying input (see abcg::Application).
+ */
 struct alignas(32) abcg::OpenGLSettings {
   OpenGLProfile profile{OpenGLProfile::Core};
   int majorVersion{4};
@@ -43,6 +80,14 @@ struct alignas(32) abcg::OpenGLSettings {
   int samples{0};
   bool vsync{false};
   bool preserveWebGLDrawingBuffer{false};
+  bool dynamicResolution{false};
+  float minResolutionScale{0.5f};
+  float maxResolutionScale{1.0f};
+  double targetFrameTime{1.0 / 60.0};
+  double fixedTimeStep{0.0};
+  int maxFixedSteps{8};
+  double maxFrameRate{0.0};
+  bool threadedUpdate{false};
 };
 
 struct alignas(64) abcg::WindowSettings {
@@ -62,10 +107,10 @@ class abcg::OpenGLWindow {
   OpenGLWindow() = default;
   virtual ~OpenGLWindow();
 
-  OpenGLWindow(const OpenGLWindow&) = default;
-  OpenGLWindow(OpenGLWindow&&) = default;
-  OpenGLWindow& operator=(const OpenGLWindow&) = default;
-  OpenGLWindow& operator=(OpenGLWindow&&) = default;
+  OpenGLWindow(const OpenGLWindow&) = delete;
+  OpenGLWindow(OpenGLWindow&&) = delete;
+  OpenGLWindow& operator=(const OpenGLWindow&) = delete;
+  OpenGLWindow& operator=(OpenGLWindow&&) = delete;
 
   [[nodiscard]] OpenGLSettings getOpenGLSettings() noexcept;
   [[nodiscard]] WindowSettings getWindowSettings() noexcept;
@@ -79,6 +124,7 @@ class abcg::OpenGLWindow {
   virtual void paintUI();
   virtual void resizeGL(int width, int height);
   virtual void terminateGL();
+  virtual void update(double deltaTime);
 
   [[nodiscard]] GLuint createProgramFromFile(
       std::string_view pathToVertexShader,
@@ -89,12 +135,31 @@ class abcg::OpenGLWindow {
   std::string getAssetsPath();
   [[nodiscard]] double getDeltaTime() const;
   [[nodiscard]] double getElapsedTime() const;
+  [[nodiscard]] double getInterpolationAlpha() const noexcept;
+  [[nodiscard]] std::uint64_t getRandomSeed() const noexcept;
+  [[nodiscard]] int getRenderWidth() const noexcept;
+  [[nodiscard]] int getRenderHeight() const noexcept;
+  [[nodiscard]] float getResolutionScale() const noexcept;
+  void setIdle(bool idle, double timeout = 0.25) noexcept;
+  [[nodiscard]] bool isIdle() const noexcept;
   void toggleFullscreen();
 
  private:
   void handleEvent(SDL_Event& event, bool& done);
   void initialize(std::string_view basePath);
   void paint();
+  void runUpdates();
+  void runStep(double deltaTime);
+  void startUpdates();
+  void stopUpdates();
+
+  void updateResolutionScale(double frameTime);
+  void beginScaledFrame();
+  void endScaledFrame();
+
+  void beginHeadlessFrame();
+  void endHeadlessFrame();
+  void saveScreenshot(std::string_view path);
 
   WindowSettings m_windowSettings{};
   OpenGLSettings m_openGLSettings{};
@@ -113,6 +178,55 @@ class abcg::OpenGLWindow {
   ElapsedTimer m_windowStartTime;
   double m_lastDeltaTime{0.0};
 
+  // Fixed-step simulation
+  ElapsedTimer m_updateTime;
+  double m_updateAccumulator{};
+  double m_interpolationAlpha{1.0};
+
+  // Update thread, with threadedUpdate. An exception thrown by update() is
+  // rethrown on the thread that draws.
+  std::thread m_updateThread;
+  std::atomic<bool> m_stopUpdates{};
+  std::atomic<bool> m_updateFailed{};
+  std::exception_ptr m_updateException;
+  std::atomic<double> m_lastUpdateTime{};
+
+  // Input recording and replay, set up by abcg::Application. Events are
+  // stamped with the number of update steps run so far.
+  InputLog m_inputLog;
+  std::uint64_t m_randomSeed{};
+  std::atomic<std::uint64_t> m_numSteps{};
+
+  // While idle, the main loop waits for events for up to the timeout, in
+  // seconds, before drawing the next frame
+  bool m_idle{};
+  double m_idleTimeout{0.25};
+
+  // Dynamic resolution scaling
+  ElapsedTimer m_frameTime;
+  double m_lastFrameTime{};
+  double m_averageFrameTime{};
+  // Whether the frame rate limit waited after the last frame, set by
+  // abcg::Application
+  bool m_frameRateLimited{};
+  float m_resolutionScale{1.0f};
+  int m_renderWidth{};
+  int m_renderHeight{};
+
+  // Offscreen framebuffer, sized for the maximum scale
+  Framebuffer m_sceneFramebuffer;
+  GLuint m_upscaleProgram{};
+  GLuint m_upscaleVAO{};
+
+  // Headless mode, set up by abcg::Application. The framebuffer stands in for
+  // the window, and has FBO 0 when not headless.
+  int m_headlessFrames{};
+  int m_headlessFrame{};
+  std::string m_screenshotPath;
+  bool m_headlessDone{};
+  ElapsedTimer m_headlessTime;
+  Framebuffer m_headlessFramebuffer;
+
   friend Application;
 
 #if defined(__EMSCRIPTEN__)
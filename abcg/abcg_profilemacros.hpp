@@ -0,0 +1,16 @@
+/**
+ * @file abcg_profilemacros.hpp
+ * @brief Helper macros shared by the profiling macros.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_PROFILEMACROS_HPP_
+#define ABCG_PROFILEMACROS_HPP_
+
+// Pastes two tokens after expanding them, so that the scope objects created
+// by the profiling macros get a name unique to their line
+#define ABCG_PROFILE_CONCAT_(a, b) a##b
+#define ABCG_PROFILE_CONCAT(a, b) ABCG_PROFILE_CONCAT_(a, b)
+
+#endif
@@ -0,0 +1,335 @@
+/**
+ * @file abcg_profiler.cpp
+ * @brief Definition of abcg::Profiler and abcg::ProfileScope class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#if defined(ABCG_PROFILE)
+#include "abcg_profiler.hpp"
+
+#include <fmt/core.h>
+#include <imgui.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <string_view>
+
+thread_local abcg::Profiler::ThreadBuffer *abcg::Profiler::m_threadBuffer{};
+
+namespace {
+// Color of a zone, the same for every zone with the same name
+ImU32 zoneColor(std::string_view name) {
+  const auto hash{std::hash<std::string_view>{}(name)};
+  const auto hue{static_cast<float>(hash % 360) / 360.0f};
+  return ImColor::HSV(hue, 0.45f, 0.85f);
+}
+}  // namespace
+
+/**
+ * @brief Returns the profiler shared by the application.
+ *
+ * @return Reference to the profiler.
+ */
+abcg::Profiler &abcg::Profiler::getInstance() {
+  static Profiler instance;
+  return instance;
+}
+
+/**
+ * @brief Returns the current time of the profiler's clock.
+ *
+ * @return Time in nanoseconds.
+ */
+std::int64_t abcg::Profiler::now() noexcept {
+  using namespace std::chrono;
+  return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch())
+      .count();
+}
+
+/**
+ * @brief Marks the start of a frame.
+ *
+ * Must always be called by the same thread, whose row is named "Main" unless
+ * named otherwise.
+ */
+void abcg::Profiler::beginFrame() {
+  auto &buffer{getThreadBuffer()};
+  const char *unnamed{};
+  buffer.name.compare_exchange_strong(unnamed, "Main");
+
+  m_frameStarts.at(m_numFrames % m_frameStarts.size()) = now();
+  ++m_numFrames;
+}
+
+/**
+ * @brief Names the row of the current thread in the profiler window.
+ *
+ * @param name Name of the thread. Must outlive the profiler.
+ */
+void abcg::Profiler::setThreadName(const char *name) {
+  getThreadBuffer().name.store(name, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Draws the profiler window.
+ *
+ * Shows the zones of every thread during the last complete frames on a
+ * timeline, and the time per frame of each zone in a table, beside the GPU
+ * time of the pass of the same name, if any. Must be called between
+ * `ImGui::NewFrame` and `ImGui::Render` by the thread that calls beginFrame().
+ */
+void abcg::Profiler::paintUI() {
+  ImGui::SetNextWindowSize(ImVec2(640, 320), ImGuiCond_FirstUseEver);
+  if (!ImGui::Begin("Profiler")) {
+    ImGui::End();
+    return;
+  }
+
+  ImGui::Checkbox("Pause", &m_paused);
+  ImGui::SameLine();
+  ImGui::SetNextItemWidth(120.0f);
+  ImGui::SliderInt("Frames", &m_numFramesShown, 1,
+                   static_cast<int>(maxFrames));
+  if (!m_paused) takeCopy();
+
+  if (m_copyFrameStarts.size() > 1) {
+    paintTimeline();
+    paintTotals();
+  }
+  ImGui::End();
+}
+
+// Returns the ring buffer of the current thread, creating it on the first
+// call from the thread. Buffers are kept after their threads end, so that
+// their last zones can still be shown.
+abcg::Profiler::ThreadBuffer &abcg::Profiler::getThreadBuffer() {
+  if (m_threadBuffer == nullptr) {
+    const std::scoped_lock lock{m_buffersMutex};
+    m_threadBuffer =
+        m_buffers.emplace_back(std::make_unique<ThreadBuffer>()).get();
+  }
+  return *m_threadBuffer;
+}
+
+// Copies the zones of the last complete frames. A zone is read without
+// stopping its writer, and is only kept if the writer did not reach its slot
+// again before the end of the buffer was read back.
+void abcg::Profiler::takeCopy() {
+  m_copy.clear();
+  m_copyFrameStarts.clear();
+  m_copyGPU = GPUTimer::getInstance().getTotals(
+      static_cast<std::size_t>(std::max(m_numFramesShown, 1)));
+  if (m_numFrames < 2) return;
+
+  // The current frame started at the end of the last complete frame
+  const auto numFrames{std::min<std::uint64_t>(
+      static_cast<std::uint64_t>(std::max(m_numFramesShown, 1)),
+      m_numFrames - 1)};
+  for (auto frame{m_numFrames - 1 - numFrames}; frame < m_numFrames;
+       ++frame) {
+    m_copyFrameStarts.push_back(
+        m_frameStarts.at(frame % m_frameStarts.size()));
+  }
+  const auto viewBegin{m_copyFrameStarts.front()};
+  const auto viewEnd{m_copyFrameStarts.back()};
+
+  const std::scoped_lock lock{m_buffersMutex};
+  for (const auto &buffer : m_buffers) {
+    const auto head{buffer->head.load(std::memory_order_acquire)};
+    const auto first{head > bufferSize ? head - bufferSize : 0};
+
+    ThreadCopy thread;
+    for (auto index{first}; index < head; ++index) {
+      const auto &zone{buffer->zones.at(index % bufferSize)};
+      thread.zones.push_back(
+          {.name{zone.name.load(std::memory_order_relaxed)},
+           .begin{zone.begin.load(std::memory_order_relaxed)},
+           .end{zone.end.load(std::memory_order_relaxed)},
+           .depth{zone.depth.load(std::memory_order_relaxed)}});
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const auto headAfter{buffer->head.load(std::memory_order_relaxed)};
+
+    // Zones at or before the slot being written may have been overwritten
+    const auto numOverwritten{
+        std::min<std::uint64_t>(headAfter - first + 1 > bufferSize
+                                    ? headAfter - first + 1 - bufferSize
+                                    : 0,
+                                thread.zones.size())};
+    thread.zones.erase(
+        thread.zones.begin(),
+        thread.zones.begin() + static_cast<std::ptrdiff_t>(numOverwritten));
+
+    std::erase_if(thread.zones, [&](const ZoneCopy &zone) {
+      return zone.end <= viewBegin || zone.begin >= viewEnd;
+    });
+    if (thread.zones.empty()) continue;
+
+    for (const auto &zone : thread.zones) {
+      thread.numLevels = std::max(thread.numLevels, zone.depth + 1);
+    }
+    const auto *name{buffer->name.load(std::memory_order_relaxed)};
+    thread.name = name != nullptr
+                      ? name
+                      : fmt::format("Thread {}", m_copy.size() + 1);
+    m_copy.push_back(std::move(thread));
+  }
+}
+
+// Draws the zones of each thread on a timeline, one row per nesting level,
+// with a vertical line at the start of each frame
+void abcg::Profiler::paintTimeline() {
+  const auto viewBegin{m_copyFrameStarts.front()};
+  const auto span{
+      static_cast<double>(m_copyFrameStarts.back() - viewBegin)};
+  const auto width{std::max(ImGui::GetContentRegionAvail().x, 1.0f)};
+  const auto rowHeight{ImGui::GetTextLineHeight() + 2.0f};
+  const auto toX{[&](std::int64_t time) {
+    return static_cast<float>(
+        std::clamp(static_cast<double>(time - viewBegin) / span, 0.0, 1.0) *
+        static_cast<double>(width));
+  }};
+
+  auto *drawList{ImGui::GetWindowDrawList()};
+  const auto mouse{ImGui::GetMousePos()};
+  for (const auto &thread : m_copy) {
+    ImGui::TextUnformatted(thread.name.c_str());
+    const auto origin{ImGui::GetCursorScreenPos()};
+    const ImVec2 size{width, rowHeight * static_cast<float>(thread.numLevels)};
+    // Several threads may have the same name
+    ImGui::PushID(&thread);
+    ImGui::InvisibleButton("Timeline", size);
+    ImGui::PopID();
+    const auto hovered{ImGui::IsItemHovered()};
+
+    for (const auto &zone : thread.zones) {
+      const ImVec2 min{origin.x + toX(zone.begin),
+                       origin.y + rowHeight * static_cast<float>(zone.depth)};
+      const ImVec2 max{std::max(origin.x + toX(zone.end), min.x + 1.0f),
+                       min.y + rowHeight - 1.0f};
+      drawList->AddRectFilled(min, max, zoneColor(zone.name));
+
+      const auto textWidth{ImGui::CalcTextSize(zone.name).x};
+      if (textWidth + 4.0f < max.x - min.x) {
+        drawList->AddText(ImVec2(min.x + 2.0f, min.y + 1.0f),
+                          IM_COL32(0, 0, 0, 255), zone.name);
+      }
+      if (hovered && mouse.x >= min.x && mouse.x < max.x &&
+          mouse.y >= min.y && mouse.y < max.y) {
+        ImGui::SetTooltip("%s: %.3f ms", zone.name,
+                          static_cast<double>(zone.end - zone.begin) * 1e-6);
+      }
+    }
+
+    for (const auto frameStart : m_copyFrameStarts) {
+      const auto x{origin.x + toX(frameStart)};
+      drawList->AddLine(ImVec2(x, origin.y), ImVec2(x, origin.y + size.y),
+                        IM_COL32(255, 255, 255, 96));
+    }
+  }
+}
+
+// Lists the average CPU time per frame of each zone name, including the zones
+// nested in it, and the GPU time of the pass of the same name, from the
+// longest
+void abcg::Profiler::paintTotals() {
+  const auto viewBegin{m_copyFrameStarts.front()};
+  const auto viewEnd{m_copyFrameStarts.back()};
+  const auto numFrames{static_cast<double>(m_copyFrameStarts.size() - 1)};
+
+  struct Total {
+    double time{};
+    std::size_t count{};
+    double gpuTime{};
+    bool hasZone{};
+    bool hasPass{};
+  };
+  std::map<std::string_view, Total> totals;
+  for (const auto &thread : m_copy) {
+    for (const auto &zone : thread.zones) {
+      auto &total{totals[zone.name]};
+      total.time += static_cast<double>(std::min(zone.end, viewEnd) -
+                                        std::max(zone.begin, viewBegin)) *
+                    1e-6;
+      ++total.count;
+      total.hasZone = true;
+    }
+  }
+  for (const auto &[name, time] : m_copyGPU.passes) {
+    auto &total{totals[name]};
+    total.gpuTime = time;
+    total.hasPass = true;
+  }
+  std::vector<std::pair<std::string_view, Total>> sorted{totals.begin(),
+                                                         totals.end()};
+  std::ranges::sort(sorted, std::greater{}, [](const auto &total) {
+    return std::pair{total.second.time, total.second.gpuTime};
+  });
+
+  ImGui::Text("Frame: %.3f ms",
+              static_cast<double>(viewEnd - viewBegin) * 1e-6 / numFrames);
+  if (m_copyGPU.numFrames > 0) {
+    ImGui::SameLine();
+    ImGui::Text("GPU: %.3f ms", m_copyGPU.frame);
+  }
+  if (!ImGui::BeginTable("Zones", 4,
+                         ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+    return;
+  }
+  ImGui::TableSetupColumn("Zone");
+  ImGui::TableSetupColumn("ms/frame");
+  ImGui::TableSetupColumn("Calls/frame");
+  ImGui::TableSetupColumn("GPU ms/frame");
+  ImGui::TableHeadersRow();
+  for (const auto &[name, total] : sorted) {
+    ImGui::TableNextRow();
+    ImGui::TableNextColumn();
+    ImGui::TextUnformatted(name.data(), name.data() + name.size());
+    ImGui::TableNextColumn();
+    if (total.hasZone) {
+      ImGui::Text("%.3f", total.time / numFrames);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.1f", static_cast<double>(total.count) / numFrames);
+    } else {
+      ImGui::TableNextColumn();
+    }
+    ImGui::TableNextColumn();
+    if (total.hasPass) ImGui::Text("%.3f", total.gpuTime);
+  }
+  ImGui::EndTable();
+}
+
+/**
+ * @brief Begins a zone.
+ *
+ * @param name Name of the zone. Must outlive the profiler.
+ */
+abcg::ProfileScope::ProfileScope(const char *name)
+    : m_buffer{&Profiler::getInstance().getThreadBuffer()},
+      m_name{name},
+      m_begin{Profiler::now()},
+      m_depth{m_buffer->depth++} {}
+
+/**
+ * @brief Ends the zone and records it.
+ *
+ * The fields of the zone are written after a release fence, so that a reader
+ * that sees any of them also sees that the slot was reused.
+ */
+abcg::ProfileScope::~ProfileScope() {
+  const auto end{Profiler::now()};
+  --m_buffer->depth;
+
+  const auto index{m_buffer->head.load(std::memory_order_relaxed)};
+  auto &zone{m_buffer->zones[index % Profiler::bufferSize]};
+  std::atomic_thread_fence(std::memory_order_release);
+  zone.name.store(m_name, std::memory_order_relaxed);
+  zone.begin.store(m_begin, std::memory_order_relaxed);
+  zone.end.store(end, std::memory_order_relaxed);
+  zone.depth.store(m_depth, std::memory_order_relaxed);
+  m_buffer->head.store(index + 1, std::memory_order_release);
+}
+#endif
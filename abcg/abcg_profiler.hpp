@@ -0,0 +1,181 @@
+/**
+ * @file abcg_profiler.hpp
+ * @brief abcg::Profiler header file.
+ *
+ * Declaration of abcg::Profiler and abcg::ProfileScope classes, and of the
+ * profiling macros.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_PROFILER_HPP_
+#define ABCG_PROFILER_HPP_
+
+#if defined(ABCG_PROFILE)
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "abcg_gputimer.hpp"
+#include "abcg_profilemacros.hpp"
+
+/**
+ * @brief Records the time until the end of the enclosing scope as a zone of
+ * abcg::Profiler::getInstance().
+ *
+ * Zones nested in a thread are drawn below the zone that contains them.
+ * Compiles to nothing unless `ABCG_PROFILE` is defined (CMake option
+ * `ENABLE_PROFILER`).
+ *
+ * @param name Name of the zone. Must be a string literal, or otherwise
+ * outlive the profiler.
+ */
+#define ABCG_PROFILE_SCOPE(name) \
+  const abcg::ProfileScope ABCG_PROFILE_CONCAT(abcgZone, __LINE__) { name }
+
+/**
+ * @brief Marks the start of a frame in abcg::Profiler::getInstance().
+ *
+ * Called by abcg::OpenGLWindow. Compiles to nothing unless `ABCG_PROFILE` is
+ * defined.
+ */
+#define ABCG_PROFILE_FRAME() abcg::Profiler::getInstance().beginFrame()
+
+/**
+ * @brief Names the row of the current thread in the profiler window.
+ *
+ * Compiles to nothing unless `ABCG_PROFILE` is defined.
+ *
+ * @param name Name of the thread. Must be a string literal, or otherwise
+ * outlive the profiler.
+ */
+#define ABCG_PROFILE_THREAD(name) \
+  abcg::Profiler::getInstance().setThreadName(name)
+
+namespace abcg {
+class Profiler;
+class ProfileScope;
+}  // namespace abcg
+
+/**
+ * @brief abcg::Profiler class.
+ *
+ * Hierarchical CPU profiler of the zones recorded by ABCG_PROFILE_SCOPE().
+ *
+ * Each thread records its zones into a ring buffer of its own, so recording
+ * a zone takes no lock: it only reads the clock when the zone begins and
+ * ends, and writes the zone and the new end of the buffer when it ends. The
+ * thread that draws the profiler window copies the zones of the frames shown,
+ * and drops the ones that the writer could have overwritten meanwhile. Each
+ * buffer holds the last abcg::Profiler::bufferSize zones of its thread.
+ *
+ * The times are read from `std::chrono::steady_clock`, which is available on
+ * every platform, including WebAssembly.
+ *
+ * The GPU times measured by abcg::GPUTimer::getInstance() are listed beside
+ * the CPU times of the zones.
+ *
+ * The class only exists if `ABCG_PROFILE` is defined.
+ */
+class abcg::Profiler {
+ public:
+  /** @brief Number of zones kept per thread. */
+  static constexpr std::size_t bufferSize{4096};
+  /** @brief Maximum number of frames shown by paintUI(). */
+  static constexpr std::size_t maxFrames{32};
+
+  static Profiler &getInstance();
+  [[nodiscard]] static std::int64_t now() noexcept;
+
+  void beginFrame();
+  void setThreadName(const char *name);
+  void paintUI();
+
+ private:
+  friend ProfileScope;
+
+  struct Zone {
+    std::atomic<const char *> name{};
+    std::atomic<std::int64_t> begin{};
+    std::atomic<std::int64_t> end{};
+    std::atomic<std::uint32_t> depth{};
+  };
+
+  struct ThreadBuffer {
+    std::array<Zone, bufferSize> zones;
+    // Number of zones ever written. Only the owner thread writes it.
+    std::atomic<std::uint64_t> head{};
+    std::atomic<const char *> name{};
+    // Depth of the next zone, only used by the owner thread
+    std::uint32_t depth{};
+  };
+
+  // Copy of a zone, and of the zones of a thread, taken by paintUI()
+  struct ZoneCopy {
+    const char *name{};
+    std::int64_t begin{};
+    std::int64_t end{};
+    std::uint32_t depth{};
+  };
+  struct ThreadCopy {
+    std::string name;
+    std::vector<ZoneCopy> zones;
+    std::uint32_t numLevels{};
+  };
+
+  ThreadBuffer &getThreadBuffer();
+  void takeCopy();
+  void paintTimeline();
+  void paintTotals();
+
+  // Every ring buffer, and the one of the current thread
+  std::mutex m_buffersMutex;
+  std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+  static thread_local ThreadBuffer *m_threadBuffer;
+
+  // Start times of the last frames, written by the thread that draws them
+  std::array<std::int64_t, maxFrames + 1> m_frameStarts{};
+  std::uint64_t m_numFrames{};
+
+  int m_numFramesShown{4};
+  bool m_paused{};
+  std::vector<ThreadCopy> m_copy;
+  std::vector<std::int64_t> m_copyFrameStarts;
+  GPUTimer::Totals m_copyGPU;
+};
+
+/**
+ * @brief abcg::ProfileScope class.
+ *
+ * Zone of abcg::Profiler::getInstance() that begins when constructed and
+ * ends when destroyed. Created by ABCG_PROFILE_SCOPE().
+ */
+class abcg::ProfileScope {
+ public:
+  explicit ProfileScope(const char *name);
+  ~ProfileScope();
+
+  ProfileScope(const ProfileScope &) = delete;
+  ProfileScope(ProfileScope &&) = delete;
+  ProfileScope &operator=(const ProfileScope &) = delete;
+  ProfileScope &operator=(ProfileScope &&) = delete;
+
+ private:
+  Profiler::ThreadBuffer *m_buffer{};
+  const char *m_name{};
+  std::int64_t m_begin{};
+  std::uint32_t m_depth{};
+};
+
+#else
+#define ABCG_PROFILE_SCOPE(name) static_cast<void>(0)
+#define ABCG_PROFILE_FRAME() static_cast<void>(0)
+#define ABCG_PROFILE_THREAD(name) static_cast<void>(0)
+#endif
+
+#endif
@@ -0,0 +1,380 @@
+/**
+ * @file abcg_renderqueue.cpp
+ * @brief Definition of abcg::RenderQueue class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_renderqueue.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <glm/gtc/matrix_inverse.hpp>
+#include <glm/mat3x3.hpp>
+
+#include "abcg_exception.hpp"
+#include "abcg_gputimer.hpp"
+
+namespace {
+
+// Returns the position of value in the table, appending it if not found
+template <typename T>
+std::uint64_t findOrAppend(std::vector<T> &table, const T &value) {
+  const auto iter{std::find(table.begin(), table.end(), value)};
+  if (iter != table.end()) {
+    return static_cast<std::uint64_t>(std::distance(table.begin(), iter));
+  }
+  table.push_back(value);
+  return table.size() - 1;
+}
+
+// Maps a non-negative depth to 16 bits that sort in the same order. The bit
+// pattern of a non-negative IEEE 754 float increases with its value, so its
+// upper half is a monotonic quantization that needs no depth range.
+std::uint64_t quantizeDepth(float depth) {
+  const auto bits{std::bit_cast<std::uint32_t>(std::max(depth, 0.0f))};
+  return bits >> 16U;
+}
+
+}  // namespace
+
+/**
+ * @brief Starts a new frame, discarding any item not yet flushed.
+ *
+ * @param viewMatrix View matrix of the frame. It is used for computing the
+ * depth of each item and, for items without a transform batch, their
+ * matrices.
+ * @param projMatrix Projection matrix of the frame.
+ */
+void abcg::RenderQueue::begin(const glm::mat4 &viewMatrix,
+                              const glm::mat4 &projMatrix) {
+  m_viewMatrix = viewMatrix;
+  m_viewProjMatrix = projMatrix * viewMatrix;
+
+  m_items.clear();
+  m_entries.clear();
+  m_programs.clear();
+  m_locations.clear();
+  m_materials.clear();
+  m_VAOs.clear();
+}
+
+/**
+ * @brief Adds a draw item to the frame.
+ *
+ * @param item Draw item. It is copied, but its material is referenced.
+ *
+ * @throw abcg::Exception if the item has no material or if the frame already
+ * has 65536 distinct programs, materials or meshes.
+ */
+void abcg::RenderQueue::submit(const DrawItem &item) {
+  if (item.material == nullptr) {
+    throw abcg::Exception{
+        abcg::Exception::Runtime("Draw item has no material")};
+  }
+
+  const auto program{registerProgram(item.program)};
+  const auto depthProgram{
+      item.depthProgram != 0 ? registerProgram(item.depthProgram) : 0};
+  const auto material{findOrAppend(m_materials, item.material)};
+  const auto mesh{findOrAppend(
+      m_VAOs, item.batch != nullptr ? item.batch->getVAO() : item.VAO)};
+
+  if (std::max({program, depthProgram, material, mesh}) > 0xFFFFU) {
+    throw abcg::Exception{
+        abcg::Exception::Runtime("Too many distinct states in render queue")};
+  }
+
+  // Distance to the camera of the object origin
+  const auto depth{
+      item.transforms != nullptr
+          ? -item.transforms->getModelViewMatrix(item.transform)[3].z
+          : -(m_viewMatrix * item.modelMatrix[3]).z};
+
+  const std::uint64_t key{program << 48U | material << 32U | mesh << 16U |
+                          quantizeDepth(depth)};
+
+  m_entries.push_back({key, static_cast<std::uint32_t>(m_items.size()),
+                       static_cast<std::uint32_t>(depthProgram)});
+  m_items.push_back(item);
+}
+
+/**
+ * @brief Sorts and draws every item submitted since begin().
+ *
+ * Only the state that differs from the previous item is changed. At the end,
+ * the VAO and program bindings are reset to zero, and the depth test is left
+ * as `GL_LESS` with depth writes enabled.
+ */
+void abcg::RenderQueue::flush() {
+  m_stats = {};
+
+  if (m_depthPrepass) {
+    {
+      ABCG_GPU_SCOPE("Depth pre-pass");
+      drawPrepass();
+    }
+    std::sort(m_entries.begin(), m_entries.end(),
+              [](const auto &a, const auto &b) { return a.key < b.key; });
+  } else {
+    // Front to back, then by state
+    std::sort(m_entries.begin(), m_entries.end(),
+              [](const auto &a, const auto &b) {
+                const auto depthA{a.key & 0xFFFFU};
+                const auto depthB{b.key & 0xFFFFU};
+                return depthA != depthB ? depthA < depthB : a.key < b.key;
+              });
+  }
+
+  GLuint currentProgram{};
+  GLuint currentVAO{};
+  const Material *currentMaterial{};
+  std::array<GLuint, std::tuple_size_v<decltype(DrawItem::textures)>>
+      currentTextures{};
+  const UniformLocations *locations{};
+  bool depthEqual{};
+
+  for (const auto &entry : m_entries) {
+    const auto &item{m_items[entry.item]};
+
+    // Items already in the depth buffer only shade their visible fragments
+    if (const auto prepassed{m_depthPrepass && item.depthProgram != 0};
+        prepassed != depthEqual) {
+      glDepthFunc(prepassed ? GL_EQUAL : GL_LESS);
+      glDepthMask(prepassed ? GL_FALSE : GL_TRUE);
+      depthEqual = prepassed;
+    }
+
+    if (item.program != currentProgram) {
+      glUseProgram(item.program);
+      currentProgram = item.program;
+      locations = &m_locations[entry.key >> 48U];
+      // Uniform values belong to the program, so upload the material again
+      currentMaterial = nullptr;
+      ++m_stats.programChanges;
+    }
+
+    if (item.material != currentMaterial) {
+      const auto &material{*item.material};
+      glUniform4fv(locations->Ka, 1, &material.Ka.x);
+      glUniform4fv(locations->Kd, 1, &material.Kd.x);
+      glUniform4fv(locations->Ks, 1, &material.Ks.x);
+      glUniform1f(locations->shininess, material.shininess);
+      glUniform1i(locations->mappingMode, material.mappingMode);
+      currentMaterial = item.material;
+      ++m_stats.materialChanges;
+    }
+
+    for (std::size_t unit{}; unit < item.textures.size(); ++unit) {
+      const auto texture{item.textures.at(unit)};
+      if (texture == 0 || texture == currentTextures.at(unit)) continue;
+      glActiveTexture(GL_TEXTURE0 + static_cast<GLenum>(unit));
+      glBindTexture(GL_TEXTURE_2D, texture);
+      currentTextures.at(unit) = texture;
+      ++m_stats.textureChanges;
+    }
+
+    if (item.batch != nullptr) {
+      // The batch binds its own VAO when drawn
+      if (item.batch->getVAO() != currentVAO) ++m_stats.meshChanges;
+    } else if (item.VAO != currentVAO) {
+      glBindVertexArray(item.VAO);
+      currentVAO = item.VAO;
+      ++m_stats.meshChanges;
+    }
+
+    setMatrices(item, *locations);
+    drawItem(item);
+    if (item.batch != nullptr) currentVAO = item.batch->getVAO();
+    ++m_stats.drawCalls;
+  }
+
+  if (depthEqual) {
+    glDepthFunc(GL_LESS);
+    glDepthMask(GL_TRUE);
+  }
+  glBindVertexArray(0);
+  glUseProgram(0);
+
+  m_items.clear();
+  m_entries.clear();
+}
+
+/**
+ * @brief Enables or disables the depth pre-pass.
+ *
+ * @param enabled Whether items with a depth program are drawn to the depth
+ * buffer before the main pass.
+ */
+void abcg::RenderQueue::setDepthPrepass(bool enabled) noexcept {
+  m_depthPrepass = enabled;
+}
+
+/**
+ * @brief Returns whether the depth pre-pass is enabled.
+ *
+ * @return True if the depth pre-pass is enabled.
+ */
+bool abcg::RenderQueue::isDepthPrepassEnabled() const noexcept {
+  return m_depthPrepass;
+}
+
+/**
+ * @brief Returns the statistics of the last call to flush().
+ *
+ * @return Number of draw calls and of each kind of state change.
+ */
+const abcg::RenderQueue::Stats &abcg::RenderQueue::getStats() const noexcept {
+  return m_stats;
+}
+
+/**
+ * @brief Returns the number of items waiting to be flushed.
+ *
+ * @return Number of draw items.
+ */
+std::size_t abcg::RenderQueue::size() const noexcept { return m_items.size(); }
+
+// Returns the index of the program in the frame, looking up its uniform
+// locations when it is first seen
+std::uint64_t abcg::RenderQueue::registerProgram(GLuint program) {
+  const auto numPrograms{m_programs.size()};
+  const auto index{findOrAppend(m_programs, program)};
+  if (m_programs.size() != numPrograms) {
+    UniformLocations locations;
+    locations.modelMatrix = glGetUniformLocation(program, "modelMatrix");
+    locations.modelViewMatrix =
+        glGetUniformLocation(program, "modelViewMatrix");
+    locations.modelViewProjMatrix =
+        glGetUniformLocation(program, "modelViewProjMatrix");
+    locations.normalMatrix = glGetUniformLocation(program, "normalMatrix");
+    locations.Ka = glGetUniformLocation(program, "Ka");
+    locations.Kd = glGetUniformLocation(program, "Kd");
+    locations.Ks = glGetUniformLocation(program, "Ks");
+    locations.shininess = glGetUniformLocation(program, "shininess");
+    locations.mappingMode = glGetUniformLocation(program, "mappingMode");
+    m_locations.push_back(locations);
+  }
+  return index;
+}
+
+// Draws the items that have a depth program front to back, to the depth
+// buffer only
+void abcg::RenderQueue::drawPrepass() {
+  std::vector<const SortEntry *> entries;
+  entries.reserve(m_entries.size());
+  for (const auto &entry : m_entries) {
+    if (m_items[entry.item].depthProgram != 0) entries.push_back(&entry);
+  }
+  if (entries.empty()) return;
+
+  std::sort(entries.begin(), entries.end(), [](const auto *a, const auto *b) {
+    return (a->key & 0xFFFFU) < (b->key & 0xFFFFU);
+  });
+
+  glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+  GLuint currentProgram{};
+  GLuint currentVAO{};
+  const UniformLocations *locations{};
+
+  for (const auto *entry : entries) {
+    const auto &item{m_items[entry->item]};
+
+    if (item.depthProgram != currentProgram) {
+      glUseProgram(item.depthProgram);
+      currentProgram = item.depthProgram;
+      locations = &m_locations[entry->depthProgram];
+    }
+
+    if (item.batch == nullptr && item.VAO != currentVAO) {
+      glBindVertexArray(item.VAO);
+      currentVAO = item.VAO;
+    }
+
+    setMatrices(item, *locations);
+    drawItem(item);
+    if (item.batch != nullptr) currentVAO = item.batch->getVAO();
+    ++m_stats.prepassDrawCalls;
+  }
+
+  glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
+
+// Sets the matrix uniforms declared by the current program, reading them
+// from the transform batch of the item or computing them from its model
+// matrix
+void abcg::RenderQueue::setMatrices(const DrawItem &item,
+                                    const UniformLocations &locations) {
+  if (item.transforms != nullptr) {
+    const auto &transforms{*item.transforms};
+    const auto index{item.transform};
+    if (locations.modelMatrix >= 0) {
+      glUniformMatrix4fv(locations.modelMatrix, 1, GL_FALSE,
+                         &transforms.getModelMatrix(index)[0][0]);
+    }
+    if (locations.modelViewMatrix >= 0) {
+      glUniformMatrix4fv(locations.modelViewMatrix, 1, GL_FALSE,
+                         &transforms.getModelViewMatrix(index)[0][0]);
+    }
+    if (locations.modelViewProjMatrix >= 0) {
+      glUniformMatrix4fv(locations.modelViewProjMatrix, 1, GL_FALSE,
+                         &transforms.getModelViewProjMatrix(index)[0][0]);
+    }
+    if (locations.normalMatrix >= 0) {
+      glUniformMatrix3fv(locations.normalMatrix, 1, GL_FALSE,
+                         &transforms.getNormalMatrix(index)[0][0]);
+    }
+    return;
+  }
+
+  if (locations.modelMatrix >= 0) {
+    glUniformMatrix4fv(locations.modelMatrix, 1, GL_FALSE,
+                       &item.modelMatrix[0][0]);
+  }
+  const auto modelViewMatrix{m_viewMatrix * item.modelMatrix};
+  if (locations.modelViewMatrix >= 0) {
+    glUniformMatrix4fv(locations.modelViewMatrix, 1, GL_FALSE,
+                       &modelViewMatrix[0][0]);
+  }
+  if (locations.modelViewProjMatrix >= 0) {
+    const auto modelViewProjMatrix{m_viewProjMatrix * item.modelMatrix};
+    glUniformMatrix4fv(locations.modelViewProjMatrix, 1, GL_FALSE,
+                       &modelViewProjMatrix[0][0]);
+  }
+  if (locations.normalMatrix >= 0) {
+    const glm::mat3 normalMatrix{
+        glm::inverseTranspose(glm::mat3(modelViewMatrix))};
+    glUniformMatrix3fv(locations.normalMatrix, 1, GL_FALSE,
+                       &normalMatrix[0][0]);
+  }
+}
+
+// Issues the draw call of an item with its VAO already bound, unless it is
+// drawn by a batch
+void abcg::RenderQueue::drawItem(const DrawItem &item) {
+  if (item.batch != nullptr) {
+    item.batch->draw();
+    return;
+  }
+
+  const auto *indices{
+      reinterpret_cast<void *>(item.firstIndex * sizeof(GLuint))};
+  if (item.instanceCount > 1) {
+#if defined(__EMSCRIPTEN__)
+    glDrawElementsInstanced(GL_TRIANGLES, item.count, GL_UNSIGNED_INT, indices,
+                            item.instanceCount);
+#else
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, item.count,
+                                      GL_UNSIGNED_INT, indices,
+                                      item.instanceCount, item.baseVertex);
+#endif
+  } else {
+#if defined(__EMSCRIPTEN__)
+    glDrawElements(GL_TRIANGLES, item.count, GL_UNSIGNED_INT, indices);
+#else
+    glDrawElementsBaseVertex(GL_TRIANGLES, item.count, GL_UNSIGNED_INT,
+                             indices, item.baseVertex);
+#endif
+  }
+}
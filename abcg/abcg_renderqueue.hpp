@@ -0,0 +1,174 @@
+/**
+ * @file abcg_renderqueue.hpp
+ * @brief abcg::RenderQueue header file.
+ *
+ * Declaration of abcg::RenderQueue class.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_RENDERQUEUE_HPP_
+#define ABCG_RENDERQUEUE_HPP_
+
+#include <array>
+#include <cstdint>
+#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
+#include <vector>
+
+#include "abcg_multidrawbatch.hpp"
+#include "abcg_openglfunctions.hpp"
+#include "abcg_transformbatch.hpp"
+
+namespace abcg {
+class RenderQueue;
+}  // namespace abcg
+
+/**
+ * @brief abcg::RenderQueue class.
+ *
+ * Collects the opaque draw items of a frame and replays them sorted by a
+ * 64-bit key.
+ *
+ * From the most to the least significant bits, the key holds the program, the
+ * material, the mesh (VAO) and the view-space depth of the item. Programs,
+ * materials and meshes are identified by small indices assigned in the order
+ * they are first submitted in the frame, so the key does not depend on the
+ * values of the OpenGL names.
+ *
+ * By default, items are drawn front to back, sorted by depth and then by the
+ * rest of the key, so that hidden fragments fail the depth test before they
+ * are shaded.
+ *
+ * With the depth pre-pass enabled, items that have a `depthProgram` are first
+ * drawn front to back with that program and color writes disabled, which
+ * fills the depth buffer. All items are then drawn sorted by the key, so
+ * that consecutive items share as much OpenGL state as possible, and the
+ * pre-pass items are drawn with `glDepthFunc(GL_EQUAL)` and depth writes
+ * disabled, so each pixel is shaded once. Depth programs must compute
+ * `gl_Position` exactly as the main programs do, e.g. with the same
+ * expression and `invariant gl_Position`.
+ *
+ * The queue sets the uniforms `modelMatrix`, `modelViewMatrix`,
+ * `modelViewProjMatrix`, `normalMatrix`, `Ka`, `Kd`, `Ks`, `shininess` and
+ * `mappingMode` of each program, depth programs included. Their locations are
+ * queried once per program per frame, and uniforms not declared by the
+ * program are ignored.
+ */
+class abcg::RenderQueue {
+ public:
+  /**
+   * @brief Surface properties shared by draw items.
+   *
+   * Draw items are grouped by the address of their material, so objects
+   * should keep their material alive and unchanged until flush() is called.
+   */
+  struct Material {
+    glm::vec4 Ka{0.1f, 0.1f, 0.1f, 1.0f};
+    glm::vec4 Kd{0.7f, 0.7f, 0.7f, 1.0f};
+    glm::vec4 Ks{1.0f, 1.0f, 1.0f, 1.0f};
+    float shininess{25.0f};
+    GLint mappingMode{};
+  };
+
+  /**
+   * @brief A single indexed draw call and the state it needs.
+   *
+   * `count` indices are read starting at `firstIndex`, and `baseVertex` is
+   * added to each of them, as in the meshes of an abcg::MeshArena.
+   *
+   * `textures[i]` is bound as a `GL_TEXTURE_2D` to texture unit `i`. A zero
+   * name leaves the unit untouched.
+   *
+   * `depthProgram` is the program used for drawing the item in the depth
+   * pre-pass, or 0 if the item is not part of it.
+   *
+   * If `transforms` is set, the matrices of the item are those of transform
+   * `transform` of the batch, which must have been updated with the view and
+   * projection matrices of the frame, and `modelMatrix` is ignored. Otherwise,
+   * they are computed from `modelMatrix` when the item is drawn.
+   *
+   * If `batch` is set, the commands recorded in the batch are drawn instead,
+   * and `VAO`, `count`, `firstIndex`, `baseVertex` and `instanceCount` are
+   * ignored. The batch must be kept
+   * alive until flush() is called.
+   */
+  struct DrawItem {
+    GLuint program{};
+    GLuint depthProgram{};
+    GLuint VAO{};
+    GLsizei count{};
+    GLuint firstIndex{};
+    GLint baseVertex{};
+    GLsizei instanceCount{1};
+    std::array<GLuint, 2> textures{};
+    const Material *material{};
+    glm::mat4 modelMatrix{1.0f};
+    const TransformBatch *transforms{};
+    std::size_t transform{};
+    MultiDrawBatch *batch{};
+  };
+
+  /**
+   * @brief Statistics of the last flushed frame.
+   */
+  struct Stats {
+    std::size_t drawCalls{};
+    std::size_t prepassDrawCalls{};
+    std::size_t programChanges{};
+    std::size_t materialChanges{};
+    std::size_t textureChanges{};
+    std::size_t meshChanges{};
+  };
+
+  void begin(const glm::mat4 &viewMatrix, const glm::mat4 &projMatrix);
+  void submit(const DrawItem &item);
+  void flush();
+
+  void setDepthPrepass(bool enabled) noexcept;
+  [[nodiscard]] bool isDepthPrepassEnabled() const noexcept;
+  [[nodiscard]] const Stats &getStats() const noexcept;
+  [[nodiscard]] std::size_t size() const noexcept;
+
+ private:
+  struct UniformLocations {
+    GLint modelMatrix{-1};
+    GLint modelViewMatrix{-1};
+    GLint modelViewProjMatrix{-1};
+    GLint normalMatrix{-1};
+    GLint Ka{-1};
+    GLint Kd{-1};
+    GLint Ks{-1};
+    GLint shininess{-1};
+    GLint mappingMode{-1};
+  };
+
+  struct SortEntry {
+    std::uint64_t key{};
+    std::uint32_t item{};
+    // Index of the depth program of the item, if it has one
+    std::uint32_t depthProgram{};
+  };
+
+  std::uint64_t registerProgram(GLuint program);
+  void drawPrepass();
+  void setMatrices(const DrawItem &item, const UniformLocations &locations);
+  void drawItem(const DrawItem &item);
+
+  glm::mat4 m_viewMatrix{1.0f};
+  glm::mat4 m_viewProjMatrix{1.0f};
+  bool m_depthPrepass{};
+
+  std::vector<DrawItem> m_items;
+  std::vector<SortEntry> m_entries;
+
+  // Distinct states seen this frame. Their positions are the key fields.
+  std::vector<GLuint> m_programs;
+  std::vector<UniformLocations> m_locations;
+  std::vector<const Material *> m_materials;
+  std::vector<GLuint> m_VAOs;
+
+  Stats m_stats;
+};
+
+#endif
@@ -0,0 +1,174 @@
+/**
+ * @file abcg_scenegraph.cpp
+ * @brief Definition of abcg::SceneGraph class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_scenegraph.hpp"
+
+#include "abcg_exception.hpp"
+#include "abcg_transformbatch.hpp"
+
+/**
+ * @brief Adds a node.
+ *
+ * Its world matrix is computed by the next call to update().
+ *
+ * @param parent Index of the parent node, or abcg::SceneGraph::noParent for a
+ * root node.
+ * @param translation Translation relative to the parent.
+ * @param rotation Unit quaternion of the rotation relative to the parent.
+ * @param scale Scale factor along each axis. Must not be zero.
+ * @param transform Index of the transform of the abcg::TransformBatch passed
+ * to update() that receives the world TRS of the node, or
+ * abcg::SceneGraph::noTransform.
+ * @return Index of the node.
+ *
+ * @throw abcg::Exception if the parent is not an existing node.
+ */
+std::size_t abcg::SceneGraph::add(std::size_t parent,
+                                  const glm::vec3 &translation,
+                                  const glm::quat &rotation,
+                                  const glm::vec3 &scale,
+                                  std::size_t transform) {
+  if (parent != noParent && parent >= m_nodes.size()) {
+    throw abcg::Exception{
+        abcg::Exception::Runtime("Parent scene node does not exist")};
+  }
+
+  m_nodes.push_back({.translation{translation},
+                     .rotation{rotation},
+                     .scale{scale},
+                     .parent{parent},
+                     .transform{transform}});
+  m_worldMatrices.emplace_back(1.0f);
+  m_dirty.push_back(1);
+  m_updated.push_back(0);
+
+  return m_nodes.size() - 1;
+}
+
+/**
+ * @brief Removes every node.
+ */
+void abcg::SceneGraph::clear() noexcept {
+  m_nodes.clear();
+  m_worldMatrices.clear();
+  m_dirty.clear();
+  m_updated.clear();
+  m_numUpdated = 0;
+}
+
+/**
+ * @brief Computes the world matrices of the nodes that changed.
+ *
+ * The links of the nodes to transforms are ignored.
+ */
+void abcg::SceneGraph::update() { updateNodes(nullptr); }
+
+/**
+ * @brief Computes the world matrices of the nodes that changed, and copies
+ * their world TRS to the linked transforms.
+ *
+ * @param transforms Batch of the transforms linked to the nodes.
+ */
+void abcg::SceneGraph::update(TransformBatch &transforms) {
+  updateNodes(&transforms);
+}
+
+/**
+ * @brief Sets the translation of a node relative to its parent.
+ *
+ * The node is only marked as changed if the translation differs from the
+ * current one.
+ *
+ * @param node Index of the node.
+ * @param translation Translation.
+ */
+void abcg::SceneGraph::setTranslation(std::size_t node,
+                                      const glm::vec3 &translation) {
+  auto &current{m_nodes.at(node).translation};
+  if (current == translation) return;
+  current = translation;
+  m_dirty[node] = 1;
+}
+
+/**
+ * @brief Sets the rotation of a node relative to its parent.
+ *
+ * The node is only marked as changed if the rotation differs from the current
+ * one.
+ *
+ * @param node Index of the node.
+ * @param rotation Unit quaternion of the rotation.
+ */
+void abcg::SceneGraph::setRotation(std::size_t node,
+                                   const glm::quat &rotation) {
+  auto &current{m_nodes.at(node).rotation};
+  if (current == rotation) return;
+  current = rotation;
+  m_dirty[node] = 1;
+}
+
+/**
+ * @brief Sets the scale of a node.
+ *
+ * The node is only marked as changed if the scale differs from the current
+ * one.
+ *
+ * @param node Index of the node.
+ * @param scale Scale factor along each axis. Must not be zero.
+ */
+void abcg::SceneGraph::setScale(std::size_t node, const glm::vec3 &scale) {
+  auto &current{m_nodes.at(node).scale};
+  if (current == scale) return;
+  current = scale;
+  m_dirty[node] = 1;
+}
+
+// Recomputes the changed nodes in order, so that a parent is always up to
+// date before its children
+void abcg::SceneGraph::updateNodes(TransformBatch *transforms) {
+  m_numUpdated = 0;
+
+  for (std::size_t index{}; index < m_nodes.size(); ++index) {
+    const auto &node{m_nodes[index]};
+    const auto isRoot{node.parent == noParent};
+    m_updated[index] = m_dirty[index] != 0 ||
+                       (!isRoot && m_updated[node.parent] != 0);
+    if (m_updated[index] == 0) continue;
+    m_dirty[index] = 0;
+    ++m_numUpdated;
+
+    glm::mat4 localMatrix{glm::mat3_cast(node.rotation)};
+    localMatrix[0] *= node.scale.x;
+    localMatrix[1] *= node.scale.y;
+    localMatrix[2] *= node.scale.z;
+    localMatrix[3] = glm::vec4(node.translation, 1.0f);
+
+    auto &worldMatrix{m_worldMatrices[index]};
+    worldMatrix =
+        isRoot ? localMatrix : m_worldMatrices[node.parent] * localMatrix;
+
+    if (transforms == nullptr || node.transform == noTransform) continue;
+
+    // The world TRS of a root node is its local TRS. Otherwise, it is taken
+    // apart from the world matrix.
+    if (isRoot) {
+      transforms->setTranslation(node.transform, node.translation);
+      transforms->setRotation(node.transform, node.rotation);
+      transforms->setScale(node.transform, node.scale);
+      continue;
+    }
+    const glm::vec3 scale{glm::length(glm::vec3{worldMatrix[0]}),
+                          glm::length(glm::vec3{worldMatrix[1]}),
+                          glm::length(glm::vec3{worldMatrix[2]})};
+    const glm::mat3 rotation{glm::vec3{worldMatrix[0]} / scale.x,
+                             glm::vec3{worldMatrix[1]} / scale.y,
+                             glm::vec3{worldMatrix[2]} / scale.z};
+    transforms->setTranslation(node.transform, glm::vec3{worldMatrix[3]});
+    transforms->setRotation(node.transform, glm::quat_cast(rotation));
+    transforms->setScale(node.transform, scale);
+  }
+}
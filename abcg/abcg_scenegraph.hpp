@@ -0,0 +1,107 @@
+/**
+ * @file abcg_scenegraph.hpp
+ * @brief abcg::SceneGraph header file.
+ *
+ * Declaration of abcg::SceneGraph class.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_SCENEGRAPH_HPP_
+#define ABCG_SCENEGRAPH_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <limits>
+#include <vector>
+
+namespace abcg {
+class SceneGraph;
+class TransformBatch;
+}  // namespace abcg
+
+/**
+ * @brief abcg::SceneGraph class.
+ *
+ * Hierarchy of scene nodes, each with a local translation, rotation and scale
+ * (TRS) relative to its parent, and a cached world matrix.
+ *
+ * The nodes are stored in a flat array in which every parent comes before its
+ * children, as add() only accepts existing nodes as parents. update() then
+ * computes the world matrices in a single linear pass, and only for the nodes
+ * whose local TRS changed since the last update, or whose parent's world
+ * matrix was recomputed. Objects that do not move cost nothing per frame.
+ *
+ * A node may be linked to a transform of an abcg::TransformBatch. update()
+ * then copies the world TRS of the node to the batch whenever it changes.
+ * A child node's world TRS is taken from its world matrix, which is only
+ * exact for positive scales and when the scale of the ancestors is uniform,
+ * or aligned with the axes of the child.
+ */
+class abcg::SceneGraph {
+ public:
+  // Parent of the root nodes, and transform of the nodes not linked to a
+  // transform batch
+  static constexpr std::size_t noParent{
+      std::numeric_limits<std::size_t>::max()};
+  static constexpr std::size_t noTransform{
+      std::numeric_limits<std::size_t>::max()};
+
+  std::size_t add(std::size_t parent = noParent,
+                  const glm::vec3 &translation = glm::vec3{0.0f},
+                  const glm::quat &rotation = glm::quat{1.0f, 0.0f, 0.0f,
+                                                        0.0f},
+                  const glm::vec3 &scale = glm::vec3{1.0f},
+                  std::size_t transform = noTransform);
+  void clear() noexcept;
+  void update();
+  void update(TransformBatch &transforms);
+
+  void setTranslation(std::size_t node, const glm::vec3 &translation);
+  void setRotation(std::size_t node, const glm::quat &rotation);
+  void setScale(std::size_t node, const glm::vec3 &scale);
+
+  [[nodiscard]] const glm::vec3 &getTranslation(std::size_t node) const {
+    return m_nodes.at(node).translation;
+  }
+  [[nodiscard]] const glm::quat &getRotation(std::size_t node) const {
+    return m_nodes.at(node).rotation;
+  }
+  [[nodiscard]] const glm::vec3 &getScale(std::size_t node) const {
+    return m_nodes.at(node).scale;
+  }
+  [[nodiscard]] std::size_t getParent(std::size_t node) const {
+    return m_nodes.at(node).parent;
+  }
+  [[nodiscard]] const glm::mat4 &getWorldMatrix(std::size_t node) const {
+    return m_worldMatrices.at(node);
+  }
+  [[nodiscard]] std::size_t size() const noexcept { return m_nodes.size(); }
+  [[nodiscard]] std::size_t getNumUpdated() const noexcept {
+    return m_numUpdated;
+  }
+
+ private:
+  struct Node {
+    glm::vec3 translation{};
+    glm::quat rotation{};
+    glm::vec3 scale{};
+    std::size_t parent{};
+    std::size_t transform{};
+  };
+
+  void updateNodes(TransformBatch *transforms);
+
+  std::vector<Node> m_nodes;
+  std::vector<glm::mat4> m_worldMatrices;
+  // Whether the local TRS of each node changed since the last update, and
+  // whether its world matrix was recomputed by the last update
+  std::vector<std::uint8_t> m_dirty;
+  std::vector<std::uint8_t> m_updated;
+  std::size_t m_numUpdated{};
+};
+
+#endif
@@ -0,0 +1,175 @@
+/**
+ * @file abcg_spritebatch.cpp
+ * @brief Definition of abcg::SpriteBatch class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_spritebatch.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+/**
+ * @brief Creates the shared geometry and the instance buffer of the batch.
+ *
+ * Any previously created OpenGL resources of the batch are released first.
+ *
+ * @param program Shader program used to query the attribute locations.
+ * @param positions Vertex positions of the shape.
+ * @param indices Triangle indices of the shape.
+ */
+void abcg::SpriteBatch::initializeGL(GLuint program,
+                                     std::span<const glm::vec2> positions,
+                                     std::span<const GLuint> indices) {
+  terminateGL();
+
+  m_numIndices = static_cast<GLsizei>(indices.size());
+
+  // Generate VBO
+  glGenBuffers(1, &m_VBO);
+  glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+  glBufferData(GL_ARRAY_BUFFER,
+               static_cast<GLsizeiptr>(positions.size_bytes()),
+               positions.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  // Generate EBO
+  glGenBuffers(1, &m_EBO);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+               static_cast<GLsizeiptr>(indices.size_bytes()), indices.data(),
+               GL_STATIC_DRAW);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+  // Generate instance VBO. Storage is allocated on the first draw.
+  glGenBuffers(1, &m_instanceVBO);
+  m_instanceCapacity = 0;
+
+  // Create VAO
+  glGenVertexArrays(1, &m_VAO);
+
+  // Bind vertex attributes to current VAO
+  glBindVertexArray(m_VAO);
+
+  glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+  if (auto location{glGetAttribLocation(program, "inPosition")};
+      location >= 0) {
+    glEnableVertexAttribArray(static_cast<GLuint>(location));
+    glVertexAttribPointer(static_cast<GLuint>(location), 2, GL_FLOAT, GL_FALSE,
+                          sizeof(glm::vec2), nullptr);
+  }
+
+  // Per-instance attributes
+  glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+  if (auto location{glGetAttribLocation(program, "inTranslation")};
+      location >= 0) {
+    glEnableVertexAttribArray(static_cast<GLuint>(location));
+    glVertexAttribPointer(
+        static_cast<GLuint>(location), 2, GL_FLOAT, GL_FALSE, sizeof(Instance),
+        reinterpret_cast<void*>(offsetof(Instance, translation)));
+    glVertexAttribDivisor(static_cast<GLuint>(location), 1);
+  }
+  if (auto location{glGetAttribLocation(program, "inColor")}; location >= 0) {
+    glEnableVertexAttribArray(static_cast<GLuint>(location));
+    glVertexAttribPointer(static_cast<GLuint>(location), 4, GL_FLOAT, GL_FALSE,
+                          sizeof(Instance),
+                          reinterpret_cast<void*>(offsetof(Instance, color)));
+    glVertexAttribDivisor(static_cast<GLuint>(location), 1);
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+
+  // End of binding to current VAO
+  glBindVertexArray(0);
+}
+
+/**
+ * @brief Uploads the instance array and draws every instance.
+ *
+ * The caller is responsible for binding the shader program and setting its
+ * uniform variables.
+ */
+void abcg::SpriteBatch::draw() {
+  if (m_instances.empty() || m_VAO == 0) return;
+
+  // Grow geometrically so that the store is rarely reallocated
+  if (m_instances.size() > m_instanceCapacity) {
+    m_instanceCapacity = std::max(m_instances.size(), 2 * m_instanceCapacity);
+  }
+
+  // Orphan the previous storage so the upload doesn't wait on the GPU
+  glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+  glBufferData(GL_ARRAY_BUFFER,
+               static_cast<GLsizeiptr>(sizeof(Instance) * m_instanceCapacity),
+               nullptr, GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0,
+                  static_cast<GLsizeiptr>(sizeof(Instance) * m_instances.size()),
+                  m_instances.data());
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  glBindVertexArray(m_VAO);
+  glDrawElementsInstanced(GL_TRIANGLES, m_numIndices, GL_UNSIGNED_INT, nullptr,
+                          static_cast<GLsizei>(m_instances.size()));
+  glBindVertexArray(0);
+}
+
+/**
+ * @brief Releases the OpenGL resources of the batch.
+ */
+void abcg::SpriteBatch::terminateGL() {
+  glDeleteBuffers(1, &m_instanceVBO);
+  glDeleteBuffers(1, &m_EBO);
+  glDeleteBuffers(1, &m_VBO);
+  glDeleteVertexArrays(1, &m_VAO);
+
+  m_instanceVBO = 0;
+  m_EBO = 0;
+  m_VBO = 0;
+  m_VAO = 0;
+}
+
+/**
+ * @brief Removes all instances from the batch.
+ */
+void abcg::SpriteBatch::clear() noexcept { m_instances.clear(); }
+
+/**
+ * @brief Appends an instance to the batch.
+ *
+ * @param instance Instance to be drawn on the next call to draw().
+ */
+void abcg::SpriteBatch::add(const Instance& instance) {
+  m_instances.push_back(instance);
+}
+
+/**
+ * @brief Appends an instance to the batch.
+ *
+ * @param translation Translation applied to the shape.
+ * @param color Color of the shape.
+ */
+void abcg::SpriteBatch::add(const glm::vec2& translation,
+                            const glm::vec4& color) {
+  m_instances.push_back({translation, color});
+}
+
+/**
+ * @brief Returns the instance array for in-place updates.
+ *
+ * @return Reference to the contiguous array of instances.
+ */
+std::vector<abcg::SpriteBatch::Instance>&
+abcg::SpriteBatch::getInstances() noexcept {
+  return m_instances;
+}
+
+/**
+ * @brief Returns the number of instances in the batch.
+ *
+ * @return Number of instances.
+ */
+std::size_t abcg::SpriteBatch::size() const noexcept {
+  return m_instances.size();
+}
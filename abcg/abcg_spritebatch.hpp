@@ -0,0 +1,67 @@
+/**
+ * @file abcg_spritebatch.hpp
+ * @brief abcg::SpriteBatch header file.
+ *
+ * Declaration of abcg::SpriteBatch class.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_SPRITEBATCH_HPP_
+#define ABCG_SPRITEBATCH_HPP_
+
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+#include <span>
+#include <vector>
+
+#include "abcg_openglfunctions.hpp"
+
+namespace abcg {
+class SpriteBatch;
+}  // namespace abcg
+
+/**
+ * @brief abcg::SpriteBatch class.
+ *
+ * Draws many copies of a single 2D shape with one instanced draw call.
+ *
+ * The shape geometry is uploaded once to a static VBO/EBO pair. Each copy is
+ * an instance holding a translation and a color, kept in a contiguous array
+ * and streamed to an instance VBO when the batch is drawn.
+ *
+ * The program given to initializeGL() must declare the vertex attributes
+ * `inPosition` (vec2), `inTranslation` (vec2) and `inColor` (vec4).
+ */
+class abcg::SpriteBatch {
+ public:
+  struct Instance {
+    glm::vec2 translation{};
+    glm::vec4 color{1.0f};
+  };
+
+  void initializeGL(GLuint program, std::span<const glm::vec2> positions,
+                    std::span<const GLuint> indices);
+  void draw();
+  void terminateGL();
+
+  void clear() noexcept;
+  void add(const Instance& instance);
+  void add(const glm::vec2& translation, const glm::vec4& color);
+
+  [[nodiscard]] std::vector<Instance>& getInstances() noexcept;
+  [[nodiscard]] std::size_t size() const noexcept;
+
+ private:
+  GLuint m_VAO{};
+  GLuint m_VBO{};
+  GLuint m_EBO{};
+  GLuint m_instanceVBO{};
+
+  GLsizei m_numIndices{};
+  std::size_t m_instanceCapacity{};
+
+  std::vector<Instance> m_instances;
+};
+
+#endif
@@ -0,0 +1,180 @@
+/**
+ * @file abcg_streambuffer.cpp
+ * @brief Definition of abcg::StreamBuffer class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_streambuffer.hpp"
+
+#include "abcg_exception.hpp"
+
+/**
+ * @brief Creates the buffer.
+ *
+ * Any previously created OpenGL resources of the stream buffer are released
+ * first.
+ *
+ * @param target Binding point used while the buffer is created, mapped and
+ * updated, e.g. `GL_ARRAY_BUFFER`. It must not be `GL_ELEMENT_ARRAY_BUFFER`,
+ * whose binding belongs to the VAO.
+ * @param frameSize Maximum number of bytes allocated per frame.
+ *
+ * @throw abcg::Exception if the buffer cannot be mapped.
+ */
+void abcg::StreamBuffer::initializeGL(GLenum target, GLsizeiptr frameSize) {
+  terminateGL();
+
+  m_target = target;
+  m_frameSize = frameSize;
+  const auto size{frameSize * static_cast<GLsizeiptr>(m_numRegions)};
+
+  glGenBuffers(1, &m_buffer);
+  glBindBuffer(m_target, m_buffer);
+
+#if defined(__EMSCRIPTEN__)
+  m_persistent = false;
+#else
+  m_persistent = GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+#endif
+
+  if (m_persistent) {
+#if !defined(__EMSCRIPTEN__)
+    const GLbitfield flags{GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT |
+                           GL_MAP_COHERENT_BIT};
+    glBufferStorage(m_target, size, nullptr, flags);
+    m_mapped = static_cast<std::byte *>(
+        glMapBufferRange(m_target, 0, size, flags));
+#endif
+  } else {
+    glBufferData(m_target, size, nullptr, GL_STREAM_DRAW);
+  }
+
+  glBindBuffer(m_target, 0);
+
+  if (m_persistent && m_mapped == nullptr) {
+    throw abcg::Exception{
+        abcg::Exception::Runtime("Failed to map stream buffer")};
+  }
+
+#if defined(__EMSCRIPTEN__)
+  m_shadow.resize(static_cast<std::size_t>(frameSize));
+#endif
+}
+
+/**
+ * @brief Starts writing the data of a new frame.
+ *
+ * Fences the commands issued since the previous call and moves to the next
+ * region, waiting for the GPU only if it has not finished reading that
+ * region yet.
+ *
+ * @throw abcg::Exception if the region cannot be mapped.
+ */
+void abcg::StreamBuffer::beginFrame() {
+#if !defined(__EMSCRIPTEN__)
+  if (m_started) {
+    m_fences.at(m_region) = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_region = (m_region + 1) % m_numRegions;
+  }
+
+  if (auto &fence{m_fences.at(m_region)}; fence != nullptr) {
+    constexpr GLuint64 timeout{1'000'000};  // 1 ms
+    while (abcg::glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                  timeout) == GL_TIMEOUT_EXPIRED) {
+    }
+    abcg::glDeleteSync(fence);
+    fence = nullptr;
+  }
+
+  if (!m_persistent) {
+    // The fence above already guarantees that the GPU is done with the region
+    glBindBuffer(m_target, m_buffer);
+    m_mapped = static_cast<std::byte *>(glMapBufferRange(
+        m_target, static_cast<GLintptr>(m_region) * m_frameSize, m_frameSize,
+        GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT |
+            GL_MAP_FLUSH_EXPLICIT_BIT));
+    glBindBuffer(m_target, 0);
+    if (m_mapped == nullptr) {
+      throw abcg::Exception{
+          abcg::Exception::Runtime("Failed to map stream buffer")};
+    }
+  }
+#else
+  // glBufferSubData is ordered with the draws, so no fence is needed
+  if (m_started) m_region = (m_region + 1) % m_numRegions;
+  m_mapped = m_shadow.data();
+#endif
+
+  m_started = true;
+  m_used = 0;
+}
+
+/**
+ * @brief Suballocates memory from the region of the current frame.
+ *
+ * Must be called between beginFrame() and endFrame().
+ *
+ * @param size Number of bytes.
+ * @param alignment Alignment of the offset in the OpenGL buffer. It need not
+ * be a power of two, so the size of a structure can be used for reading it
+ * from an instance index.
+ * @return Pointer for writing the data and its offset in the buffer.
+ *
+ * @throw abcg::Exception if the region has not enough space left.
+ */
+abcg::StreamBuffer::Allocation abcg::StreamBuffer::allocate(
+    GLsizeiptr size, GLsizeiptr alignment) {
+  const auto regionOffset{static_cast<GLsizeiptr>(m_region) * m_frameSize};
+  const auto offset{(regionOffset + m_used + alignment - 1) / alignment *
+                    alignment};
+  if (offset + size > regionOffset + m_frameSize) {
+    throw abcg::Exception{
+        abcg::Exception::Runtime("Stream buffer region is full")};
+  }
+  m_used = offset + size - regionOffset;
+
+  auto *regionData{m_persistent ? m_mapped + regionOffset : m_mapped};
+  return {regionData + (offset - regionOffset), offset, size};
+}
+
+/**
+ * @brief Makes the data written since beginFrame() visible to the GPU.
+ *
+ * Must be called before the commands that read the data.
+ */
+void abcg::StreamBuffer::endFrame() {
+  if (m_persistent) return;
+
+  glBindBuffer(m_target, m_buffer);
+#if defined(__EMSCRIPTEN__)
+  if (m_used > 0) {
+    glBufferSubData(m_target, static_cast<GLintptr>(m_region) * m_frameSize,
+                    m_used, m_shadow.data());
+  }
+#else
+  glFlushMappedBufferRange(m_target, 0, m_used);
+  glUnmapBuffer(m_target);
+  m_mapped = nullptr;
+#endif
+  glBindBuffer(m_target, 0);
+}
+
+/**
+ * @brief Releases the OpenGL resources of the stream buffer.
+ */
+void abcg::StreamBuffer::terminateGL() {
+  for (auto &fence : m_fences) {
+    if (fence != nullptr) abcg::glDeleteSync(fence);
+    fence = nullptr;
+  }
+
+  // Deleting the buffer also unmaps it
+  glDeleteBuffers(1, &m_buffer);
+
+  m_buffer = 0;
+  m_mapped = nullptr;
+  m_region = 0;
+  m_used = 0;
+  m_started = false;
+}
@@ -0,0 +1,91 @@
+/**
+ * @file abcg_streambuffer.hpp
+ * @brief abcg::StreamBuffer header file.
+ *
+ * Declaration of abcg::StreamBuffer class.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_STREAMBUFFER_HPP_
+#define ABCG_STREAMBUFFER_HPP_
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "abcg_openglfunctions.hpp"
+
+namespace abcg {
+class StreamBuffer;
+}  // namespace abcg
+
+/**
+ * @brief abcg::StreamBuffer class.
+ *
+ * Ring buffer for data written by the CPU once per frame, such as instance
+ * attributes.
+ *
+ * The buffer is divided into three regions, one per frame in flight. Every
+ * frame, the application calls beginFrame(), writes its data through the
+ * pointers returned by allocate(), then calls endFrame() before the draw
+ * calls that read the data.
+ *
+ * beginFrame() places a fence after the commands issued since its previous
+ * call, which include the draws of the previous frame, and then moves to the
+ * next region. It only waits on the fence of that region, which was placed
+ * three frames earlier. Uploads thus never stall while the GPU is at most two
+ * frames behind.
+ *
+ * - On OpenGL 4.4, or with `GL_ARB_buffer_storage`, the buffer is created
+ * with `glBufferStorage` and stays mapped (`GL_MAP_PERSISTENT_BIT |
+ * GL_MAP_COHERENT_BIT`), so writes need no further OpenGL call.
+ * - Otherwise (e.g. OpenGL 4.1 on macOS), the region of the frame is mapped
+ * with `glMapBufferRange` and `GL_MAP_UNSYNCHRONIZED_BIT` in beginFrame() and
+ * unmapped in endFrame().
+ * - On WebGL 2.0, which cannot map buffers, data is written to a copy in
+ * client memory and sent with `glBufferSubData` in endFrame().
+ */
+class abcg::StreamBuffer {
+ public:
+  /**
+   * @brief Memory handed out by allocate().
+   *
+   * `data` is where the CPU writes, and `offset` is the position of the same
+   * bytes in the OpenGL buffer.
+   */
+  struct Allocation {
+    void *data{};
+    GLintptr offset{};
+    GLsizeiptr size{};
+  };
+
+  void initializeGL(GLenum target, GLsizeiptr frameSize);
+  void beginFrame();
+  Allocation allocate(GLsizeiptr size, GLsizeiptr alignment = 16);
+  void endFrame();
+  void terminateGL();
+
+  [[nodiscard]] GLuint getBuffer() const noexcept { return m_buffer; }
+  [[nodiscard]] bool isPersistent() const noexcept { return m_persistent; }
+
+ private:
+  static constexpr std::size_t m_numRegions{3};
+
+  GLenum m_target{};
+  GLuint m_buffer{};
+  GLsizeiptr m_frameSize{};
+  bool m_persistent{};
+
+  // Start of the buffer when persistently mapped, or of the current region
+  std::byte *m_mapped{};
+  // Client copy of the current region when buffers cannot be mapped
+  std::vector<std::byte> m_shadow;
+
+  std::array<GLsync, m_numRegions> m_fences{};
+  std::size_t m_region{};
+  GLsizeiptr m_used{};
+  bool m_started{};
+};
+
+#endif
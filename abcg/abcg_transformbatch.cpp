@@ -0,0 +1,307 @@
+/**
+ * @file abcg_transformbatch.cpp
+ * @brief Definition of abcg::TransformBatch class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_transformbatch.hpp"
+
+#include <array>
+
+#if defined(__SSE__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define ABCG_TRANSFORMBATCH_SSE
+#include <xmmintrin.h>
+#endif
+
+#if defined(ABCG_TRANSFORMBATCH_SSE)
+namespace {
+
+// Four floats per element, e.g. a matrix column of four transforms
+struct Vec4 {
+  __m128 x;
+  __m128 y;
+  __m128 z;
+  __m128 w;
+};
+
+// Rows of a matrix, with each element in all lanes
+std::array<Vec4, 4> broadcastRows(const glm::mat4 &matrix) {
+  std::array<Vec4, 4> rows{};
+  for (glm::length_t row{}; row < 4; ++row) {
+    rows.at(static_cast<std::size_t>(row)) = {
+        _mm_set1_ps(matrix[0][row]), _mm_set1_ps(matrix[1][row]),
+        _mm_set1_ps(matrix[2][row]), _mm_set1_ps(matrix[3][row])};
+  }
+  return rows;
+}
+
+// Dot product of a row with the vectors (x, y, z, w) of four transforms
+__m128 dot(const Vec4 &row, __m128 x, __m128 y, __m128 z, __m128 w) {
+  auto result{_mm_mul_ps(row.x, x)};
+  result = _mm_add_ps(result, _mm_mul_ps(row.y, y));
+  result = _mm_add_ps(result, _mm_mul_ps(row.z, z));
+  return _mm_add_ps(result, _mm_mul_ps(row.w, w));
+}
+
+// Matrix times the vectors (x, y, z, w) of four transforms
+Vec4 transform(const std::array<Vec4, 4> &rows, __m128 x, __m128 y, __m128 z,
+               __m128 w) {
+  return {dot(rows[0], x, y, z, w), dot(rows[1], x, y, z, w),
+          dot(rows[2], x, y, z, w), dot(rows[3], x, y, z, w)};
+}
+
+// Stores the same column of four consecutive matrices
+void storeColumn(glm::mat4 *matrices, glm::length_t column, Vec4 v) {
+  _MM_TRANSPOSE4_PS(v.x, v.y, v.z, v.w);
+  _mm_storeu_ps(&matrices[0][column][0], v.x);
+  _mm_storeu_ps(&matrices[1][column][0], v.y);
+  _mm_storeu_ps(&matrices[2][column][0], v.z);
+  _mm_storeu_ps(&matrices[3][column][0], v.w);
+}
+
+// Stores the same column of four consecutive 3x3 matrices
+void storeColumn(glm::mat3 *matrices, glm::length_t column, Vec4 v) {
+  _MM_TRANSPOSE4_PS(v.x, v.y, v.z, v.w);
+  alignas(16) std::array<float, 16> elements{};
+  _mm_store_ps(&elements[0], v.x);
+  _mm_store_ps(&elements[4], v.y);
+  _mm_store_ps(&elements[8], v.z);
+  _mm_store_ps(&elements[12], v.w);
+  for (std::size_t lane{}; lane < 4; ++lane) {
+    matrices[lane][column] = {
+        elements.at(lane * 4), elements.at(lane * 4 + 1),
+        elements.at(lane * 4 + 2)};
+  }
+}
+
+}  // namespace
+#endif
+
+/**
+ * @brief Adds a transform.
+ *
+ * Its matrices are computed by the next call to update().
+ *
+ * @param translation Translation.
+ * @param rotation Unit quaternion of the rotation.
+ * @param scale Scale factor along each axis. Must not be zero.
+ * @return Index of the transform.
+ */
+std::size_t abcg::TransformBatch::add(const glm::vec3 &translation,
+                                      const glm::quat &rotation,
+                                      const glm::vec3 &scale) {
+  m_tx.push_back(translation.x);
+  m_ty.push_back(translation.y);
+  m_tz.push_back(translation.z);
+  m_qx.push_back(rotation.x);
+  m_qy.push_back(rotation.y);
+  m_qz.push_back(rotation.z);
+  m_qw.push_back(rotation.w);
+  m_sx.push_back(scale.x);
+  m_sy.push_back(scale.y);
+  m_sz.push_back(scale.z);
+
+  m_modelMatrices.emplace_back(1.0f);
+  m_modelViewMatrices.emplace_back(1.0f);
+  m_modelViewProjMatrices.emplace_back(1.0f);
+  m_normalMatrices.emplace_back(1.0f);
+
+  return m_tx.size() - 1;
+}
+
+/**
+ * @brief Removes every transform.
+ */
+void abcg::TransformBatch::clear() noexcept {
+  for (auto *component : {&m_tx, &m_ty, &m_tz, &m_qx, &m_qy, &m_qz, &m_qw,
+                          &m_sx, &m_sy, &m_sz}) {
+    component->clear();
+  }
+  m_modelMatrices.clear();
+  m_modelViewMatrices.clear();
+  m_modelViewProjMatrices.clear();
+  m_normalMatrices.clear();
+}
+
+/**
+ * @brief Computes the matrices of every transform.
+ *
+ * When SSE is available, four transforms are computed at a time. Otherwise,
+ * and for the remaining transforms, each transform is computed with glm.
+ *
+ * @param viewMatrix View matrix.
+ * @param projMatrix Projection matrix.
+ */
+void abcg::TransformBatch::update(const glm::mat4 &viewMatrix,
+                                  const glm::mat4 &projMatrix) {
+  const auto viewProjMatrix{projMatrix * viewMatrix};
+  std::size_t index{};
+
+#if defined(ABCG_TRANSFORMBATCH_SSE)
+  const auto view{broadcastRows(viewMatrix)};
+  const auto viewProj{broadcastRows(viewProjMatrix)};
+  const auto zero{_mm_setzero_ps()};
+  const auto one{_mm_set1_ps(1.0f)};
+  const auto two{_mm_set1_ps(2.0f)};
+
+  for (; index + 4 <= m_tx.size(); index += 4) {
+    const auto qx{_mm_loadu_ps(&m_qx[index])};
+    const auto qy{_mm_loadu_ps(&m_qy[index])};
+    const auto qz{_mm_loadu_ps(&m_qz[index])};
+    const auto qw{_mm_loadu_ps(&m_qw[index])};
+
+    // Rotation matrix of the quaternions, as in glm::mat3_cast, with each
+    // column multiplied by its scale. The w component holds the scale.
+    const auto xx{_mm_mul_ps(qx, qx)};
+    const auto yy{_mm_mul_ps(qy, qy)};
+    const auto zz{_mm_mul_ps(qz, qz)};
+    const auto xy{_mm_mul_ps(qx, qy)};
+    const auto xz{_mm_mul_ps(qx, qz)};
+    const auto yz{_mm_mul_ps(qy, qz)};
+    const auto wx{_mm_mul_ps(qw, qx)};
+    const auto wy{_mm_mul_ps(qw, qy)};
+    const auto wz{_mm_mul_ps(qw, qz)};
+    std::array<Vec4, 3> model{{
+        {_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))),
+         _mm_mul_ps(two, _mm_add_ps(xy, wz)),
+         _mm_mul_ps(two, _mm_sub_ps(xz, wy)), _mm_loadu_ps(&m_sx[index])},
+        {_mm_mul_ps(two, _mm_sub_ps(xy, wz)),
+         _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))),
+         _mm_mul_ps(two, _mm_add_ps(yz, wx)), _mm_loadu_ps(&m_sy[index])},
+        {_mm_mul_ps(two, _mm_add_ps(xz, wy)),
+         _mm_mul_ps(two, _mm_sub_ps(yz, wx)),
+         _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))),
+         _mm_loadu_ps(&m_sz[index])},
+    }};
+
+    for (glm::length_t column{}; column < 3; ++column) {
+      auto &[x, y, z, scale]{model.at(static_cast<std::size_t>(column))};
+      x = _mm_mul_ps(x, scale);
+      y = _mm_mul_ps(y, scale);
+      z = _mm_mul_ps(z, scale);
+
+      const auto modelView{transform(view, x, y, z, zero)};
+      storeColumn(&m_modelMatrices[index], column, {x, y, z, zero});
+      storeColumn(&m_modelViewMatrices[index], column, modelView);
+      storeColumn(&m_modelViewProjMatrices[index], column,
+                  transform(viewProj, x, y, z, zero));
+
+      // The normal matrix is the model-view matrix with the column divided
+      // by the square of the scale
+      const auto invScale2{_mm_div_ps(one, _mm_mul_ps(scale, scale))};
+      storeColumn(&m_normalMatrices[index], column,
+                  {_mm_mul_ps(modelView.x, invScale2),
+                   _mm_mul_ps(modelView.y, invScale2),
+                   _mm_mul_ps(modelView.z, invScale2), zero});
+    }
+
+    const auto tx{_mm_loadu_ps(&m_tx[index])};
+    const auto ty{_mm_loadu_ps(&m_ty[index])};
+    const auto tz{_mm_loadu_ps(&m_tz[index])};
+    storeColumn(&m_modelMatrices[index], 3, {tx, ty, tz, one});
+    storeColumn(&m_modelViewMatrices[index], 3,
+                transform(view, tx, ty, tz, one));
+    storeColumn(&m_modelViewProjMatrices[index], 3,
+                transform(viewProj, tx, ty, tz, one));
+  }
+#endif
+
+  for (; index < m_tx.size(); ++index) {
+    updateTransform(index, viewMatrix, viewProjMatrix);
+  }
+}
+
+/**
+ * @brief Sets the translation of a transform.
+ *
+ * @param index Index of the transform.
+ * @param translation Translation.
+ */
+void abcg::TransformBatch::setTranslation(std::size_t index,
+                                          const glm::vec3 &translation) {
+  m_tx.at(index) = translation.x;
+  m_ty.at(index) = translation.y;
+  m_tz.at(index) = translation.z;
+}
+
+/**
+ * @brief Sets the rotation of a transform.
+ *
+ * @param index Index of the transform.
+ * @param rotation Unit quaternion of the rotation.
+ */
+void abcg::TransformBatch::setRotation(std::size_t index,
+                                       const glm::quat &rotation) {
+  m_qx.at(index) = rotation.x;
+  m_qy.at(index) = rotation.y;
+  m_qz.at(index) = rotation.z;
+  m_qw.at(index) = rotation.w;
+}
+
+/**
+ * @brief Sets the scale of a transform.
+ *
+ * @param index Index of the transform.
+ * @param scale Scale factor along each axis. Must not be zero.
+ */
+void abcg::TransformBatch::setScale(std::size_t index,
+                                    const glm::vec3 &scale) {
+  m_sx.at(index) = scale.x;
+  m_sy.at(index) = scale.y;
+  m_sz.at(index) = scale.z;
+}
+
+/**
+ * @brief Returns the translation of a transform.
+ *
+ * @param index Index of the transform.
+ * @return Translation.
+ */
+glm::vec3 abcg::TransformBatch::getTranslation(std::size_t index) const {
+  return {m_tx.at(index), m_ty.at(index), m_tz.at(index)};
+}
+
+/**
+ * @brief Returns the rotation of a transform.
+ *
+ * @param index Index of the transform.
+ * @return Unit quaternion of the rotation.
+ */
+glm::quat abcg::TransformBatch::getRotation(std::size_t index) const {
+  return {m_qw.at(index), m_qx.at(index), m_qy.at(index), m_qz.at(index)};
+}
+
+/**
+ * @brief Returns the scale of a transform.
+ *
+ * @param index Index of the transform.
+ * @return Scale factor along each axis.
+ */
+glm::vec3 abcg::TransformBatch::getScale(std::size_t index) const {
+  return {m_sx.at(index), m_sy.at(index), m_sz.at(index)};
+}
+
+// Computes the matrices of a single transform with glm
+void abcg::TransformBatch::updateTransform(std::size_t index,
+                                           const glm::mat4 &viewMatrix,
+                                           const glm::mat4 &viewProjMatrix) {
+  const auto scale{getScale(index)};
+  glm::mat4 modelMatrix{glm::mat3_cast(getRotation(index))};
+  modelMatrix[0] *= scale.x;
+  modelMatrix[1] *= scale.y;
+  modelMatrix[2] *= scale.z;
+  modelMatrix[3] = glm::vec4(getTranslation(index), 1.0f);
+
+  const auto modelViewMatrix{viewMatrix * modelMatrix};
+  glm::mat3 normalMatrix{modelViewMatrix};
+  normalMatrix[0] /= scale.x * scale.x;
+  normalMatrix[1] /= scale.y * scale.y;
+  normalMatrix[2] /= scale.z * scale.z;
+
+  m_modelMatrices[index] = modelMatrix;
+  m_modelViewMatrices[index] = modelViewMatrix;
+  m_modelViewProjMatrices[index] = viewProjMatrix * modelMatrix;
+  m_normalMatrices[index] = normalMatrix;
+}
@@ -0,0 +1,98 @@
+/**
+ * @file abcg_transformbatch.hpp
+ * @brief abcg::TransformBatch header file.
+ *
+ * Declaration of abcg::TransformBatch class.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_TRANSFORMBATCH_HPP_
+#define ABCG_TRANSFORMBATCH_HPP_
+
+#include <cstddef>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/mat3x3.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <vector>
+
+namespace abcg {
+class TransformBatch;
+}  // namespace abcg
+
+/**
+ * @brief abcg::TransformBatch class.
+ *
+ * Translation, rotation and scale (TRS) of many objects, stored per
+ * component in separate arrays, and the matrices derived from them.
+ *
+ * Once per frame, update() computes for every transform the model matrix
+ * `T * R * S`, the model-view matrix, the model-view-projection matrix and the
+ * normal matrix, so that vertex shaders need no matrix products of their own.
+ *
+ * The normal matrix is the inverse transpose of the upper 3x3 part of the
+ * model-view matrix. As the rotations are orthonormal, it is computed without
+ * an inverse, as that part with each column divided by the square of the
+ * scale along its axis. For a uniform scale, this is a multiple of the
+ * model-view matrix. This assumes a
+ * view matrix made of a rotation, a translation and at most a uniform scale,
+ * such as the one of `glm::lookAt`. A uniform scale of the view only changes
+ * the length of the normals.
+ *
+ * When SSE is available, four transforms are computed at a time.
+ */
+class abcg::TransformBatch {
+ public:
+  std::size_t add(const glm::vec3 &translation = glm::vec3{0.0f},
+                  const glm::quat &rotation = glm::quat{1.0f, 0.0f, 0.0f,
+                                                        0.0f},
+                  const glm::vec3 &scale = glm::vec3{1.0f});
+  void clear() noexcept;
+  void update(const glm::mat4 &viewMatrix, const glm::mat4 &projMatrix);
+
+  void setTranslation(std::size_t index, const glm::vec3 &translation);
+  void setRotation(std::size_t index, const glm::quat &rotation);
+  void setScale(std::size_t index, const glm::vec3 &scale);
+  [[nodiscard]] glm::vec3 getTranslation(std::size_t index) const;
+  [[nodiscard]] glm::quat getRotation(std::size_t index) const;
+  [[nodiscard]] glm::vec3 getScale(std::size_t index) const;
+
+  [[nodiscard]] const glm::mat4 &getModelMatrix(std::size_t index) const {
+    return m_modelMatrices.at(index);
+  }
+  [[nodiscard]] const glm::mat4 &getModelViewMatrix(std::size_t index) const {
+    return m_modelViewMatrices.at(index);
+  }
+  [[nodiscard]] const glm::mat4 &getModelViewProjMatrix(
+      std::size_t index) const {
+    return m_modelViewProjMatrices.at(index);
+  }
+  [[nodiscard]] const glm::mat3 &getNormalMatrix(std::size_t index) const {
+    return m_normalMatrices.at(index);
+  }
+  [[nodiscard]] std::size_t size() const noexcept { return m_tx.size(); }
+
+ private:
+  void updateTransform(std::size_t index, const glm::mat4 &viewMatrix,
+                       const glm::mat4 &viewProjMatrix);
+
+  // Components of the translations, rotations (quaternions) and scales
+  std::vector<float> m_tx;
+  std::vector<float> m_ty;
+  std::vector<float> m_tz;
+  std::vector<float> m_qx;
+  std::vector<float> m_qy;
+  std::vector<float> m_qz;
+  std::vector<float> m_qw;
+  std::vector<float> m_sx;
+  std::vector<float> m_sy;
+  std::vector<float> m_sz;
+
+  std::vector<glm::mat4> m_modelMatrices;
+  std::vector<glm::mat4> m_modelViewMatrices;
+  std::vector<glm::mat4> m_modelViewProjMatrices;
+  std::vector<glm::mat3> m_normalMatrices;
+};
+
+#endif
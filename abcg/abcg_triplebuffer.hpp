@@ -0,0 +1,102 @@
+/**
+ * @file abcg_triplebuffer.hpp
+ * @brief abcg::TripleBuffer header file.
+ *
+ * Declaration and definition of abcg::TripleBuffer class template.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_TRIPLEBUFFER_HPP_
+#define ABCG_TRIPLEBUFFER_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace abcg {
+template <typename T>
+class TripleBuffer;
+}  // namespace abcg
+
+/**
+ * @brief abcg::TripleBuffer class template.
+ *
+ * Lock-free exchange of snapshots of a value from one writer thread to one
+ * reader thread.
+ *
+ * The writer fills the buffer returned by getWriteBuffer() and calls
+ * publish(). The reader calls update() to take the most recently published
+ * snapshot, if any, and reads it with getReadBuffer() for as long as it
+ * needs. Neither thread ever waits for the other: the third buffer holds the
+ * latest snapshot between them, and snapshots the reader had no time to take
+ * are skipped.
+ *
+ * The write buffer holds an old snapshot after publish(), so the writer must
+ * fill every member of it again before the next publish().
+ *
+ * @tparam T Type of the snapshot.
+ */
+template <typename T>
+class abcg::TripleBuffer {
+ public:
+  /**
+   * @brief Returns the buffer to be filled by the writer.
+   *
+   * @return Reference to the write buffer.
+   */
+  [[nodiscard]] T &getWriteBuffer() noexcept { return m_buffers[m_write]; }
+
+  /**
+   * @brief Makes the write buffer the latest snapshot.
+   *
+   * Called by the writer. The write buffer is then swapped with the one that
+   * held the previous snapshot, if the reader did not take it.
+   */
+  void publish() noexcept {
+    const auto fresh{static_cast<std::uint8_t>(m_write | m_freshBit)};
+    m_write = static_cast<std::uint8_t>(
+        m_latest.exchange(fresh, std::memory_order_acq_rel) & m_indexMask);
+  }
+
+  /**
+   * @brief Takes the latest snapshot, if one was published since the last
+   * call.
+   *
+   * Called by the reader.
+   *
+   * @return Whether the read buffer changed.
+   */
+  bool update() noexcept {
+    if ((m_latest.load(std::memory_order_relaxed) & m_freshBit) == 0) {
+      return false;
+    }
+    m_read = static_cast<std::uint8_t>(
+        m_latest.exchange(m_read, std::memory_order_acq_rel) & m_indexMask);
+    return true;
+  }
+
+  /**
+   * @brief Returns the snapshot taken by the last call to update().
+   *
+   * @return Reference to the read buffer.
+   */
+  [[nodiscard]] const T &getReadBuffer() const noexcept {
+    return m_buffers[m_read];
+  }
+
+ private:
+  static constexpr std::uint8_t m_indexMask{0x3};
+  static constexpr std::uint8_t m_freshBit{0x4};
+
+  std::array<T, 3> m_buffers{};
+
+  // Index of the buffer of each thread, and of the buffer in between, whose
+  // fresh bit tells whether it holds a snapshot the reader did not take. They
+  // are kept on separate cache lines.
+  alignas(64) std::uint8_t m_write{0};
+  alignas(64) std::atomic<std::uint8_t> m_latest{1};
+  alignas(64) std::uint8_t m_read{2};
+};
+
+#endif
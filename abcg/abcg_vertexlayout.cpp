@@ -0,0 +1,151 @@
+/**
+ * @file abcg_vertexlayout.cpp
+ * @brief Definition of abcg::VertexLayout class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_vertexlayout.hpp"
+
+#include <algorithm>
+
+/**
+ * @brief Declares the format of the layout.
+ *
+ * Any previously created OpenGL resources of the layout are released first.
+ *
+ * @param attributes Attributes of the layout.
+ * @param bindings Stride and divisor of each binding used by the attributes.
+ */
+void abcg::VertexLayout::initializeGL(std::span<const Attribute> attributes,
+                                      std::span<const Binding> bindings) {
+  terminateGL();
+
+  m_attributes.assign(attributes.begin(), attributes.end());
+  m_bindings.assign(bindings.begin(), bindings.end());
+
+#if defined(__EMSCRIPTEN__)
+  m_separate = false;
+#else
+  m_separate = GLEW_VERSION_4_3 || GLEW_ARB_vertex_attrib_binding;
+  if (!m_separate) return;
+
+  auto &vertexArray{m_vertexArrays.emplace_back()};
+  vertexArray.buffers.resize(m_bindings.size());
+  vertexArray.offsets.resize(m_bindings.size());
+
+  glGenVertexArrays(1, &vertexArray.VAO);
+  glBindVertexArray(vertexArray.VAO);
+  for (const auto &attribute : m_attributes) {
+    glEnableVertexAttribArray(attribute.location);
+    glVertexAttribFormat(attribute.location, attribute.size, GL_FLOAT,
+                         GL_FALSE, static_cast<GLuint>(attribute.offset));
+    glVertexAttribBinding(attribute.location, attribute.binding);
+  }
+  for (GLuint binding{}; binding < m_bindings.size(); ++binding) {
+    glVertexBindingDivisor(binding, m_bindings[binding].divisor);
+  }
+  glBindVertexArray(0);
+#endif
+}
+
+/**
+ * @brief Binds a VAO that reads the layout from the given buffers.
+ *
+ * The VAO is left bound.
+ *
+ * @param buffers Buffer attached to each binding.
+ * @param offsets Byte offset of the first element of each buffer.
+ * @param indexBuffer Buffer bound to `GL_ELEMENT_ARRAY_BUFFER`.
+ * @return Name of the bound VAO.
+ */
+GLuint abcg::VertexLayout::bind(std::span<const GLuint> buffers,
+                                std::span<const GLintptr> offsets,
+                                GLuint indexBuffer) {
+#if !defined(__EMSCRIPTEN__)
+  if (m_separate) {
+    auto &vertexArray{m_vertexArrays.front()};
+    glBindVertexArray(vertexArray.VAO);
+    for (std::size_t binding{}; binding < m_bindings.size(); ++binding) {
+      if (buffers[binding] == vertexArray.buffers[binding] &&
+          offsets[binding] == vertexArray.offsets[binding]) {
+        continue;
+      }
+      glBindVertexBuffer(static_cast<GLuint>(binding), buffers[binding],
+                         offsets[binding], m_bindings[binding].stride);
+      vertexArray.buffers[binding] = buffers[binding];
+      vertexArray.offsets[binding] = offsets[binding];
+    }
+    if (indexBuffer != vertexArray.indexBuffer) {
+      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+      vertexArray.indexBuffer = indexBuffer;
+    }
+    return vertexArray.VAO;
+  }
+#endif
+
+  const auto iter{std::find_if(
+      m_vertexArrays.begin(), m_vertexArrays.end(),
+      [&](const VertexArray &vertexArray) {
+        return vertexArray.indexBuffer == indexBuffer &&
+               std::equal(buffers.begin(), buffers.end(),
+                          vertexArray.buffers.begin()) &&
+               std::equal(offsets.begin(), offsets.end(),
+                          vertexArray.offsets.begin());
+      })};
+  if (iter != m_vertexArrays.end()) {
+    glBindVertexArray(iter->VAO);
+    return iter->VAO;
+  }
+  return createVertexArray(buffers, offsets, indexBuffer);
+}
+
+/**
+ * @brief Releases the VAOs of the layout.
+ *
+ * The buffers given to bind() are not deleted.
+ */
+void abcg::VertexLayout::terminateGL() {
+  for (auto &vertexArray : m_vertexArrays) {
+    glDeleteVertexArrays(1, &vertexArray.VAO);
+  }
+  m_vertexArrays.clear();
+}
+
+/**
+ * @brief Returns the number of VAOs created by the layout.
+ *
+ * @return One with the separate format, or the number of distinct sets of
+ * buffers used so far otherwise.
+ */
+std::size_t abcg::VertexLayout::getNumVAOs() const noexcept {
+  return m_vertexArrays.size();
+}
+
+// Creates and binds a VAO for a new set of buffers in the fallback path
+GLuint abcg::VertexLayout::createVertexArray(std::span<const GLuint> buffers,
+                                             std::span<const GLintptr> offsets,
+                                             GLuint indexBuffer) {
+  auto &vertexArray{m_vertexArrays.emplace_back()};
+  vertexArray.buffers.assign(buffers.begin(), buffers.end());
+  vertexArray.offsets.assign(offsets.begin(), offsets.end());
+  vertexArray.indexBuffer = indexBuffer;
+
+  glGenVertexArrays(1, &vertexArray.VAO);
+  glBindVertexArray(vertexArray.VAO);
+  for (const auto &attribute : m_attributes) {
+    const auto &binding{m_bindings.at(attribute.binding)};
+    const auto offset{static_cast<std::size_t>(offsets[attribute.binding]) +
+                      attribute.offset};
+    glBindBuffer(GL_ARRAY_BUFFER, buffers[attribute.binding]);
+    glEnableVertexAttribArray(attribute.location);
+    glVertexAttribPointer(attribute.location, attribute.size, GL_FLOAT,
+                          GL_FALSE, binding.stride,
+                          reinterpret_cast<void *>(offset));
+    glVertexAttribDivisor(attribute.location, binding.divisor);
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+
+  return vertexArray.VAO;
+}
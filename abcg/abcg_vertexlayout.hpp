@@ -0,0 +1,98 @@
+/**
+ * @file abcg_vertexlayout.hpp
+ * @brief abcg::VertexLayout header file.
+ *
+ * Declaration of abcg::VertexLayout class.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_VERTEXLAYOUT_HPP_
+#define ABCG_VERTEXLAYOUT_HPP_
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "abcg_openglfunctions.hpp"
+
+namespace abcg {
+class VertexLayout;
+}  // namespace abcg
+
+/**
+ * @brief abcg::VertexLayout class.
+ *
+ * Format of the vertex attributes declared once, and the buffers they are
+ * read from given separately.
+ *
+ * Attributes are read from numbered buffer bindings. Each binding has a
+ * stride and a divisor, and bind() attaches a buffer and a byte offset to
+ * each binding:
+ *
+ * - On OpenGL 4.3, or with `GL_ARB_vertex_attrib_binding`, the layout has a
+ * single VAO. Its format is specified once with `glVertexAttribFormat` and
+ * `glVertexAttribBinding`, and bind() only calls `glBindVertexBuffer` for the
+ * bindings that changed.
+ * - Otherwise (e.g. OpenGL 4.1 on macOS, and WebGL 2.0), bind() keeps one VAO
+ * per distinct set of buffers and offsets, specified with
+ * `glVertexAttribPointer` when the set is first used and only bound after
+ * that.
+ *
+ * In both cases, switching between sets of buffers never specifies the
+ * attributes again.
+ */
+class abcg::VertexLayout {
+ public:
+  /**
+   * @brief Vertex attribute of floats.
+   */
+  struct Attribute {
+    GLuint location{};
+    GLint size{};
+    std::size_t offset{};
+    GLuint binding{};
+  };
+
+  /**
+   * @brief Layout of the buffer attached to a binding.
+   *
+   * A zero divisor advances the attributes once per vertex. Otherwise they
+   * advance once every `divisor` instances.
+   */
+  struct Binding {
+    GLsizei stride{};
+    GLuint divisor{};
+  };
+
+  void initializeGL(std::span<const Attribute> attributes,
+                    std::span<const Binding> bindings);
+  GLuint bind(std::span<const GLuint> buffers,
+              std::span<const GLintptr> offsets, GLuint indexBuffer);
+  void terminateGL();
+
+  [[nodiscard]] bool isSeparate() const noexcept { return m_separate; }
+  [[nodiscard]] std::size_t getNumVAOs() const noexcept;
+
+ private:
+  // Buffers attached to the bindings of a VAO
+  struct VertexArray {
+    GLuint VAO{};
+    std::vector<GLuint> buffers;
+    std::vector<GLintptr> offsets;
+    GLuint indexBuffer{};
+  };
+
+  GLuint createVertexArray(std::span<const GLuint> buffers,
+                           std::span<const GLintptr> offsets,
+                           GLuint indexBuffer);
+
+  std::vector<Attribute> m_attributes;
+  std::vector<Binding> m_bindings;
+  bool m_separate{};
+
+  // The single VAO of the separate format, or one VAO per set of buffers
+  std::vector<VertexArray> m_vertexArrays;
+};
+
+#endif
@@ -0,0 +1,14 @@
+#version 410
+
+layout(location = 0) in vec2 inPosition;
+
+// Per-instance attributes
+layout(location = 1) in vec2 inTranslation;
+layout(location = 2) in vec4 inColor;
+
+out vec4 fragColor;
+
+void main() {
+  gl_Position = vec4(inPosition.xy + inTranslation, 0, 1);
+  fragColor = inColor;
+}
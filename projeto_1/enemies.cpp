@@ -5,15 +5,30 @@
 
 void Enemies::initializeGL(GLuint program, int quantity) {
   terminateGL();
-  // Start pseudo-random number generator
-  m_randomEngine.seed(
-    std::chrono::steady_clock::now().time_since_epoch().count());
 
   auto &re{m_randomEngine}; // Shortcut
 
   m_program = program;
-  m_colorLoc = abcg::glGetUniformLocation(m_program, "color");
-  m_translationLoc = abcg::glGetUniformLocation(m_program, "translation");
+
+  // Array of vertices
+  const std::array<glm::vec2, 8> positions{
+      // Enemy body
+      glm::vec2{-0.10f, +0.15f}, glm::vec2{+0.10f, +0.15f},
+      glm::vec2{-0.10f, -0.15f}, glm::vec2{+0.10f, -0.15f},
+
+      glm::vec2{-0.07f, +0.20f}, glm::vec2{+0.07f, +0.20f},
+      glm::vec2{-0.07f, -0.22f}, glm::vec2{+0.07f, -0.22f},
+      };
+
+  const std::array<GLuint, 6 * 3> indices{0, 1, 2,
+                                          1, 2, 3,
+                                          0, 4, 1,
+                                          1, 4, 5,
+                                          2, 6, 7,
+                                          7, 2, 3};
+
+  // Create the geometry shared by all enemies
+  m_batch.initializeGL(m_program, positions, indices);
 
   // Create enemy cars
   m_enemies.clear();
@@ -37,24 +52,17 @@ void Enemies::initializeGL(GLuint program, int quantity) {
 void Enemies::paintGL() {
   abcg::glUseProgram(m_program);
 
+  m_batch.clear();
   for (const auto &enemy : m_enemies) {
-    abcg::glBindVertexArray(enemy.m_vao);
-
-    abcg::glUniform4fv(m_colorLoc, 1, &enemy.m_color.r);
-
-    abcg::glUniform2f(m_translationLoc, enemy.m_translation.x, enemy.m_translation.y);
-
-    abcg::glDrawElements(GL_TRIANGLES, 3 * 6, GL_UNSIGNED_INT, nullptr);
-    abcg::glBindVertexArray(0);
+    m_batch.add(enemy.m_translation, enemy.m_color);
   }
+  m_batch.draw();
+
   abcg::glUseProgram(0);
 }
 
 void Enemies::terminateGL() {
-  for (auto enemy : m_enemies) {
-    abcg::glDeleteBuffers(1, &enemy.m_vbo);
-    abcg::glDeleteVertexArrays(1, &enemy.m_vao);
-  }
+  m_batch.terminateGL();
 }
 
 void Enemies::update(const GameData &gameData, float deltaTime) {
@@ -93,58 +101,5 @@ Enemies::Enemy Enemies::createEnemy(glm::vec2 translation) {
   //std::uniform_real_distribution<float> randomX(-1.0f, +1.0f);
   enemy.m_translation = translation;
 
-  // Create geometry
-
-  // Array of vertices
-  std::array<glm::vec2, 12> positions{
-      // Player body
-      glm::vec2{-0.10f, +0.15f}, glm::vec2{+0.10f, +0.15f},
-      glm::vec2{-0.10f, -0.15f}, glm::vec2{+0.10f, -0.15f},
-
-      glm::vec2{-0.07f, +0.20f}, glm::vec2{+0.07f, +0.20f},
-      glm::vec2{-0.07f, -0.22f}, glm::vec2{+0.07f, -0.22f},
-      };
-
-  const std::array<int, 6 * 3> indices{0, 1, 2,
-                                       1, 2, 3,
-                                       0, 4, 1,
-                                       1, 4, 5,
-                                       2, 6, 7,
-                                       7, 2, 3};
-
-  // Generate VBOs
-  abcg::glGenBuffers(1, &enemy.m_vbo);
-  abcg::glBindBuffer(GL_ARRAY_BUFFER, enemy.m_vbo);
-  abcg::glBufferData(GL_ARRAY_BUFFER, sizeof(positions), positions.data(),
-                     GL_STATIC_DRAW);
-  abcg::glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-  // Generate EBO
-  abcg::glGenBuffers(1, &enemy.m_ebo);
-  abcg::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, enemy.m_ebo);
-  abcg::glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices.data(),
-                     GL_STATIC_DRAW);
-  abcg::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
-  // Get location of attributes in the program
-  GLint positionAttribute{abcg::glGetAttribLocation(m_program, "inPosition")};
-
-  // Create VAO
-  abcg::glGenVertexArrays(1, &enemy.m_vao);
-
-  // Bind vertex attributes to current VAO
-  abcg::glBindVertexArray(enemy.m_vao);
-
-  abcg::glEnableVertexAttribArray(positionAttribute);
-  abcg::glBindBuffer(GL_ARRAY_BUFFER, enemy.m_vbo);
-  abcg::glVertexAttribPointer(positionAttribute, 2, GL_FLOAT, GL_FALSE, 0,
-                              nullptr);
-  abcg::glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-  abcg::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, enemy.m_ebo);
-
-  // End of binding to current VAO
-  abcg::glBindVertexArray(0);
-
   return enemy;
 }
\ No newline at end of file
@@ -1,8 +1,7 @@
 #ifndef ENEMIES_HPP_
 #define ENEMIES_HPP_
 
-#include <list>
-#include <array>
+#include <vector>
 #include <random>
 
 #include "abcg.hpp"
@@ -22,20 +21,17 @@ class Enemies {
     friend OpenGLWindow;
 
     GLuint m_program{};
-    GLint m_colorLoc{};
-    GLint m_translationLoc{};
 
     struct Enemy {
-      GLuint m_vao{};
-      GLuint m_vbo{};
-      GLuint m_ebo{};
-
       glm::vec4 m_color{1};
       bool m_hit{false};
       glm::vec2 m_translation{glm::vec2(0)};
     };
     
-    std::list<Enemy> m_enemies;
+    std::vector<Enemy> m_enemies;
+
+    // Every enemy shares the same car shape, drawn with one instanced call
+    abcg::SpriteBatch m_batch;
 
     std::default_random_engine m_randomEngine;
     std::uniform_real_distribution<float> m_randomDist{-1.0f, 1.0f};
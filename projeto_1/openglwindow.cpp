@@ -53,15 +53,24 @@ void OpenGLWindow::initializeGL() {
   // Create program to render the other objects
   m_objectsProgram = createProgramFromFile(getAssetsPath() + "objects.vert", getAssetsPath() + "objects.frag");
 
+  // Create program to render the instanced objects (road and enemies)
+  m_instancedProgram = createProgramFromFile(getAssetsPath() + "instanced.vert", getAssetsPath() + "objects.frag");
+
   abcg::glClearColor(0, 0, 0, 1);
 
 #if !defined(__EMSCRIPTEN__)
   abcg::glEnable(GL_PROGRAM_POINT_SIZE);
 #endif
 
-  // Start pseudo-random number generator
+  // Start pseudo-random number generator. The seed comes from abcg, so that a
+  // replayed session draws the same numbers.
   m_randomEngine.seed(
-      std::chrono::steady_clock::now().time_since_epoch().count());
+      static_cast<std::default_random_engine::result_type>(getRandomSeed()));
+  // The enemies keep drawing from their generator across restarts, so that
+  // each game has a new layout
+  m_enemies.m_randomEngine.seed(
+      static_cast<std::default_random_engine::result_type>(getRandomSeed()) +
+      1);
 
   restart();
 }
@@ -71,12 +80,12 @@ void OpenGLWindow::restart() {
   // reset score
   m_gameData.gameScore = 0;
   m_gameData.gameSpeed = 1;
-  m_road.initializeGL(m_objectsProgram);
-  m_enemies.initializeGL(m_objectsProgram, 4);
+  m_road.initializeGL(m_instancedProgram);
+  m_enemies.initializeGL(m_instancedProgram, 4);
   m_player.initializeGL(m_objectsProgram);
 }
 
-void OpenGLWindow::update() {
+void OpenGLWindow::updateState() {
   float deltaTime{static_cast<float>(getDeltaTime())};
 
   // increase score
@@ -101,7 +110,7 @@ void OpenGLWindow::update() {
 }
 
 void OpenGLWindow::paintGL() {
-  update();
+  updateState();
   abcg::glClearColor(0.4, 0.4, 0.4, 1);
   abcg::glClear(GL_COLOR_BUFFER_BIT);
   abcg::glViewport(0, 0, m_viewportWidth, m_viewportHeight);
@@ -155,6 +164,7 @@ void OpenGLWindow::resizeGL(int width, int height) {
 
 void OpenGLWindow::terminateGL() {
   abcg::glDeleteProgram(m_objectsProgram);
+  abcg::glDeleteProgram(m_instancedProgram);
 
   m_road.terminateGL();
   m_enemies.terminateGL();
@@ -24,6 +24,7 @@ class OpenGLWindow : public abcg::OpenGLWindow {
 
  private:
   GLuint m_objectsProgram{};
+  GLuint m_instancedProgram{};
 
   int m_viewportWidth{};
   int m_viewportHeight{};
@@ -41,7 +42,7 @@ class OpenGLWindow : public abcg::OpenGLWindow {
   std::default_random_engine m_randomEngine;
 
   void restart();
-  void update();
+  void updateState();
 };
 
 #endif
\ No newline at end of file
@@ -19,12 +19,9 @@ class Road {
 
   private:
     GLuint m_program{};
-    GLint m_colorLoc{};
-    GLint m_translationLoc{};
 
-    GLuint m_vao{};
-    GLuint m_vbo{};
-    GLuint m_ebo{};
+    // Every road stripe shares the same quad, drawn with one instanced call
+    abcg::SpriteBatch m_batch;
 
     glm::vec4 m_color{1, 1, 0, 1};
     glm::vec2 m_translation{glm::vec2(0)};